@@ -1964,6 +1964,14 @@ class SDLMain implements Runnable {
             if (OptionStore.no_stretching)
                 params |= 0x40;
 
+            // check if frames should be rendered in 16-bit colour
+            if (OptionStore.rgb565_frames)
+                params |= 0x200;
+
+            // check if we should use the fast emulation profile
+            if (OptionStore.fast_profile)
+                params |= 0x800;
+
             // check if we should use cheat codes
             if (OptionStore.game_genie) {
                 if (CodesActivity.transferCodes != null && CodesActivity.transferCodes.length > 0)
@@ -24,6 +24,8 @@ public class OptionStore {
     static public boolean no_stretching;
     static public String default_path;
     static public boolean game_genie;
+    static public boolean rgb565_frames;
+    static public boolean fast_profile;
 
     static public void updateOptionsFromFile(String filePath) {
         File settingsFile = new File(filePath);
@@ -88,6 +90,18 @@ public class OptionStore {
                     } else {
                         OptionStore.game_genie = false;
                     }
+                } else if (setting[0].equals("rgb565_frames")) {
+                    if (setting[1].equals("1")) {
+                        OptionStore.rgb565_frames = true;
+                    } else {
+                        OptionStore.rgb565_frames = false;
+                    }
+                } else if (setting[0].equals("fast_profile")) {
+                    if (setting[1].equals("1")) {
+                        OptionStore.fast_profile = true;
+                    } else {
+                        OptionStore.fast_profile = false;
+                    }
                 }
             }
         }
@@ -102,6 +116,8 @@ public class OptionStore {
             OptionStore.no_stretching = false;
             OptionStore.default_path = "";
             OptionStore.game_genie = false;
+            OptionStore.rgb565_frames = false;
+            OptionStore.fast_profile = false;
         }
         catch (IOException e) {
             Log.e("OptionStore", "Problem reading settings file: " + e);
@@ -74,6 +74,8 @@ public class OptionsActivity extends Activity {
         ControllerCheckBox japanese_mode = (ControllerCheckBox)findViewById(R.id.japanese_mode);
         ControllerCheckBox no_stretching = (ControllerCheckBox)findViewById(R.id.no_stretching);
         ControllerCheckBox game_genie = (ControllerCheckBox)findViewById(R.id.game_genie);
+        ControllerCheckBox rgb565_frames = (ControllerCheckBox)findViewById(R.id.rgb565_frames);
+        ControllerCheckBox fast_profile = (ControllerCheckBox)findViewById(R.id.fast_profile);
         orientation_lock.setActiveDrawable(dark);
         disable_sound.setActiveDrawable(dark);
         larger_buttons.setActiveDrawable(dark);
@@ -81,6 +83,8 @@ public class OptionsActivity extends Activity {
         japanese_mode.setActiveDrawable(dark);
         no_stretching.setActiveDrawable(dark);
         game_genie.setActiveDrawable(dark);
+        rgb565_frames.setActiveDrawable(dark);
+        fast_profile.setActiveDrawable(dark);
 
         // Create selection object and add mappings to it.
         options_apply_button.isOptions();
@@ -92,6 +96,8 @@ public class OptionsActivity extends Activity {
         selectionObj.addMapping(japanese_mode);
         selectionObj.addMapping(no_stretching);
         selectionObj.addMapping(game_genie);
+        selectionObj.addMapping(rgb565_frames);
+        selectionObj.addMapping(fast_profile);
         selectionObj.addMapping(options_apply_button);
 
         // Set focus
@@ -137,6 +143,14 @@ public class OptionsActivity extends Activity {
             CheckBox game_genie = (CheckBox)findViewById(R.id.game_genie);
             game_genie.setChecked(true);
         }
+        if (OptionStore.rgb565_frames) {
+            CheckBox rgb565_frames = (CheckBox)findViewById(R.id.rgb565_frames);
+            rgb565_frames.setChecked(true);
+        }
+        if (OptionStore.fast_profile) {
+            CheckBox fast_profile = (CheckBox)findViewById(R.id.fast_profile);
+            fast_profile.setChecked(true);
+        }
 
         // make sure screen orientation is set here if locked
         if (OptionStore.orientation_lock) {
@@ -160,6 +174,8 @@ public class OptionsActivity extends Activity {
         CheckBox japanese_mode = (CheckBox)findViewById(R.id.japanese_mode);
         CheckBox no_stretching = (CheckBox)findViewById(R.id.no_stretching);
         CheckBox game_genie = (CheckBox)findViewById(R.id.game_genie);
+        CheckBox rgb565_frames = (CheckBox)findViewById(R.id.rgb565_frames);
+        CheckBox fast_profile = (CheckBox)findViewById(R.id.fast_profile);
         boolean errors = false;
 
         settings.append("orientation_lock=");
@@ -207,6 +223,16 @@ public class OptionsActivity extends Activity {
             settings.append("1\n");
         else
             settings.append("0\n");
+        settings.append("rgb565_frames=");
+        if (rgb565_frames.isChecked())
+            settings.append("1\n");
+        else
+            settings.append("0\n");
+        settings.append("fast_profile=");
+        if (fast_profile.isChecked())
+            settings.append("1\n");
+        else
+            settings.append("0\n");
 
 
         // define settings file
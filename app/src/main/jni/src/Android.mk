@@ -8,10 +8,23 @@ SDL_PATH := ../SDL-release-2.30.2
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/$(SDL_PATH)/include
 
-# Add your application source files here...
+# Add your application source files here - z80_fast.c builds z80.c a second time as the fast profile,
+# which the console uses in place of the default accurate one when the fast profile option is turned on
 LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	$(wildcard $(LOCAL_PATH)/MasterEmu-source/*.c)
 
+# Uncomment this to compile in the Z80 opcode profiler, which logs a report when the emulator shuts down
+# LOCAL_CFLAGS += -DZ80_PROFILER
+
+# Uncomment this to compile in the PC sampler, which writes a report of where the Z80 spends its time when the emulator shuts down
+# LOCAL_CFLAGS += -DCONSOLE_PC_SAMPLER
+
+# Uncomment this to compile in the Z80 instruction trace, which is written to z80_crash_trace.txt in internal
+# storage on a crash, and to the log the first time the address given by Z80_TRACE_TRIGGER is reached if that
+# is uncommented too
+# LOCAL_CFLAGS += -DZ80_TRACE
+# LOCAL_CFLAGS += -DZ80_TRACE_TRIGGER=0x0038
+
 LOCAL_SHARED_LIBRARIES := SDL2 SDL2_image
 
 LOCAL_LDLIBS := -lGLESv1_CM -lGLESv2 -llog
@@ -202,6 +202,70 @@ void cart_writeCartridge(Cartridge c, emuint address, emubyte data)
     }
 }
 
+/* this function returns a pointer to the byte that cart_readCartridge would return for
+   the specified address - the memory behind it stays valid until the banking registers
+   change, so the console can use it to build its memory map - NULL is returned if the
+   address isn't backed by ROM or RAM */
+emubyte *cart_getReadPage(Cartridge c, emuint address)
+{
+    /* define local variables */
+    emuint addressVal = address & 0xFFFF;
+
+    /* this mirrors the address decoding in cart_readCartridge */
+    if (addressVal <= 0x3FFF) {
+        if ((addressVal <= 0x3FF) && !c->isCodemasters)
+            return c->romBanks[0] + addressVal;
+        else
+            return c->romBanks[c->fffd] + addressVal;
+    } else if (addressVal <= 0x7FFF) {
+        return c->romBanks[c->fffe] + (addressVal - 16384);
+    } else if (addressVal <= 0xBFFF) {
+        if ((c->fffc & 0x08) == 8)
+            return c->ramBanks[(c->fffc >> 2) & 0x01] + (addressVal - 32768);
+        else
+            return c->romBanks[c->ffff] + (addressVal - 32768);
+    } else if ((c->fffc & 0x10) == 16) {
+        return c->ramBanks[0] + (addressVal - 49152);
+    }
+
+    return NULL;
+}
+
+/* this function returns a pointer to the byte that cart_writeCartridge would write to for
+   the specified address, or NULL if such a write would be ignored */
+emubyte *cart_getWritePage(Cartridge c, emuint address)
+{
+    /* define local variables */
+    emuint addressVal = address & 0xFFFF;
+
+    /* this mirrors the address decoding in cart_writeCartridge */
+    if ((addressVal >= 0x8000) && (addressVal <= 0xBFFF)) {
+        if ((c->fffc & 0x08) == 8)
+            return c->ramBanks[(c->fffc >> 2) & 0x01] + (addressVal - 32768);
+    } else if (addressVal >= 0xC000) {
+        if ((c->fffc & 0x10) == 16)
+            return c->ramBanks[0] + (addressVal - 49152);
+    }
+
+    return NULL;
+}
+
+/* this function returns the offset into the ROM data of a byte returned by cart_getReadPage,
+   or -1 if that byte isn't part of the ROM */
+signed_emulong cart_getRomOffset(Cartridge c, emubyte *byte)
+{
+    if (byte < c->romData || byte >= c->romData + c->romSize)
+        return -1;
+    return byte - c->romData;
+}
+
+/* this function returns the mapping registers packed together, with fffc in the top byte
+   and ffff in the bottom byte */
+emuint cart_getBankState(Cartridge c)
+{
+    return (c->fffc << 24) | (c->fffd << 16) | (c->fffe << 8) | c->ffff;
+}
+
 /* this function returns an emubyte pointer to the cartridge's state */
 emubyte *cart_saveState(Cartridge c)
 {
@@ -21,6 +21,10 @@ emubyte cart_readCartridge(Cartridge c, emuint address); /* retrieves the byte l
 void cart_writeCartridge(Cartridge c, emuint address, emubyte data); /* writes the byte to the specified address of the Cartridge object */
 emubyte *cart_saveState(Cartridge c); /* returns a pointer to the Cartridge object's state */
 emuint cart_getMemoryUsage(void); /* returns the number of bytes needed by a Cartridge object */
+emubyte *cart_getReadPage(Cartridge c, emuint address); /* returns a pointer to the readable memory at the specified address, or NULL if unmapped */
+emubyte *cart_getWritePage(Cartridge c, emuint address); /* returns a pointer to the writable memory at the specified address, or NULL if unmapped */
+signed_emulong cart_getRomOffset(Cartridge c, emubyte *byte); /* returns the ROM offset of a byte from cart_getReadPage, or -1 if it isn't ROM */
+emuint cart_getBankState(Cartridge c); /* returns the fffc, fffd, fffe and ffff registers packed into one value, fffc highest */
 emubool cart_isCartOverridingSystemRam(Cartridge c); /* returns whether or not this cartridge is currently mapping RAM into the address space
                                                         normally used by the main system */
 
@@ -18,12 +18,63 @@
 #define CONSOLE_MEMORY_SPACE 65536
 #define CONSOLE_IO_SPACE 256
 
-/* below is the Game Genie cheat code object reference */
+/* number of Z80 cycles the VDP takes to process one line */
+#define CYCLES_PER_LINE 228
+
+/* number of Z80 cycles between PC samples when the PC sampler is compiled in - this is
+   prime so that the samples don't fall into step with the VDP's lines */
+#define CONSOLE_SAMPLE_INTERVAL 1009
+
+/* below are the Action Replay and Game Genie cheat code object references */
+extern ArCheatArray arCheatArray;
 extern GgCheatArray ggCheatArray;
 
+/* internal helper functions */
+static void catchUpComponents(Console ms);
+static void updateMemoryMap(Console ms);
+static void updateNextEventTime(Console ms);
+static void runDueEvents(Console ms);
+static void setupIoHandlers(Console ms);
+static emubool setupActionReplay(Console ms);
+static emubool setupGameGenie(Console ms);
+static emubyte *getPatchedPage(Console ms, emuint page, emubyte *source);
+static emubyte readUnmapped(Console ms, emuint port);
+static emubyte readStartButton(Console ms, emuint port);
+static emubyte readGameGearRegister(Console ms, emuint port);
+static emubyte readVCounter(Console ms, emuint port);
+static emubyte readHCounter(Console ms, emuint port);
+static emubyte readVdpData(Console ms, emuint port);
+static emubyte readVdpControl(Console ms, emuint port);
+static emubyte readJoypadDC(Console ms, emuint port);
+static emubyte readJoypadDD(Console ms, emuint port);
+static void writeNothing(Console ms, emuint port, emubyte data);
+static void writeGameGearRegister(Console ms, emuint port, emubyte data);
+static void writeIoControl(Console ms, emuint port, emubyte data);
+static void writeMemoryControl(Console ms, emuint port, emubyte data);
+static void writeVdpData(Console ms, emuint port, emubyte data);
+static void writeVdpControl(Console ms, emuint port, emubyte data);
+static void writeSoundChip(Console ms, emuint port, emubyte data);
+#if defined(CONSOLE_PC_SAMPLER)
+static void recordPCSample(Console ms);
+static int comparePCSampleEntries(const void *first, const void *second);
+#endif
+
+/* this struct is a copy of a 1KB page of ROM with Game Genie codes applied to it - copies are
+   kept until the console is destroyed, so each copy's address always means the same contents */
+struct PatchedPage {
+    emubyte *source; /* the page of ROM this is a copy of */
+    struct PatchedPage *next; /* the next copy made for the same page of the address space */
+    emubyte data[CONSOLE_PAGE_SIZE];
+};
+
+/* these are the types of the functions handling reads from and writes to each IO port */
+typedef emubyte (*IoReadHandler)(Console ms, emuint port);
+typedef void (*IoWriteHandler)(Console ms, emuint port, emubyte data);
+
 /* this struct models the Master System console's internal state */
 struct Console {
     Z80 cpu; /* this represents the Z80 CPU of the Master System */
+    Z80Profile cpuProfile; /* this holds the functions of the Z80 profile picked when the console was created */
     Cartridge cart; /* this represents the cartridge of the Master System */
     Controllers controllers; /* this represents the controllers of the Master System */
     VDP vdp; /* this represents the VDP of the Master System */
@@ -35,9 +86,48 @@ struct Console {
     emuint systemAddressBus;
     emubyte systemDataBus;
 
+    /* IO port handlers for the console type, one per port so that mirrors need no decoding -
+       a port can be hooked for debugging by swapping its entry */
+    IoReadHandler ioReadHandlers[256];
+    IoWriteHandler ioWriteHandlers[256];
+
+    /* memory map of 1KB pages for direct access - a NULL entry means the access must go
+       through console_memRead or console_memWrite, as it needs special handling */
+    emubyte *readPages[CONSOLE_PAGE_COUNT];
+    emubyte *writePages[CONSOLE_PAGE_COUNT];
+
+    /* Action Replay attributes - the codes as offsets into system RAM and the values to write there */
+    emuint arCount;
+    emuint *arOffsets;
+    emubyte *arValues;
+
+    /* Game Genie attributes - each 1KB page with codes in it has a table of the code patching
+       each of its addresses (NULL where there isn't one), so only those addresses are checked */
+    GgCheat **ggPageCheats[CONSOLE_PAGE_COUNT]; /* NULL for pages without codes */
+    emubool ggPageCompares[CONSOLE_PAGE_COUNT]; /* whether any code in the page has a reference byte */
+    struct PatchedPage *ggPatchedPages[CONSOLE_PAGE_COUNT]; /* copies of ROM made for each page so far */
+
     /* interrupt related attributes */
     emubyte interruptSignal;
 
+    /* event scheduler attributes - times are measured by a clock counting the Z80 cycles
+       the other components have caught up with */
+    emuint clock;
+    emuint eventTimes[CONSOLE_EVENT_COUNT]; /* the time each event is scheduled for */
+    emubool eventScheduled[CONSOLE_EVENT_COUNT]; /* whether each event is scheduled */
+    emuint nextEventTime; /* the time of the earliest scheduled event */
+
+#if defined(CONSOLE_PC_SAMPLER)
+    /* PC sampler attributes */
+    signed_emulong romSize; /* size of the ROM, which has one sample count per byte */
+    emuint *romSamples; /* number of samples taken with the PC at each byte of the ROM */
+    emuint *otherSamples; /* number of samples taken with the PC at each address not backed by ROM */
+    emulong sampleCount; /* total number of samples taken */
+#endif
+
+    /* set when the VDP has finished a frame while catching up with the Z80 */
+    emubool frameReady;
+
     /* CRC-32 checksum of currently loaded ROM */
     emuint checksum;
     
@@ -47,7 +137,7 @@ struct Console {
 
 /* this function initialises a new Master System and all its components,
    returning a pointer to it */
-Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecksum, emubool isCodemasters, emubool isGameGear, emubool isPal, SDL_Rect *sourceRect, emubyte *saveState, emuint params, emubyte *wholePointer, emuint audioId)
+Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecksum, emubool isCodemasters, emubool isGameGear, emubool isPal, PixelFormat pixelFormat, SDL_Rect *sourceRect, emubyte *saveState, emuint params, emubyte *wholePointer, emuint audioId)
 {
     /* allocate memory for the Console struct */
     Console ms = (Console)wholePointer;
@@ -71,6 +161,12 @@ Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecks
     emubool isJapanese = false;
     if ((params & 0x10) == 0x10)
         isJapanese = true;
+    emubool blockCache = false; /* not offered in the options until it beats the interpreter */
+    if ((params & 0x100) == 0x100)
+        blockCache = true;
+    emubool fastProfile = false;
+    if ((params & 0x800) == 0x800)
+        fastProfile = true;
 
     /* check save state pointer, and section out to the different component pointers if not NULL */
     emubyte *cartState = NULL;
@@ -116,13 +212,45 @@ Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecks
     ms->controllers = NULL;
     ms->vdp = NULL;
     ms->soundchip = NULL;
+    ms->arCount = 0;
+    ms->arOffsets = NULL;
+    ms->arValues = NULL;
+    memset((void *)ms->ggPageCheats, 0, sizeof(ms->ggPageCheats));
+    memset((void *)ms->ggPatchedPages, 0, sizeof(ms->ggPatchedPages));
+
+    /* start the scheduler with no events, before the components schedule their own */
+    ms->clock = 0;
+    memset((void *)ms->eventScheduled, 0, sizeof(ms->eventScheduled));
+    memset((void *)ms->eventTimes, 0, sizeof(ms->eventTimes));
+    updateNextEventTime(ms);
+
+#if defined(CONSOLE_PC_SAMPLER)
+    /* setup PC sampler, and schedule the first sample */
+    ms->romSize = romSize;
+    ms->sampleCount = 0;
+    ms->romSamples = calloc(romSize, sizeof(emuint));
+    ms->otherSamples = calloc(CONSOLE_MEMORY_SPACE, sizeof(emuint));
+    if (ms->romSamples == NULL || ms->otherSamples == NULL) {
+        __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't allocate memory for PC sampler...\n");
+        destroyConsole(ms);
+        return NULL;
+    }
+    console_scheduleEvent(ms, CONSOLE_EVENT_SAMPLE, CONSOLE_SAMPLE_INTERVAL);
+#endif
 
-    /* setup Z80 */
-    if ((ms->cpu = createZ80(ms, z80State, wholePointer)) == NULL) {
+    /* work out where the Action Replay codes write and which addresses the Game Genie codes patch */
+    if (!setupActionReplay(ms) || !setupGameGenie(ms)) {
         destroyConsole(ms);
         return NULL;
     }
-    wholePointer += Z80_getMemoryUsage();
+
+    /* setup Z80, using the fast profile if asked to */
+    Z80_selectProfile(&ms->cpuProfile, fastProfile);
+    if ((ms->cpu = ms->cpuProfile.create(ms, z80State, blockCache, wholePointer)) == NULL) {
+        destroyConsole(ms);
+        return NULL;
+    }
+    wholePointer += ms->cpuProfile.getMemoryUsage();
 
     /* setup Cartridge */
     if ((ms->cart = createCartridge(romData, romSize, isCodemasters, cartState, sRamOnly, wholePointer)) == NULL) {
@@ -139,11 +267,11 @@ Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecks
     wholePointer += controllers_getMemoryUsage();
 
     /* setup VDP */
-    if ((ms->vdp = createVDP(ms, isGameGear, isPal, sourceRect, vdpState, wholePointer)) == NULL) {
+    if ((ms->vdp = createVDP(ms, isGameGear, isPal, pixelFormat, sourceRect, vdpState, wholePointer)) == NULL) {
         destroyConsole(ms);
         return NULL;
     }
-    wholePointer += vdp_getMemoryUsage();
+    wholePointer += vdp_getMemoryUsage(pixelFormat);
 
     /* setup SN76489 */
     if ((ms->soundchip = createSN76489(ms, soundchipState, soundDisabled, isGameGear, isPal, wholePointer, audioId)) == NULL) {
@@ -156,9 +284,13 @@ Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecks
 
     /* set interrupt signal to nothing */
     ms->interruptSignal = 0;
+
+    /* no frame is waiting to be drawn yet */
+    ms->frameReady = false;
     
-    /* set console type */
+    /* set console type, and the IO port handlers to go with it */
     ms->isGameGear = isGameGear;
+    setupIoHandlers(ms);
     
     /* if console is a Game Gear, setup specific registers */
     if (ms->isGameGear) {
@@ -189,6 +321,9 @@ Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecks
         memcpy((void *)ms->ioAddressSpace, (void *)tempPointer, 256);
     }
 
+    /* build the memory map now banking state is known */
+    updateMemoryMap(ms);
+
     /* free save state memory */
     if (saveState != NULL)
         free((void *)saveState);
@@ -202,7 +337,7 @@ void destroyConsole(Console ms)
 {
     /* destroy Z80 */
     if (ms->cpu != NULL)
-        destroyZ80(ms->cpu);
+        ms->cpuProfile.destroy(ms->cpu);
 
     /* destroy Cartridge */
     if (ms->cart != NULL)
@@ -219,291 +354,346 @@ void destroyConsole(Console ms)
     /* destroy SN76489 */
     if (ms->soundchip != NULL)
         destroySN76489(ms->soundchip);
+
+#if defined(CONSOLE_PC_SAMPLER)
+    /* write out the PC sampler's report next to the save states, then free its counts */
+    char *internalPath = (char *)SDL_AndroidGetInternalStoragePath();
+    if (internalPath != NULL && ms->romSamples != NULL && ms->otherSamples != NULL) {
+        char textPath[strlen(internalPath) + 32];
+        char collapsedPath[strlen(internalPath) + 32];
+        sprintf(textPath, "%s/%08x_pcsamples.txt", internalPath, ms->checksum);
+        sprintf(collapsedPath, "%s/%08x_pcsamples.folded", internalPath, ms->checksum);
+        console_writePCSampleReport(ms, textPath, collapsedPath);
+    }
+    free((void *)ms->romSamples);
+    free((void *)ms->otherSamples);
+    ms->romSamples = NULL;
+    ms->otherSamples = NULL;
+#endif
+
+    /* free Action Replay codes */
+    free((void *)ms->arOffsets);
+    free((void *)ms->arValues);
+    ms->arOffsets = NULL;
+    ms->arValues = NULL;
+    ms->arCount = 0;
+
+    /* free Game Genie tables and patched pages */
+    for (emuint page = 0; page < CONSOLE_PAGE_COUNT; ++page) {
+        free((void *)ms->ggPageCheats[page]);
+        ms->ggPageCheats[page] = NULL;
+        while (ms->ggPatchedPages[page] != NULL) {
+            struct PatchedPage *next = ms->ggPatchedPages[page]->next;
+            free((void *)ms->ggPatchedPages[page]);
+            ms->ggPatchedPages[page] = next;
+        }
+    }
 }
 
-/* this runs the console for one instruction of CPU time */
-emuint console_executeInstruction(EmuBundle *eb)
+/* this runs the console until at least the specified number of cycles have passed,
+   returning the number of cycles actually run - the Z80 runs in batches that end no later
+   than the next scheduled event, after which the VDP and sound chip catch up with it */
+emuint console_runUntil(EmuBundle *eb, emuint cycles)
 {
-    /* define frame update variable */
-    emubool updateFrame = false;
-    
-    /* run components for one instruction */
-    emuint c = Z80_executeInstruction(eb->ec->console->cpu);
-    updateFrame = vdp_executeCycles(eb->ec->console->vdp, c);
-    soundchip_executeCycles(eb->ec->console->soundchip, c);
-
-    /* update controller state and draw frame */
-    if (updateFrame) {
-        controllers_updateValues(eb->ec->console->controllers);
-        util_triggerPainting(eb);
+    /* define variables */
+    Console ms = eb->ec->console;
+    emuint cyclesRun = 0, budget = 0;
+
+    while (cyclesRun < cycles) {
+        /* run any events that are due, then work out how far the Z80 can run before the next one */
+        runDueEvents(ms);
+        budget = (signed_emuint)(ms->nextEventTime - ms->clock) > 0 ? ms->nextEventTime - ms->clock : 1;
+        if (budget > cycles - cyclesRun)
+            budget = cycles - cyclesRun;
+
+        /* run the Z80, then let the other components catch up */
+        cyclesRun += ms->cpuProfile.run(ms->cpu, budget);
+        catchUpComponents(ms);
+
+        /* update controller state and draw frame */
+        if (ms->frameReady) {
+            ms->frameReady = false;
+            controllers_updateValues(ms->controllers);
+            util_triggerPainting(eb);
+        }
     }
 
     /* return cycle count */
-    return c;
+    return cyclesRun;
+}
+
+/* this function passes any cycles the Z80 has run but the VDP and sound chip haven't seen
+   yet on to them, moving the scheduler's clock on and running any events that are then
+   due - it is called at the end of each batch, and before any IO port access so that the
+   devices are up to date when the Z80 talks to them */
+static void catchUpComponents(Console ms)
+{
+    emuint c = ms->cpuProfile.collectPendingCycles(ms->cpu);
+    if (c == 0)
+        return;
+
+    ms->clock += c;
+    if (vdp_executeCycles(ms->vdp, c))
+        ms->frameReady = true;
+    soundchip_executeCycles(ms->soundchip, c);
+    runDueEvents(ms);
+}
+
+/* this function schedules the specified event to run once the specified number of Z80 cycles
+   have passed, replacing any earlier time it was scheduled for - the VDP schedules its lines
+   and any change to its interrupt output, and the controllers schedule pause button presses */
+void console_scheduleEvent(Console ms, ConsoleEvent event, emuint delay)
+{
+    ms->eventTimes[event] = ms->clock + delay;
+    ms->eventScheduled[event] = true;
+    updateNextEventTime(ms);
+}
+
+/* this function works out the time of the earliest scheduled event - with nothing scheduled,
+   the Z80 is allowed to run for one line */
+static void updateNextEventTime(Console ms)
+{
+    ms->nextEventTime = ms->clock + CYCLES_PER_LINE;
+    for (emuint i = 0; i < CONSOLE_EVENT_COUNT; ++i) {
+        if (ms->eventScheduled[i] && (signed_emuint)(ms->eventTimes[i] - ms->nextEventTime) < 0)
+            ms->nextEventTime = ms->eventTimes[i];
+    }
+}
+
+/* this function runs every scheduled event that has become due - this is the only way the
+   Z80 finds out about interrupts, so it doesn't need to ask about them every instruction */
+static void runDueEvents(Console ms)
+{
+    /* nothing to do until the earliest event is due */
+    if ((signed_emuint)(ms->clock - ms->nextEventTime) < 0)
+        return;
+
+    for (emuint i = 0; i < CONSOLE_EVENT_COUNT; ++i) {
+        if (!ms->eventScheduled[i] || (signed_emuint)(ms->clock - ms->eventTimes[i]) < 0)
+            continue;
+        ms->eventScheduled[i] = false;
+
+        switch (i) {
+            /* the VDP processes lines as it catches up and schedules the next one itself,
+               so this event only marks where the Z80 must stop to let it catch up */
+            case CONSOLE_EVENT_LINE: break;
+
+            /* pass the VDP's interrupt output on to the Z80 */
+            case CONSOLE_EVENT_INTERRUPT:
+                ms->interruptSignal = vdp_isInterruptAsserted(ms->vdp);
+                ms->cpuProfile.setInterruptLine(ms->cpu, ms->interruptSignal != 0);
+                break;
+
+            /* reset the pause button and trigger an NMI */
+            case CONSOLE_EVENT_PAUSE:
+                controllers_handlePauseStatus(ms->controllers, 1, false);
+                ms->cpuProfile.raiseNmi(ms->cpu);
+                break;
+
+#if defined(CONSOLE_PC_SAMPLER)
+            /* take a PC sample and schedule the next one */
+            case CONSOLE_EVENT_SAMPLE:
+                recordPCSample(ms);
+                console_scheduleEvent(ms, CONSOLE_EVENT_SAMPLE, CONSOLE_SAMPLE_INTERVAL);
+                break;
+#endif
+        }
+    }
+
+    updateNextEventTime(ms);
 }
 
 /* this function deals with writes to any of the IO ports on the Z80 */
 void console_ioWrite(Console ms, emuint address, emubyte data)
 {
+    catchUpComponents(ms);
     ms->systemAddressBus = 0xFFFF & address;
     ms->systemDataBus = data;
 
-    /* this switch statement decides where to write to (depending on console type) */
-    if (ms->isGameGear) { /* console is Game Gear */
-        switch (address & 0xFF) {        
-            /* this section handles writing to Game Gear specific registers */
-            case 0x01: case 0x02: case 0x03: case 0x04: case 0x05:
-            case 0x06: ms->ioAddressSpace[address & 0xFF] = ms->systemDataBus; break;
-        
-            /* this section handles writing to the I/O control port and mirrors */
-            case 0x07: case 0x09: case 0x0B: case 0x0D: case 0x0F: case 0x11: case 0x13:
-            case 0x15: case 0x17: case 0x19: case 0x1B: case 0x1D: case 0x1F: case 0x21:
-            case 0x23: case 0x25: case 0x27: case 0x29: case 0x2B: case 0x2D: case 0x2F:
-            case 0x31: case 0x33: case 0x35: case 0x37: case 0x39: case 0x3B: case 0x3D:
-            case 0x3F: controllers_handle3F(ms->controllers, 1, ms->systemDataBus); break; /* 0x3F is the real port */
-                
-            /* this section handles writing to port 3E to enable/disable RAM etc. */
-            case 0x08: case 0x0A: case 0x0C: case 0x0E: case 0x10: case 0x12: case 0x14:
-            case 0x16: case 0x18: case 0x1A: case 0x1C: case 0x1E: case 0x20: case 0x22:
-            case 0x24: case 0x26: case 0x28: case 0x2A: case 0x2C: case 0x2E: case 0x30:
-            case 0x32: case 0x34: case 0x36: case 0x38: case 0x3A: case 0x3C:
-            case 0x3E: ms->ioAddressSpace[0x3E] = ms->systemDataBus; break; /* 0x3E is the real port */
-                
-            /* this section handles writes to the VDP data port and mirrors */
-            case 0x80: case 0x82: case 0x84: case 0x86: case 0x88: case 0x8A: case 0x8C:
-            case 0x8E: case 0x90: case 0x92: case 0x94: case 0x96: case 0x98: case 0x9A:
-            case 0x9C: case 0x9E: case 0xA0: case 0xA2: case 0xA4: case 0xA6: case 0xA8:
-            case 0xAA: case 0xAC: case 0xAE: case 0xB0: case 0xB2: case 0xB4: case 0xB6:
-            case 0xB8: case 0xBA: case 0xBC:
-            case 0xBE: vdp_dataWrite(ms->vdp, ms->systemDataBus); break; /* 0xBE is the real port */
-                
-            /* this section handles writes to the VDP control port and mirrors */
-            case 0x81: case 0x83: case 0x85: case 0x87: case 0x89: case 0x8B: case 0x8D:
-            case 0x8F: case 0x91: case 0x93: case 0x95: case 0x97: case 0x99: case 0x9B:
-            case 0x9D: case 0x9F: case 0xA1: case 0xA3: case 0xA5: case 0xA7: case 0xA9:
-            case 0xAB: case 0xAD: case 0xAF: case 0xB1: case 0xB3: case 0xB5: case 0xB7:
-            case 0xB9: case 0xBB: case 0xBD:
-            case 0xBF: vdp_controlWrite(ms->vdp, ms->systemDataBus); break; /* 0xBF is the real port */
-                
-            /* this section handles writes to the SN76489 sound chip */
-            case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x46:
-            case 0x47: case 0x48: case 0x49: case 0x4A: case 0x4B: case 0x4C: case 0x4D:
-            case 0x4E: case 0x4F: case 0x50: case 0x51: case 0x52: case 0x53: case 0x54:
-            case 0x55: case 0x56: case 0x57: case 0x58: case 0x59: case 0x5A: case 0x5B:
-            case 0x5C: case 0x5D: case 0x5E: case 0x5F: case 0x60: case 0x61: case 0x62:
-            case 0x63: case 0x64: case 0x65: case 0x66: case 0x67: case 0x68: case 0x69:
-            case 0x6A: case 0x6B: case 0x6C: case 0x6D: case 0x6E: case 0x6F: case 0x70:
-            case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0x77:
-            case 0x78: case 0x79: case 0x7A: case 0x7B: case 0x7C: case 0x7D: case 0x7E:
-            case 0x7F: soundchip_soundWrite(ms->soundchip, ms->systemDataBus); break; /* 0x7F is the real port */
-        }
-    } else { /* console is Master System */
-        switch (address & 0xFF) {
-            /* this section handles writing to the I/O control port and mirrors */
-            case 0x01: case 0x03: case 0x05: case 0x07: case 0x09: case 0x0B: case 0x0D:
-            case 0x0F: case 0x11: case 0x13: case 0x15: case 0x17: case 0x19: case 0x1B:
-            case 0x1D: case 0x1F: case 0x21: case 0x23: case 0x25: case 0x27: case 0x29:
-            case 0x2B: case 0x2D: case 0x2F: case 0x31: case 0x33: case 0x35: case 0x37:
-            case 0x39: case 0x3B: case 0x3D:
-            case 0x3F: controllers_handle3F(ms->controllers, 1, ms->systemDataBus); break; /* 0x3F is the real port */
-                
-            /* this section handles writing to port 3E to enable/disable RAM etc. */
-            case 0x00: case 0x02: case 0x04: case 0x06: case 0x08: case 0x0A: case 0x0C:
-            case 0x0E: case 0x10: case 0x12: case 0x14: case 0x16: case 0x18: case 0x1A:
-            case 0x1C: case 0x1E: case 0x20: case 0x22: case 0x24: case 0x26: case 0x28:
-            case 0x2A: case 0x2C: case 0x2E: case 0x30: case 0x32: case 0x34: case 0x36:
-            case 0x38: case 0x3A: case 0x3C:
-            case 0x3E: ms->ioAddressSpace[0x3E] = ms->systemDataBus; break; /* 0x3E is the real port */
-                
-            /* this section handles writes to the VDP data port and mirrors */
-            case 0x80: case 0x82: case 0x84: case 0x86: case 0x88: case 0x8A: case 0x8C:
-            case 0x8E: case 0x90: case 0x92: case 0x94: case 0x96: case 0x98: case 0x9A:
-            case 0x9C: case 0x9E: case 0xA0: case 0xA2: case 0xA4: case 0xA6: case 0xA8:
-            case 0xAA: case 0xAC: case 0xAE: case 0xB0: case 0xB2: case 0xB4: case 0xB6:
-            case 0xB8: case 0xBA: case 0xBC:
-            case 0xBE: vdp_dataWrite(ms->vdp, ms->systemDataBus); break; /* 0xBE is the real port */
-                
-            /* this section handles writes to the VDP control port and mirrors */
-            case 0x81: case 0x83: case 0x85: case 0x87: case 0x89: case 0x8B: case 0x8D:
-            case 0x8F: case 0x91: case 0x93: case 0x95: case 0x97: case 0x99: case 0x9B:
-            case 0x9D: case 0x9F: case 0xA1: case 0xA3: case 0xA5: case 0xA7: case 0xA9:
-            case 0xAB: case 0xAD: case 0xAF: case 0xB1: case 0xB3: case 0xB5: case 0xB7:
-            case 0xB9: case 0xBB: case 0xBD:
-            case 0xBF: vdp_controlWrite(ms->vdp, ms->systemDataBus); break; /* 0xBF is the real port */
-                
-            /* this section handles writes to the SN76489 sound chip */
-            case 0x40: case 0x41: case 0x42: case 0x43: case 0x44: case 0x45: case 0x46:
-            case 0x47: case 0x48: case 0x49: case 0x4A: case 0x4B: case 0x4C: case 0x4D:
-            case 0x4E: case 0x4F: case 0x50: case 0x51: case 0x52: case 0x53: case 0x54:
-            case 0x55: case 0x56: case 0x57: case 0x58: case 0x59: case 0x5A: case 0x5B:
-            case 0x5C: case 0x5D: case 0x5E: case 0x5F: case 0x60: case 0x61: case 0x62:
-            case 0x63: case 0x64: case 0x65: case 0x66: case 0x67: case 0x68: case 0x69:
-            case 0x6A: case 0x6B: case 0x6C: case 0x6D: case 0x6E: case 0x6F: case 0x70:
-            case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0x77:
-            case 0x78: case 0x79: case 0x7A: case 0x7B: case 0x7C: case 0x7D: case 0x7E:
-            case 0x7F: soundchip_soundWrite(ms->soundchip, ms->systemDataBus); break; /* 0x7F is the real port */
-        }
-    }
+    /* pass the write on to the handler for this port (depending on console type) */
+    ms->ioWriteHandlers[address & 0xFF](ms, address & 0xFF, ms->systemDataBus);
+
+    /* the write could have changed the VDP's interrupt output */
+    runDueEvents(ms);
 }
 
 /* this function deals with reads from the Z80 IO ports */
 emubyte console_ioRead(Console ms, emuint address)
 {
+    catchUpComponents(ms);
     ms->systemAddressBus = 0xFFFF & address;
-    emubyte returnVal = 0;
 
-    /* this switch statement decides where to read from (depending on console type) */
-    if (ms->isGameGear) { /* console is Game Gear */
-        switch (address & 0xFF) {
-            /* this section handles reading from the start button register */
-            case 0x00: returnVal = controllers_handleStart(ms->controllers, 0, 0); break;
-        
-            /* this section handles reading from Game Gear specific registers */
-            case 0x01: case 0x02: case 0x03: case 0x04: case 0x05:
-            case 0x06: returnVal = ms->ioAddressSpace[address & 0xFF]; break;
-        
-            /* this section handles reading from the I/O control port and mirrors */
-            case 0x07: case 0x09: case 0x0B: case 0x0D: case 0x0F: case 0x11: case 0x13:
-            case 0x15: case 0x17: case 0x19: case 0x1B: case 0x1D: case 0x1F: case 0x21:
-            case 0x23: case 0x25: case 0x27: case 0x29: case 0x2B: case 0x2D: case 0x2F:
-            case 0x31: case 0x33: case 0x35: case 0x37: case 0x39: case 0x3B: case 0x3D:
-            case 0x3F: returnVal = 0xFF; break; /* 0x3F is the real port */
-                
-            /* this section handles reading from joypad port 0xDC and mirrors */
-            case 0xC0:
-            case 0xDC: returnVal = controllers_handleDC(ms->controllers, 0, 0); break; /* 0xDC is the real port */
-            
-            /* this section handles reading from joypad port 0xDD and mirrors */
-            case 0xC1:
-            case 0xDD: returnVal = controllers_handleDD(ms->controllers, 0, 0); break; /* 0xDD is the real port */
-            
-            /* this section returns FF */
-            case 0xC2: case 0xC4: case 0xC6: case 0xC8: case 0xCA: case 0xCC: case 0xCE:
-            case 0xD0: case 0xD2: case 0xD4: case 0xD6: case 0xD8: case 0xDA: case 0xDE:
-            case 0xE0: case 0xE2: case 0xE4: case 0xE6: case 0xE8: case 0xEA: case 0xEC:
-            case 0xEE: case 0xF0: case 0xF2: case 0xF4: case 0xF6: case 0xF8: case 0xFA:
-            case 0xFC: case 0xFE: case 0xC3: case 0xC5: case 0xC7: case 0xC9: case 0xCB:
-            case 0xCF: case 0xD1: case 0xD3: case 0xD5: case 0xD7: case 0xD9: case 0xDB:
-            case 0xDF: case 0xE1: case 0xE3: case 0xE5: case 0xE7: case 0xE9: case 0xEB:
-            case 0xED: case 0xEF: case 0xF1: case 0xF3: case 0xF5: case 0xF7: case 0xF9:
-            case 0xFB: case 0xFD: case 0xCD:
-            case 0xFF: returnVal = 0xFF; break;
-                
-            /* this section handles reading from port 3E and mirrors */
-            case 0x08: case 0x0A: case 0x0C: case 0x0E: case 0x10: case 0x12: case 0x14:
-            case 0x16: case 0x18: case 0x1A: case 0x1C: case 0x1E: case 0x20: case 0x22:
-            case 0x24: case 0x26: case 0x28: case 0x2A: case 0x2C: case 0x2E: case 0x30:
-            case 0x32: case 0x34: case 0x36: case 0x38: case 0x3A: case 0x3C:
-            case 0x3E: returnVal = 0xFF; break; /* 0x3E is the real port */
-                
-            /* this section handles reading from the VDP vcounter and mirrors */
-            case 0x40: case 0x42: case 0x44: case 0x46: case 0x48: case 0x4A: case 0x4C:
-            case 0x4E: case 0x50: case 0x52: case 0x54: case 0x56: case 0x58: case 0x5A:
-            case 0x5C: case 0x5E: case 0x60: case 0x62: case 0x64: case 0x66: case 0x68:
-            case 0x6A: case 0x6C: case 0x6E: case 0x70: case 0x72: case 0x74: case 0x76:
-            case 0x78: case 0x7A: case 0x7C:
-            case 0x7E: returnVal = 0xFF & vdp_returnVCounter(ms->vdp); break; /* 0x7E is the real port */
-                
-            /* this section handles reading from the VDP hcounter and mirrors */
-            case 0x41: case 0x43: case 0x45: case 0x47: case 0x49: case 0x4B: case 0x4D:
-            case 0x4F: case 0x51: case 0x53: case 0x55: case 0x57: case 0x59: case 0x5B:
-            case 0x5D: case 0x5F: case 0x61: case 0x63: case 0x65: case 0x67: case 0x69:
-            case 0x6B: case 0x6D: case 0x6F: case 0x71: case 0x73: case 0x75: case 0x77:
-            case 0x79: case 0x7B: case 0x7D:
-            case 0x7F: returnVal = 0xFF & vdp_returnHCounter(ms->vdp); break; /* 0x7F is the real port */
-                
-            /* this section handles reads of the VDP data port contents and mirrors */
-            case 0x80: case 0x82: case 0x84: case 0x86: case 0x88: case 0x8A: case 0x8C:
-            case 0x8E: case 0x90: case 0x92: case 0x94: case 0x96: case 0x98: case 0x9A:
-            case 0x9C: case 0x9E: case 0xA0: case 0xA2: case 0xA4: case 0xA6: case 0xA8:
-            case 0xAA: case 0xAC: case 0xAE: case 0xB0: case 0xB2: case 0xB4: case 0xB6:
-            case 0xB8: case 0xBA: case 0xBC:
-            case 0xBE: returnVal = 0xFF & vdp_dataRead(ms->vdp); break; /* 0xBE is the real port */
-                
-            /* this section handles reads from the VDP control port and mirrors */
-            case 0x81: case 0x83: case 0x85: case 0x87: case 0x89: case 0x8B: case 0x8D:
-            case 0x8F: case 0x91: case 0x93: case 0x95: case 0x97: case 0x99: case 0x9B:
-            case 0x9D: case 0x9F: case 0xA1: case 0xA3: case 0xA5: case 0xA7: case 0xA9:
-            case 0xAB: case 0xAD: case 0xAF: case 0xB1: case 0xB3: case 0xB5: case 0xB7:
-            case 0xB9: case 0xBB: case 0xBD:
-            case 0xBF: returnVal = 0xFF & vdp_controlRead(ms->vdp); break; /* 0xBF is the real port */
-        }
-    } else { /* console is Master System */
-        switch (address & 0xFF) {
-            /* this section handles reading from the I/O control port and mirrors */
-            case 0x01: case 0x03: case 0x05: case 0x07: case 0x09: case 0x0B: case 0x0D:
-            case 0x0F: case 0x11: case 0x13: case 0x15: case 0x17: case 0x19: case 0x1B:
-            case 0x1D: case 0x1F: case 0x21: case 0x23: case 0x25: case 0x27: case 0x29:
-            case 0x2B: case 0x2D: case 0x2F: case 0x31: case 0x33: case 0x35: case 0x37:
-            case 0x39: case 0x3B: case 0x3D:
-            case 0x3F: /* 0x3F is the real port */
-                       returnVal = 0xFF; break;
-                
-            /* this section handles reading from joypad port 0xDC and mirrors */
-            case 0xC0: case 0xC2: case 0xC4: case 0xC6: case 0xC8: case 0xCA: case 0xCC:
-            case 0xCE: case 0xD0: case 0xD2: case 0xD4: case 0xD6: case 0xD8: case 0xDA:
-            case 0xDE: case 0xE0: case 0xE2: case 0xE4: case 0xE6: case 0xE8: case 0xEA:
-            case 0xEC: case 0xEE: case 0xF0: case 0xF2: case 0xF4: case 0xF6: case 0xF8:
-            case 0xFA: case 0xFC: case 0xFE:
-            case 0xDC: returnVal = controllers_handleDC(ms->controllers, 0, 0); break; /* 0xDC is the real port */
-                
-            /* this section handles reading from joypad port 0xDD and mirrors */
-            case 0xC1: case 0xC3: case 0xC5: case 0xC7: case 0xC9: case 0xCB: case 0xCD:
-            case 0xCF: case 0xD1: case 0xD3: case 0xD5: case 0xD7: case 0xD9: case 0xDB:
-            case 0xDF: case 0xE1: case 0xE3: case 0xE5: case 0xE7: case 0xE9: case 0xEB:
-            case 0xED: case 0xEF: case 0xF1: case 0xF3: case 0xF5: case 0xF7: case 0xF9:
-            case 0xFB: case 0xFD: case 0xFF:
-            case 0xDD: returnVal = controllers_handleDD(ms->controllers, 0, 0); break; /* 0xDD is the real port */
-                
-            /* this section handles reading from port 3E and mirrors */
-            case 0x00: case 0x02: case 0x04: case 0x06: case 0x08: case 0x0A: case 0x0C:
-            case 0x0E: case 0x10: case 0x12: case 0x14: case 0x16: case 0x18: case 0x1A:
-            case 0x1C: case 0x1E: case 0x20: case 0x22: case 0x24: case 0x26: case 0x28:
-            case 0x2A: case 0x2C: case 0x2E: case 0x30: case 0x32: case 0x34: case 0x36:
-            case 0x38: case 0x3A: case 0x3C:
-            case 0x3E: returnVal = 0xFF; break; /* 0x3E is the real port */
-                
-            /* this section handles reading from the VDP vcounter and mirrors */
-            case 0x40: case 0x42: case 0x44: case 0x46: case 0x48: case 0x4A: case 0x4C:
-            case 0x4E: case 0x50: case 0x52: case 0x54: case 0x56: case 0x58: case 0x5A:
-            case 0x5C: case 0x5E: case 0x60: case 0x62: case 0x64: case 0x66: case 0x68:
-            case 0x6A: case 0x6C: case 0x6E: case 0x70: case 0x72: case 0x74: case 0x76:
-            case 0x78: case 0x7A: case 0x7C:
-            case 0x7E: returnVal = 0xFF & vdp_returnVCounter(ms->vdp); break; /* 0x7E is the real port */
-                
-            /* this section handles reading from the VDP hcounter and mirrors */
-            case 0x41: case 0x43: case 0x45: case 0x47: case 0x49: case 0x4B: case 0x4D:
-            case 0x4F: case 0x51: case 0x53: case 0x55: case 0x57: case 0x59: case 0x5B:
-            case 0x5D: case 0x5F: case 0x61: case 0x63: case 0x65: case 0x67: case 0x69:
-            case 0x6B: case 0x6D: case 0x6F: case 0x71: case 0x73: case 0x75: case 0x77:
-            case 0x79: case 0x7B: case 0x7D:
-            case 0x7F: returnVal = 0xFF & vdp_returnHCounter(ms->vdp); break; /* 0x7F is the real port */
-                
-            /* this section handles reads of the VDP data port contents and mirrors */
-            case 0x80: case 0x82: case 0x84: case 0x86: case 0x88: case 0x8A: case 0x8C:
-            case 0x8E: case 0x90: case 0x92: case 0x94: case 0x96: case 0x98: case 0x9A:
-            case 0x9C: case 0x9E: case 0xA0: case 0xA2: case 0xA4: case 0xA6: case 0xA8:
-            case 0xAA: case 0xAC: case 0xAE: case 0xB0: case 0xB2: case 0xB4: case 0xB6:
-            case 0xB8: case 0xBA: case 0xBC:
-            case 0xBE: returnVal = 0xFF & vdp_dataRead(ms->vdp); break; /* 0xBE is the real port */
-                
-            /* this section handles reads from the VDP control port and mirrors */
-            case 0x81: case 0x83: case 0x85: case 0x87: case 0x89: case 0x8B: case 0x8D:
-            case 0x8F: case 0x91: case 0x93: case 0x95: case 0x97: case 0x99: case 0x9B:
-            case 0x9D: case 0x9F: case 0xA1: case 0xA3: case 0xA5: case 0xA7: case 0xA9:
-            case 0xAB: case 0xAD: case 0xAF: case 0xB1: case 0xB3: case 0xB5: case 0xB7:
-            case 0xB9: case 0xBB: case 0xBD:
-            case 0xBF: returnVal = 0xFF & vdp_controlRead(ms->vdp); break; /* 0xBF is the real port */
-        }
-    }
+    /* pass the read on to the handler for this port (depending on console type) */
+    emubyte returnVal = ms->ioReadHandlers[address & 0xFF](ms, address & 0xFF);
+
+    /* the read could have changed the VDP's interrupt output */
+    runDueEvents(ms);
 
     ms->systemDataBus = returnVal;
     return ms->systemDataBus;
 }
 
+/* this function fills in the IO port handler tables for the console type - the ports are only
+   partly decoded, so each device answers on a range of mirrors as well as its real port */
+static void setupIoHandlers(Console ms)
+{
+    /* define variables */
+    emuint port;
+
+    for (port = 0; port < 256; ++port) {
+        if (port < 0x40) {
+            /* the I/O control port is 0x3F and port 3E (which enables/disables RAM etc.)
+               is 0x3E, with no reads - the Game Gear has its own registers at 0x00 to 0x06 */
+            if (ms->isGameGear && port == 0x00) {
+                ms->ioReadHandlers[port] = readStartButton;
+                ms->ioWriteHandlers[port] = writeNothing;
+            } else if (ms->isGameGear && port <= 0x06) {
+                ms->ioReadHandlers[port] = readGameGearRegister;
+                ms->ioWriteHandlers[port] = writeGameGearRegister;
+            } else {
+                ms->ioReadHandlers[port] = readUnmapped;
+                ms->ioWriteHandlers[port] = (port & 0x01) ? writeIoControl : writeMemoryControl;
+            }
+        } else if (port < 0x80) {
+            /* reads come from the VDP vcounter at 0x7E and hcounter at 0x7F, and writes go
+               to the SN76489 sound chip at 0x7F */
+            ms->ioReadHandlers[port] = (port & 0x01) ? readHCounter : readVCounter;
+            ms->ioWriteHandlers[port] = writeSoundChip;
+        } else if (port < 0xC0) {
+            /* the VDP data port is 0xBE and the VDP control port is 0xBF */
+            ms->ioReadHandlers[port] = (port & 0x01) ? readVdpControl : readVdpData;
+            ms->ioWriteHandlers[port] = (port & 0x01) ? writeVdpControl : writeVdpData;
+        } else {
+            /* the joypad ports are 0xDC and 0xDD, which on the Game Gear are only mirrored at
+               0xC0 and 0xC1, and there are no writes */
+            if (!ms->isGameGear || port == 0xC0 || port == 0xDC || port == 0xC1 || port == 0xDD)
+                ms->ioReadHandlers[port] = (port & 0x01) ? readJoypadDD : readJoypadDC;
+            else
+                ms->ioReadHandlers[port] = readUnmapped;
+            ms->ioWriteHandlers[port] = writeNothing;
+        }
+    }
+}
+
+/* this function handles reads from ports that return 0xFF */
+static emubyte readUnmapped(Console ms, emuint port)
+{
+    (void)ms;
+    (void)port;
+    return 0xFF;
+}
+
+/* this function handles reads from the Game Gear start button register */
+static emubyte readStartButton(Console ms, emuint port)
+{
+    (void)port;
+    return controllers_handleStart(ms->controllers, 0, 0);
+}
+
+/* this function handles reads from the Game Gear specific registers */
+static emubyte readGameGearRegister(Console ms, emuint port)
+{
+    return ms->ioAddressSpace[port];
+}
+
+/* this function handles reads from the VDP vcounter */
+static emubyte readVCounter(Console ms, emuint port)
+{
+    (void)port;
+    return 0xFF & vdp_returnVCounter(ms->vdp);
+}
+
+/* this function handles reads from the VDP hcounter */
+static emubyte readHCounter(Console ms, emuint port)
+{
+    (void)port;
+    return 0xFF & vdp_returnHCounter(ms->vdp);
+}
+
+/* this function handles reads of the VDP data port contents */
+static emubyte readVdpData(Console ms, emuint port)
+{
+    (void)port;
+    return 0xFF & vdp_dataRead(ms->vdp);
+}
+
+/* this function handles reads from the VDP control port */
+static emubyte readVdpControl(Console ms, emuint port)
+{
+    (void)port;
+    return 0xFF & vdp_controlRead(ms->vdp);
+}
+
+/* this function handles reads from joypad port 0xDC */
+static emubyte readJoypadDC(Console ms, emuint port)
+{
+    (void)port;
+    return controllers_handleDC(ms->controllers, 0, 0);
+}
+
+/* this function handles reads from joypad port 0xDD */
+static emubyte readJoypadDD(Console ms, emuint port)
+{
+    (void)port;
+    return controllers_handleDD(ms->controllers, 0, 0);
+}
+
+/* this function handles writes to ports that ignore them */
+static void writeNothing(Console ms, emuint port, emubyte data)
+{
+    (void)ms;
+    (void)port;
+    (void)data;
+}
+
+/* this function handles writes to the Game Gear specific registers */
+static void writeGameGearRegister(Console ms, emuint port, emubyte data)
+{
+    ms->ioAddressSpace[port] = data;
+}
+
+/* this function handles writes to the I/O control port */
+static void writeIoControl(Console ms, emuint port, emubyte data)
+{
+    (void)port;
+    controllers_handle3F(ms->controllers, 1, data);
+}
+
+/* this function handles writes to port 3E, which enables/disables RAM etc. */
+static void writeMemoryControl(Console ms, emuint port, emubyte data)
+{
+    (void)port;
+    ms->ioAddressSpace[0x3E] = data;
+    updateMemoryMap(ms);
+}
+
+/* this function handles writes to the VDP data port */
+static void writeVdpData(Console ms, emuint port, emubyte data)
+{
+    (void)port;
+    vdp_dataWrite(ms->vdp, data);
+}
+
+/* this function handles writes to the VDP control port */
+static void writeVdpControl(Console ms, emuint port, emubyte data)
+{
+    (void)port;
+    vdp_controlWrite(ms->vdp, data);
+}
+
+/* this function handles writes to the SN76489 sound chip */
+static void writeSoundChip(Console ms, emuint port, emubyte data)
+{
+    (void)port;
+    soundchip_soundWrite(ms->soundchip, data);
+}
+
 /* this function deals with writes to the memory space */
 void console_memWrite(Console ms, emuint address, emubyte data)
 {
+    /* let the Z80 throw away any code it has cached from here */
+    ms->cpuProfile.memoryWritten(ms->cpu, address);
+
     ms->systemAddressBus = 0xFFFF & address;
     ms->systemDataBus = data;
 
@@ -512,9 +702,9 @@ void console_memWrite(Console ms, emuint address, emubyte data)
         /* check for Codemasters mapper */
         if (cart_isCodemasters(ms->cart)) {
             switch (ms->systemAddressBus) {
-            case 0: cart_writeFFFD(ms->cart, ms->systemDataBus); break;
-            case 0x4000: cart_writeFFFE(ms->cart, ms->systemDataBus); break;
-            case 0x8000: cart_writeFFFF(ms->cart, ms->systemDataBus); break;
+            case 0: cart_writeFFFD(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+            case 0x4000: cart_writeFFFE(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+            case 0x8000: cart_writeFFFF(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
             }
         }
         cart_writeCartridge(ms->cart, ms->systemAddressBus, ms->systemDataBus);
@@ -531,10 +721,10 @@ void console_memWrite(Console ms, emuint address, emubyte data)
             /* check if we are writing to control registers as well */
             if (!cart_isCodemasters(ms->cart)) {
                 switch (ms->systemAddressBus) {
-                case 0xFFFC: cart_writeFFFC(ms->cart, ms->systemDataBus); break;
-                case 0xFFFD: cart_writeFFFD(ms->cart, ms->systemDataBus); break;
-                case 0xFFFE: cart_writeFFFE(ms->cart, ms->systemDataBus); break;
-                case 0xFFFF: cart_writeFFFF(ms->cart, ms->systemDataBus); break;
+                case 0xFFFC: cart_writeFFFC(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+                case 0xFFFD: cart_writeFFFD(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+                case 0xFFFE: cart_writeFFFE(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+                case 0xFFFF: cart_writeFFFF(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
                 }
             }
         } /* RAM is disabled in this case so send all writes to cartridge */
@@ -545,10 +735,10 @@ void console_memWrite(Console ms, emuint address, emubyte data)
             /* check if we are writing to control registers as well */
             if (!cart_isCodemasters(ms->cart)) {
                 switch (ms->systemAddressBus) {
-                case 0xFFFC: cart_writeFFFC(ms->cart, ms->systemDataBus); break;
-                case 0xFFFD: cart_writeFFFD(ms->cart, ms->systemDataBus); break;
-                case 0xFFFE: cart_writeFFFE(ms->cart, ms->systemDataBus); break;
-                case 0xFFFF: cart_writeFFFF(ms->cart, ms->systemDataBus); break;
+                case 0xFFFC: cart_writeFFFC(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+                case 0xFFFD: cart_writeFFFD(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+                case 0xFFFE: cart_writeFFFE(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
+                case 0xFFFF: cart_writeFFFF(ms->cart, ms->systemDataBus); updateMemoryMap(ms); break;
                 }
             }
         }
@@ -579,43 +769,237 @@ emubyte console_memRead(Console ms, emuint address)
         }
     }
 
-    /* check for Game Genie codes */
+    /* check for a Game Genie code at this address */
+    GgCheat **pageCheats = ms->ggPageCheats[ms->systemAddressBus >> CONSOLE_PAGE_SHIFT];
+    if (pageCheats != NULL) {
+        GgCheat *cheat = pageCheats[ms->systemAddressBus & (CONSOLE_PAGE_SIZE - 1)];
+        if (cheat != NULL && (!cheat->cloakAndReferencePresent || returnVal == cheat->reference))
+            returnVal = cheat->value;
+    }
+
+    ms->systemDataBus = returnVal;
+    return ms->systemDataBus;
+}
+
+/* this function returns the table of 1KB pages the Z80 can read from directly */
+emubyte **console_getReadPages(Console ms)
+{
+    return ms->readPages;
+}
+
+/* this function returns the table of 1KB pages the Z80 can write to directly */
+emubyte **console_getWritePages(Console ms)
+{
+    return ms->writePages;
+}
+
+/* this function returns the cartridge's mapping registers, for the Z80's instruction trace */
+emuint console_getBankState(Console ms)
+{
+    return cart_getBankState(ms->cart);
+}
+
+/* this function returns whether repeating block I/O instructions like OTIR can run several
+   iterations at a time on the specified port - only the VDP data port and its mirrors
+   qualify, as those are what tile and palette uploads use */
+emubool console_isBlockIOPort(Console ms, emuint address)
+{
+    (void)ms;
+    return (address & 0xC1) == 0x80;
+}
+
+/* this function returns whether the specified port is one the Z80 can poll in an idle loop -
+   only the VDP V counter and status port and their mirrors qualify, as neither can change
+   until the VDP processes another line, and a status read returns the same cleared value
+   every time after the first */
+emubool console_isIdlePollPort(Console ms, emuint address)
+{
+    (void)ms;
+    return ((address & 0xC1) == 0x40) || ((address & 0xC1) == 0x81);
+}
+
+/* this function rebuilds the memory map from the current state of port 0x3E and the
+   cartridge mapper - it must be called whenever either changes, and follows the same
+   decoding as console_memRead and console_memWrite */
+static void updateMemoryMap(Console ms)
+{
+    /* define variables */
+    emuint page, address;
+    emubool systemRamEnabled = (ms->ioAddressSpace[0x3E] & 0x10) == 0 || !cart_isCartOverridingSystemRam(ms->cart);
+
+    for (page = 0; page < CONSOLE_PAGE_COUNT; ++page) {
+        address = page << CONSOLE_PAGE_SHIFT;
+        if (address <= 0xBFFF || !systemRamEnabled) {
+            /* cartridge ROM or RAM */
+            ms->readPages[page] = cart_getReadPage(ms->cart, address);
+            ms->writePages[page] = cart_getWritePage(ms->cart, address);
+        } else {
+            /* system RAM, mirrored above 0xDFFF */
+            if (address <= 0xDFFF) {
+                ms->readPages[page] = ms->memoryAddressSpace + address;
+                ms->writePages[page] = ms->memoryAddressSpace + address;
+            } else {
+                ms->readPages[page] = ms->memoryAddressSpace + address - 8192;
+                ms->writePages[page] = ms->memoryAddressSpace + address - 8192;
+            }
+        }
+    }
+
+    /* the mapper registers need writes to go through console_memWrite - for the standard
+       mapper they live at 0xFFFC-0xFFFF, and for the Codemasters mapper at the start of
+       each slot */
+    if (cart_isCodemasters(ms->cart)) {
+        ms->writePages[0x0000 >> CONSOLE_PAGE_SHIFT] = NULL;
+        ms->writePages[0x4000 >> CONSOLE_PAGE_SHIFT] = NULL;
+        ms->writePages[0x8000 >> CONSOLE_PAGE_SHIFT] = NULL;
+    } else {
+        ms->writePages[0xFFFF >> CONSOLE_PAGE_SHIFT] = NULL;
+    }
+
+    /* Game Genie codes patch reads - pages of ROM can be read from a patched copy as long as
+       none of their codes need to compare against a reference byte, and the rest of the pages
+       containing codes must use console_memRead */
     if (ggCheatArray.enabled) {
-        for (emuint i = 0; i < ggCheatArray.cheatCount; ++i) {
-            if (ms->systemAddressBus == ggCheatArray.cheats[i].address) {
-                if (ggCheatArray.cheats[i].cloakAndReferencePresent) {
-                    if (returnVal == ggCheatArray.cheats[i].reference) {
-                        returnVal = ggCheatArray.cheats[i].value;
-                    }
-                } else {
-                    returnVal = ggCheatArray.cheats[i].value;
-                }
-                break;
+        for (page = 0; page < CONSOLE_PAGE_COUNT; ++page) {
+            if (ms->ggPageCheats[page] == NULL)
+                continue;
+            if (!ms->ggPageCompares[page] && ms->readPages[page] != NULL &&
+                cart_getRomOffset(ms->cart, ms->readPages[page]) >= 0)
+                ms->readPages[page] = getPatchedPage(ms, page, ms->readPages[page]);
+            else
+                ms->readPages[page] = NULL;
+        }
+    }
+
+    /* let the Z80 know, so it can throw away any code it has cached from RAM and work out
+       which pages now hold it */
+    ms->cpuProfile.memoryMapChanged(ms->cpu);
+}
+
+/* this function copies the Action Replay codes into the console as offsets into system RAM -
+   codes outside of 0xC000 to 0xDFFF (which prepareCodes leaves as empty entries) are dropped */
+static emubool setupActionReplay(Console ms)
+{
+    /* define variables */
+    emuint i;
+
+    if (!arCheatArray.enabled || arCheatArray.cheatCount == 0)
+        return true;
+
+    ms->arOffsets = calloc(arCheatArray.cheatCount, sizeof(emuint));
+    ms->arValues = calloc(arCheatArray.cheatCount, sizeof(emubyte));
+    if (ms->arOffsets == NULL || ms->arValues == NULL) {
+        __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't allocate memory for Action Replay codes...\n");
+        return false;
+    }
+
+    for (i = 0; i < arCheatArray.cheatCount; ++i) {
+        if (arCheatArray.cheats[i].address < 0xC000 || arCheatArray.cheats[i].address > 0xDFFF)
+            continue;
+        ms->arOffsets[ms->arCount] = arCheatArray.cheats[i].address;
+        ms->arValues[ms->arCount] = arCheatArray.cheats[i].value;
+        ++ms->arCount;
+    }
+
+    return true;
+}
+
+/* this function builds the tables of which Game Genie code (if any) patches each address, for
+   the pages of the address space that have codes in - where several codes patch the same
+   address, the first one wins */
+static emubool setupGameGenie(Console ms)
+{
+    /* define variables */
+    emuint i, page;
+    GgCheat *cheat;
+
+    if (!ggCheatArray.enabled)
+        return true;
+
+    for (i = 0; i < ggCheatArray.cheatCount; ++i) {
+        cheat = &ggCheatArray.cheats[i];
+        if (cheat->address >= CONSOLE_MEMORY_SPACE)
+            continue;
+
+        /* create the table for this page if it doesn't have one yet */
+        page = cheat->address >> CONSOLE_PAGE_SHIFT;
+        if (ms->ggPageCheats[page] == NULL) {
+            ms->ggPageCheats[page] = calloc(CONSOLE_PAGE_SIZE, sizeof(GgCheat *));
+            if (ms->ggPageCheats[page] == NULL) {
+                __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't allocate memory for Game Genie tables...\n");
+                return false;
             }
+            ms->ggPageCompares[page] = false;
+        }
+
+        /* add the code to it */
+        if (ms->ggPageCheats[page][cheat->address & (CONSOLE_PAGE_SIZE - 1)] == NULL) {
+            ms->ggPageCheats[page][cheat->address & (CONSOLE_PAGE_SIZE - 1)] = cheat;
+            if (cheat->cloakAndReferencePresent)
+                ms->ggPageCompares[page] = true;
         }
     }
 
-    ms->systemDataBus = returnVal;
-    return ms->systemDataBus;
+    return true;
 }
 
-/* this function allows the Z80 to check for NMI triggers */
-emubool console_checkNmi(Console ms)
+/* this function returns a copy of the specified page of ROM with the Game Genie codes for that
+   page of the address space applied, making the copy if it doesn't exist yet - NULL is returned
+   if there isn't the memory to make one, so that the page goes through console_memRead instead */
+static emubyte *getPatchedPage(Console ms, emuint page, emubyte *source)
 {
-    /* check if pause button on console is pressed */
-    emubool nmi = controllers_handlePauseStatus(ms->controllers, 0, 0);
+    /* define variables */
+    struct PatchedPage *patched;
+    emuint offset;
 
-    /* reset pause button status */
-    controllers_handlePauseStatus(ms->controllers, 1, false);
+    /* use the existing copy if there is one */
+    for (patched = ms->ggPatchedPages[page]; patched != NULL; patched = patched->next) {
+        if (patched->source == source)
+            return patched->data;
+    }
 
-    return nmi;
+    /* otherwise make a new copy and apply the codes to it */
+    patched = malloc(sizeof(struct PatchedPage));
+    if (patched == NULL) {
+        __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't allocate memory for Game Genie patched page...\n");
+        return NULL;
+    }
+    patched->source = source;
+    memcpy((void *)patched->data, (void *)source, CONSOLE_PAGE_SIZE);
+    for (offset = 0; offset < CONSOLE_PAGE_SIZE; ++offset) {
+        if (ms->ggPageCheats[page][offset] != NULL)
+            patched->data[offset] = ms->ggPageCheats[page][offset]->value;
+    }
+    patched->next = ms->ggPatchedPages[page];
+    ms->ggPatchedPages[page] = patched;
+
+    return patched->data;
 }
 
-/* this function allows the Z80 to check for maskable interrupts from a signalling device */
-emubyte console_checkInterrupt(Console ms)
+/* this function writes the Action Replay codes straight into system RAM, leaving the bus as the
+   last write would have - if the cartridge has RAM mapped over system RAM, the writes go through
+   console_memWrite instead so they reach the cartridge */
+void console_applyActionReplayCodes(Console ms)
 {
-    ms->interruptSignal = vdp_isInterruptAsserted(ms->vdp);
-    return ms->interruptSignal;
+    /* define variables */
+    emuint i;
+
+    if (ms->arCount == 0)
+        return;
+
+    if ((ms->ioAddressSpace[0x3E] & 0x10) == 0 || !cart_isCartOverridingSystemRam(ms->cart)) {
+        for (i = 0; i < ms->arCount; ++i) {
+            if (ms->memoryAddressSpace[ms->arOffsets[i]] != ms->arValues[i]) {
+                ms->memoryAddressSpace[ms->arOffsets[i]] = ms->arValues[i];
+                ms->cpuProfile.memoryWritten(ms->cpu, ms->arOffsets[i]);
+            }
+        }
+        ms->systemAddressBus = ms->arOffsets[ms->arCount - 1];
+        ms->systemDataBus = ms->arValues[ms->arCount - 1];
+    } else {
+        for (i = 0; i < ms->arCount; ++i)
+            console_memWrite(ms, ms->arOffsets[i], ms->arValues[i]);
+    }
 }
 
 /* this function allows the Z80 to tell the signalling device that the interrupt has been handled */
@@ -624,11 +1008,25 @@ void console_interruptHandled(Console ms)
     ms->interruptSignal = 0;
 }
 
-/* this function fills the SDL buffer pointer to by external with the contents of the VDP's
-   internal buffer - it is thread-safe */
-emubool console_handleFrame(Console ms, void *external)
+/* this function returns the newest frame the VDP has finished, or NULL if there hasn't been one since
+   the last call - it doesn't lock, but must only be called from the paint thread, and the frame is
+   only valid until the next call or until the console is destroyed */
+emubyte *console_acquireFrame(Console ms)
 {
-    return vdp_handleFrame(ms->vdp, 2, 0, NULL, external);
+    return vdp_acquireFrame(ms->vdp);
+}
+
+/* this function hands the frame last returned by console_acquireFrame back, so that it is returned
+   again by the next call unless the VDP has finished a newer one by then */
+void console_returnFrame(Console ms)
+{
+    vdp_returnFrame(ms->vdp);
+}
+
+/* this function returns the size of the frames console_acquireFrame returns for the specified pixel format */
+emuint console_getFrameSize(PixelFormat pixelFormat)
+{
+    return vdp_getFrameSize(pixelFormat);
 }
 
 /* this function handles access to I/O port DC */
@@ -686,7 +1084,7 @@ emubyte *console_saveState(Console ms)
     emuint controllersSize = (controllers[3] << 24) | (controllers[2] << 16) | (controllers[1] << 8) | controllers[0];
 
     /* save state of CPU */
-    emubyte *z80 = Z80_saveState(ms->cpu);
+    emubyte *z80 = ms->cpuProfile.saveState(ms->cpu);
     if (z80 == NULL) {
         __android_log_print(ANDROID_LOG_ERROR, "console.c", "Coudn't get Z80 state...\n");
         free((void *)cartridge);
@@ -848,10 +1246,10 @@ emuint console_getMemoryUsage(void)
 }
 
 /* this functions reports how many bytes are required in total by a Console object and all its
-   sub-components */
-emuint console_getWholeMemoryUsage(void)
+   sub-components, when rendering frames in the specified pixel format */
+emuint console_getWholeMemoryUsage(PixelFormat pixelFormat)
 {
-    return console_getMemoryUsage() + Z80_getMemoryUsage() + vdp_getMemoryUsage() + soundchip_getMemoryUsage() +
+    return console_getMemoryUsage() + Z80_getLargestMemoryUsage() + vdp_getMemoryUsage(pixelFormat) + soundchip_getMemoryUsage() +
     controllers_getMemoryUsage() + cart_getMemoryUsage();
 }
 
@@ -866,3 +1264,127 @@ emuint console_getCurrentLine(Console ms)
 {
     return vdp_getCurrentLine(ms->vdp);
 }
+
+#if defined(CONSOLE_PC_SAMPLER)
+/* this struct is one line of the PC sampler's report */
+struct PCSampleEntry {
+    emubool isRom; /* whether the key is a ROM offset, rather than a Z80 address */
+    emuint key;
+    emuint count;
+};
+
+/* this function records where the Z80 is executing from - addresses backed by ROM are counted
+   by their offset into the ROM, so code is attributed to the right place whichever slot and
+   bank registers it was run through, and anything else is counted by its Z80 address */
+static void recordPCSample(Console ms)
+{
+    /* define variables */
+    emuint address = ms->cpuProfile.getProgramCounter(ms->cpu);
+    emubyte *page = ms->readPages[address >> CONSOLE_PAGE_SHIFT];
+    emubyte *byte = NULL;
+    signed_emulong offset = -1;
+
+    /* find the byte being executed - pages with Game Genie codes in are either patched copies
+       or not in the memory map, but the cartridge can still tell us what is there */
+    if (page != NULL && ms->ggPageCheats[address >> CONSOLE_PAGE_SHIFT] == NULL)
+        byte = page + (address & (CONSOLE_PAGE_SIZE - 1));
+    else if (address <= 0xBFFF)
+        byte = cart_getReadPage(ms->cart, address);
+    if (byte != NULL)
+        offset = cart_getRomOffset(ms->cart, byte);
+
+    /* count the sample */
+    if (offset >= 0 && offset < ms->romSize)
+        ++ms->romSamples[offset];
+    else
+        ++ms->otherSamples[address];
+    ++ms->sampleCount;
+}
+
+/* this function orders PC sample entries by count, highest first */
+static int comparePCSampleEntries(const void *first, const void *second)
+{
+    const struct PCSampleEntry *a = (const struct PCSampleEntry *)first;
+    const struct PCSampleEntry *b = (const struct PCSampleEntry *)second;
+
+    if (a->count != b->count)
+        return a->count > b->count ? -1 : 1;
+    return 0;
+}
+
+/* this function writes the PC sampler's counts out - the text report lists each location
+   by sample count, busiest first, and the collapsed file has one line per location in the
+   format used by flame graph tools, with ROM locations grouped by bank - either path can be
+   NULL to skip that file, and false is returned if anything goes wrong */
+emubool console_writePCSampleReport(Console ms, const char *textPath, const char *collapsedPath)
+{
+    /* define variables */
+    emuint entryCount = 0;
+    FILE *textFile = NULL;
+    FILE *collapsedFile = NULL;
+    emubool success = true;
+
+    /* allocate space for the report, and gather up every location with samples */
+    struct PCSampleEntry *entries = malloc(sizeof(struct PCSampleEntry) * (ms->romSize + CONSOLE_MEMORY_SPACE));
+    if (entries == NULL) {
+        __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't allocate memory for PC sample report...\n");
+        return false;
+    }
+    for (emuint i = 0; i < ms->romSize; ++i) {
+        if (ms->romSamples[i] != 0) {
+            entries[entryCount].isRom = true;
+            entries[entryCount].key = i;
+            entries[entryCount++].count = ms->romSamples[i];
+        }
+    }
+    for (emuint i = 0; i < CONSOLE_MEMORY_SPACE; ++i) {
+        if (ms->otherSamples[i] != 0) {
+            entries[entryCount].isRom = false;
+            entries[entryCount].key = i;
+            entries[entryCount++].count = ms->otherSamples[i];
+        }
+    }
+    qsort((void *)entries, entryCount, sizeof(struct PCSampleEntry), comparePCSampleEntries);
+
+    /* write text report */
+    if (textPath != NULL) {
+        if ((textFile = fopen(textPath, "w")) == NULL) {
+            __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't create PC sample report at %s\n", textPath);
+            success = false;
+        } else {
+            fprintf(textFile, "%llu samples, one every %u cycles\n", (unsigned long long)ms->sampleCount, CONSOLE_SAMPLE_INTERVAL);
+            for (emuint i = 0; i < entryCount; ++i) {
+                if (entries[i].isRom)
+                    fprintf(textFile, "ROM %06X (bank %02X offset %04X): ", entries[i].key, entries[i].key / 16384, entries[i].key % 16384);
+                else
+                    fprintf(textFile, "Z80 %04X: ", entries[i].key);
+                fprintf(textFile, "%u samples (%.2f%%)\n", entries[i].count, 100.0 * (double)entries[i].count / (double)ms->sampleCount);
+            }
+            if (fclose(textFile) != 0)
+                success = false;
+        }
+    }
+
+    /* write collapsed stack file */
+    if (collapsedPath != NULL) {
+        if ((collapsedFile = fopen(collapsedPath, "w")) == NULL) {
+            __android_log_print(ANDROID_LOG_ERROR, "console.c", "Couldn't create PC sample report at %s\n", collapsedPath);
+            success = false;
+        } else {
+            for (emuint i = 0; i < entryCount; ++i) {
+                if (entries[i].isRom)
+                    fprintf(collapsedFile, "ROM;bank_%02X;%06X %u\n", entries[i].key / 16384, entries[i].key, entries[i].count);
+                else
+                    fprintf(collapsedFile, "Z80;%04X %u\n", entries[i].key, entries[i].count);
+            }
+            if (fclose(collapsedFile) != 0)
+                success = false;
+        }
+    }
+
+    /* free report memory */
+    free((void *)entries);
+
+    return success;
+}
+#endif
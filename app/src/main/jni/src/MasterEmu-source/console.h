@@ -10,19 +10,40 @@
 /* define opaque pointer type for dealing with the Master System console */
 typedef struct Console *Console;
 
+/* the Z80 address space is split into 1KB pages for the memory map */
+#define CONSOLE_PAGE_SHIFT 10
+#define CONSOLE_PAGE_SIZE 1024
+#define CONSOLE_PAGE_COUNT 64
+
+/* these are the events the console's scheduler can run */
+typedef enum {
+    CONSOLE_EVENT_LINE, /* the VDP is due to process a line */
+    CONSOLE_EVENT_INTERRUPT, /* the VDP's interrupt output may have changed */
+    CONSOLE_EVENT_PAUSE, /* the pause button has been pressed */
+    CONSOLE_EVENT_SAMPLE, /* the PC sampler is due to take a sample, when compiled in */
+    CONSOLE_EVENT_COUNT
+} ConsoleEvent;
+
 /* function declarations for public use */
-Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecksum, emubool isCodemasters, emubool isGameGear, emubool isPal, SDL_Rect *sourceRect, emubyte *saveState, emuint params, emubyte *wholePointer, emuint audioId); /* this sets up a full Master System console */
+Console createConsole(emubyte *romData, signed_emulong romSize, emuint romChecksum, emubool isCodemasters, emubool isGameGear, emubool isPal, PixelFormat pixelFormat, SDL_Rect *sourceRect, emubyte *saveState, emuint params, emubyte *wholePointer, emuint audioId); /* this sets up a full Master System console */
 void destroyConsole(Console ms); /* this destroys the console object */
 void console_ioWrite(Console ms, emuint address, emubyte data); /* this deals with Z80 IO port writes */
 emubyte console_ioRead(Console ms, emuint address); /* this deals with Z80 IO port reads */
 void console_memWrite(Console ms, emuint address, emubyte data); /* this deals with memory space writes */
 emubyte console_memRead(Console ms, emuint address); /* this deals with memory space reads */
-emubool console_checkNmi(Console ms); /* this lets the Z80 check for NMI triggers */
-emubyte console_checkInterrupt(Console ms); /* this lets the Z80 check for maskable interrupts */
+emubyte **console_getReadPages(Console ms); /* returns the table of pages the Z80 can read directly, NULL entries need console_memRead */
+emubyte **console_getWritePages(Console ms); /* returns the table of pages the Z80 can write directly, NULL entries need console_memWrite */
+emuint console_getBankState(Console ms); /* returns the cartridge's mapping registers, packed as by cart_getBankState */
+emubool console_isBlockIOPort(Console ms, emuint address); /* returns whether repeating block I/O instructions can run without returning for this port */
+emubool console_isIdlePollPort(Console ms, emuint address); /* returns whether an idle loop polling this port can be skipped through */
+void console_scheduleEvent(Console ms, ConsoleEvent event, emuint delay); /* schedules an event to run after the specified number of Z80 cycles */
+void console_applyActionReplayCodes(Console ms); /* writes the Action Replay codes to RAM, which the VDP does at each frame interrupt */
 void console_interruptHandled(Console ms); /* this tells the signalling device that the Z80 has handled the interrupt */
 typedef struct EmuBundle EmuBundle;
-emuint console_executeInstruction(EmuBundle *eb); /* this executes the console for one instruction of Z80 time */
-emubool console_handleFrame(Console ms, void *external); /* updates the SDL frame buffer from the VDP frame buffer */
+emuint console_runUntil(EmuBundle *eb, emuint cycles); /* this runs the console until at least the specified number of cycles have passed */
+emubyte *console_acquireFrame(Console ms); /* returns the newest finished frame for the paint thread, or NULL if there is no new one */
+void console_returnFrame(Console ms); /* hands the last acquired frame back to be acquired again, for when it couldn't be displayed */
+emuint console_getFrameSize(PixelFormat pixelFormat); /* returns the number of bytes in a frame of the specified pixel format */
 emubyte console_handleTempDC(Console ms, emubyte action, emubyte value); /* handles port DC access */
 emubool console_handleTempPauseStatus(Console ms, emubyte action, emubool value); /* handles pause access */
 void console_tellVDPToStoreHCounterValue(Console ms); /* this function signals the internal VDP to calculate the current
@@ -33,9 +54,12 @@ emubyte *console_saveState(Console ms); /* returns a pointer to the memory state
 SDL_Rect *console_getSourceRect(Console ms); /* gets the source rect of the VDP */
 emubyte console_readPSGReg(Console ms); /* returns contents of GG register at IO port 0x06 */
 void console_stopAudio(Console ms); /* stops the SDL sound channel */
-emuint console_getWholeMemoryUsage(void); /* reports memory usage for Console object and all sub-components */
+emuint console_getWholeMemoryUsage(PixelFormat pixelFormat); /* reports memory usage for Console object and all sub-components */
 emuint console_getMemoryUsage(void); /* reports memory usage for Console object only */
 emuint console_getAudioDeviceID(Console ms); /* this function returns the current SDL AudioDeviceID from the sound chip */
 emuint console_getCurrentLine(Console ms); /* this function returns the current line from the VDP */
+#if defined(CONSOLE_PC_SAMPLER)
+emubool console_writePCSampleReport(Console ms, const char *textPath, const char *collapsedPath); /* writes the PC sampler's counts as text and as collapsed stacks */
+#endif
 
 #endif
@@ -234,9 +234,11 @@ emubool controllers_handleTempPauseStatus(Controllers ct, emubyte action, emuboo
             case 0: returnValue = ct->tempPauseButton; break; /* read button */
             case 1: ct->tempPauseButton = value; break; /* write button */
             case 2: ct->pauseButton = ct->tempPauseButton;
-                    if (ct->tempPauseButton)
+                    if (ct->tempPauseButton) {
                         ct->tempPauseButton = false;
-                    break; /* copy temp value to real value */
+                        console_scheduleEvent(ct->ms, CONSOLE_EVENT_PAUSE, 0);
+                    }
+                    break; /* copy temp value to real value, and have the console trigger an NMI if pressed */
         }
         
         /* now unlock mutex */
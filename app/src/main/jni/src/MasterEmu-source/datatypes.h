@@ -17,6 +17,10 @@ typedef uint64_t emulong; /* for unsigned return values from some functions */
 typedef bool emubool; /* for boolean values */
 typedef float emufloat; /* for floating point values */
 
+/* this enumerated type selects the pixel format the VDP renders frames in */
+enum PixelFormat { FORMAT_BGR24 = 0, FORMAT_RGB565 = 1, FORMAT_XRGB8888 = 2, FORMAT_INDEXED8 = 3 };
+typedef enum PixelFormat PixelFormat;
+
 typedef struct {
     emubyte value;
     emuint address;
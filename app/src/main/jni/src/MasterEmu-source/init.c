@@ -39,6 +39,7 @@ int start_emulator(JNIEnv *env, jclass cls, jobject obj, jbyteArray romData, jin
     ec.isGameGear = false;
     ec.isCodemasters = false;
     ec.isPal = false;
+    ec.pixelFormat = FORMAT_XRGB8888;
     ec.touches.up = -1;
     ec.touches.down = -1;
     ec.touches.left = -1;
@@ -72,6 +73,14 @@ int start_emulator(JNIEnv *env, jclass cls, jobject obj, jbyteArray romData, jin
     if ((ec.params & 0x40) == 0x40)
         ec.noStretching = true;
 
+    /* see if frames should be rendered in 16-bit or paletted form - otherwise they are
+       rendered in XRGB8888, which copies into the texture without conversion - paletted
+       frames aren't offered in the options, as expanding them is slower than that copy */
+    if ((ec.params & 0x200) == 0x200)
+        ec.pixelFormat = FORMAT_RGB565;
+    else if ((ec.params & 0x400) == 0x400)
+        ec.pixelFormat = FORMAT_INDEXED8;
+
     /* load ROM by converting jbyteArray to usable form */
     jbyte *byteRomData = (*env)->GetByteArrayElements(env, romData, NULL);
     if (util_loadRom(&ec, byteRomData, romSize) == NULL) {
@@ -100,12 +109,12 @@ int start_emulator(JNIEnv *env, jclass cls, jobject obj, jbyteArray romData, jin
     util_loadState(&ec, "current_state.mesav", &saveState);
 
     /* setup console */
-    ec.consoleMemoryPointer = malloc(console_getWholeMemoryUsage());
+    ec.consoleMemoryPointer = malloc(console_getWholeMemoryUsage(ec.pixelFormat));
     if (ec.consoleMemoryPointer == NULL) {
         __android_log_print(ANDROID_LOG_ERROR, "init.c", "Error allocating console memory, aborting...");
         return ERROR_ALLOCATING_CONSOLE_MEMORY;
     }
-    ec.console = createConsole(ec.romData, ec.romSize, ec.romChecksum, ec.isCodemasters, ec.isGameGear, ec.isPal, s->sourceRect, saveState, ec.params, ec.consoleMemoryPointer, 0);
+    ec.console = createConsole(ec.romData, ec.romSize, ec.romChecksum, ec.isCodemasters, ec.isGameGear, ec.isPal, ec.pixelFormat, s->sourceRect, saveState, ec.params, ec.consoleMemoryPointer, 0);
     if (ec.console == NULL) {
         __android_log_print(ANDROID_LOG_ERROR, "init.c", "Error creating console, aborting...");
         return ERROR_UNABLE_TO_CREATE_CONSOLE;
@@ -188,8 +197,7 @@ static int LogicFunction(void *p) {
 
     while (SDL_AtomicGet(&eb->logicQuit) == 0) {
         clock_gettime(CLOCK_MONOTONIC, &t1);
-        while ((cycles += console_executeInstruction(eb)) < cyclesPerFrame && SDL_AtomicGet(&eb->logicQuit) == 0)
-            ;
+        cycles += console_runUntil(eb, cyclesPerFrame - cycles);
         cycles -= cyclesPerFrame;
         do {
             clock_gettime(CLOCK_MONOTONIC, &t2);
@@ -330,18 +338,22 @@ JNIEXPORT void JNICALL Java_uk_co_philpotter_masteremu_StateBrowser_loadStateStu
         SDL_Rect *sourceRect = console_getSourceRect((*ec).console);
         emuint audioId = console_getAudioDeviceID((*ec).console);
 
-        /* destroy console */
-        destroyConsole((*ec).console);
+        /* destroy console - painting was stopped when the emulator was paused, so no frame
+           acquired from it is still in use, and clearing the pointer stops any new ones
+           being acquired until its replacement is ready */
+        Console oldConsole = (*ec).console;
+        (*ec).console = NULL;
+        destroyConsole(oldConsole);
         free((void *)(*ec).consoleMemoryPointer);
 
         /* recreate console, masking sRam only flag */
         emuint tempParams = (*ec).params;
         tempParams &= 0xFFFFFFFD;
-        (*ec).consoleMemoryPointer = malloc(console_getWholeMemoryUsage());
+        (*ec).consoleMemoryPointer = malloc(console_getWholeMemoryUsage((*ec).pixelFormat));
         if ((*ec).consoleMemoryPointer == NULL) {
             __android_log_print(ANDROID_LOG_ERROR, "init.c", "Error allocating console memory...");
         }
-        (*ec).console = createConsole((*ec).romData, (*ec).romSize, (*ec).romChecksum, (*ec).isCodemasters, (*ec).isGameGear, (*ec).isPal, sourceRect, saveState, tempParams, (*ec).consoleMemoryPointer, audioId);
+        (*ec).console = createConsole((*ec).romData, (*ec).romSize, (*ec).romChecksum, (*ec).isCodemasters, (*ec).isGameGear, (*ec).isPal, (*ec).pixelFormat, sourceRect, saveState, tempParams, (*ec).consoleMemoryPointer, audioId);
         if ((*ec).console == NULL) {
             __android_log_print(ANDROID_LOG_ERROR, "init.c", "Error creating console...");
         }
@@ -0,0 +1,293 @@
+/* MasterEmu pixel kernel source code file
+   copyright Phil Potter, 2024 */
+
+#include <android/log.h>
+#include "../../SDL-release-2.30.2/include/SDL.h"
+#include "pixel.h"
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define PIXEL_X86
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define PIXEL_NEON
+#endif
+
+/* these functions are the portable versions of the kernels, which every CPU can fall back on */
+static void decodePatternScalar(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes);
+static void lookupLineScalar(const emubyte *indexes, emuint paletteBase, emuint *pixels);
+static emubool blendLineScalar(emuint *scanline, const emuint *pixels, emubool priority);
+
+#if defined(PIXEL_X86)
+/* these functions use SSSE3, which the Android x86 and x86_64 ABIs both guarantee */
+static void decodePatternSSSE3(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes);
+static void lookupLineSSE2(const emubyte *indexes, emuint paletteBase, emuint *pixels);
+static emubool blendLineSSE2(emuint *scanline, const emuint *pixels, emubool priority);
+
+/* these functions use AVX2, so must only be called once the CPU has been checked for it */
+static void lookupLineAVX2(const emubyte *indexes, emuint paletteBase, emuint *pixels);
+static emubool blendLineAVX2(emuint *scanline, const emuint *pixels, emubool priority);
+#endif
+
+#if defined(PIXEL_NEON)
+/* these functions use NEON, which some older 32-bit ARM CPUs lack */
+static void decodePatternNEON(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes);
+static void lookupLineNEON(const emubyte *indexes, emuint paletteBase, emuint *pixels);
+static emubool blendLineNEON(emuint *scanline, const emuint *pixels, emubool priority);
+#endif
+
+/* this function fills in the fastest kernels supported by this CPU */
+void pixel_selectKernels(PixelKernels *k)
+{
+    /* start with the portable kernels */
+    k->decodePattern = decodePatternScalar;
+    k->lookupLine = lookupLineScalar;
+    k->blendLine = blendLineScalar;
+    k->name = "scalar";
+
+#if defined(PIXEL_X86)
+    k->decodePattern = decodePatternSSSE3;
+    k->lookupLine = lookupLineSSE2;
+    k->blendLine = blendLineSSE2;
+    k->name = "SSSE3";
+    if (SDL_HasAVX2()) {
+        k->lookupLine = lookupLineAVX2;
+        k->blendLine = blendLineAVX2;
+        k->name = "AVX2";
+    }
+#elif defined(PIXEL_NEON)
+    if (SDL_HasNEON()) {
+        k->decodePattern = decodePatternNEON;
+        k->lookupLine = lookupLineNEON;
+        k->blendLine = blendLineNEON;
+        k->name = "NEON";
+    }
+#endif
+
+    __android_log_print(ANDROID_LOG_VERBOSE, "pixel.c", "Using %s pixel kernels", k->name);
+}
+
+/* this function converts a pattern from its four bitplanes into palette indexes - each line
+   is four bytes, one per bitplane, with the leftmost pixel in bit 7 */
+static void decodePatternScalar(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes)
+{
+    /* define variables */
+    emuint l, p;
+
+    for (l = 0; l < 8; ++l, planar += 4, indexes += 8, flippedIndexes += 8) {
+        for (p = 0; p < 8; ++p) {
+            emubyte index = (((planar[3] >> (7 - p)) & 0x01) << 3) |
+                            (((planar[2] >> (7 - p)) & 0x01) << 2) |
+                            (((planar[1] >> (7 - p)) & 0x01) << 1) |
+                            ((planar[0] >> (7 - p)) & 0x01);
+            indexes[p] = index;
+            flippedIndexes[7 - p] = index;
+        }
+    }
+}
+
+/* this function converts a line of palette indexes into pixels */
+static void lookupLineScalar(const emubyte *indexes, emuint paletteBase, emuint *pixels)
+{
+    /* define variables */
+    emuint p;
+
+    for (p = 0; p < 8; ++p)
+        pixels[p] = (indexes[p] == 0 ? 0x01000000 : 0xFF000000) | (paletteBase + indexes[p]);
+}
+
+/* this function merges a line of pixels into the scanline */
+static emubool blendLineScalar(emuint *scanline, const emuint *pixels, emubool priority)
+{
+    /* define variables */
+    emubool collision = false;
+    emuint p;
+
+    for (p = 0; p < 8; ++p) {
+        if ((scanline[p] & 0xFF000000) != 0xFF000000) {
+            scanline[p] = pixels[p];
+        } else if ((pixels[p] & 0xFF000000) == 0xFF000000) {
+            collision = true;
+            if (priority)
+                scanline[p] = pixels[p];
+        }
+    }
+
+    return collision;
+}
+
+#if defined(PIXEL_X86)
+/* this function converts a pattern two lines at a time - each bitplane byte is shuffled out to
+   the eight pixels it covers, then compared against that pixel's bit to give its share of the index */
+__attribute__((target("ssse3")))
+static void decodePatternSSSE3(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes)
+{
+    /* define variables */
+    __m128i lines[2];
+    __m128i bits = _mm_setr_epi8((char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+                                 (char)0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01);
+    __m128i flippedBits = _mm_setr_epi8(0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80,
+                                        0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, (char)0x80);
+    __m128i linePair = _mm_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 4, 4, 4, 4, 4, 4, 4, 4);
+    emuint l, plane;
+
+    lines[0] = _mm_loadu_si128((const __m128i *)planar);
+    lines[1] = _mm_loadu_si128((const __m128i *)(planar + 16));
+
+    for (l = 0; l < 8; l += 2) {
+        __m128i source = lines[l >> 2];
+        __m128i result = _mm_setzero_si128();
+        __m128i flippedResult = _mm_setzero_si128();
+        for (plane = 0; plane < 4; ++plane) {
+            __m128i spread = _mm_shuffle_epi8(source, _mm_add_epi8(linePair, _mm_set1_epi8(((l & 3) * 4) + plane)));
+            __m128i weight = _mm_set1_epi8(1 << plane);
+            result = _mm_or_si128(result, _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(spread, bits), bits), weight));
+            flippedResult = _mm_or_si128(flippedResult,
+                                         _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(spread, flippedBits), flippedBits), weight));
+        }
+        _mm_storeu_si128((__m128i *)(indexes + (l * 8)), result);
+        _mm_storeu_si128((__m128i *)(flippedIndexes + (l * 8)), flippedResult);
+    }
+}
+
+/* this function converts a line of palette indexes into pixels four at a time */
+static void lookupLineSSE2(const emubyte *indexes, emuint paletteBase, emuint *pixels)
+{
+    /* define variables */
+    __m128i zero = _mm_setzero_si128();
+    __m128i base = _mm_set1_epi32(paletteBase);
+    __m128i opaque = _mm_set1_epi32(0xFF000000);
+    __m128i transparent = _mm_set1_epi32(0x01000000);
+    __m128i index[2];
+    emuint p;
+
+    index[0] = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)indexes), zero);
+    index[1] = _mm_unpackhi_epi16(index[0], zero);
+    index[0] = _mm_unpacklo_epi16(index[0], zero);
+
+    for (p = 0; p < 2; ++p) {
+        __m128i isZero = _mm_cmpeq_epi32(index[p], zero);
+        __m128i flag = _mm_or_si128(_mm_and_si128(isZero, transparent), _mm_andnot_si128(isZero, opaque));
+        _mm_storeu_si128((__m128i *)(pixels + (p * 4)), _mm_or_si128(flag, _mm_add_epi32(index[p], base)));
+    }
+}
+
+/* this function merges a line of pixels into the scanline four at a time - a pixel is opaque
+   exactly when its top bit is set, as the only alpha values used are 0, 0x01 and 0xFF */
+static emubool blendLineSSE2(emuint *scanline, const emuint *pixels, emubool priority)
+{
+    /* define variables */
+    __m128i zero = _mm_setzero_si128();
+    __m128i priorityMask = priority ? _mm_set1_epi32(-1) : zero;
+    __m128i collisions = zero;
+    emuint p;
+
+    for (p = 0; p < 8; p += 4) {
+        __m128i existing = _mm_loadu_si128((const __m128i *)(scanline + p));
+        __m128i incoming = _mm_loadu_si128((const __m128i *)(pixels + p));
+        __m128i existingOpaque = _mm_cmplt_epi32(existing, zero);
+        __m128i incomingOpaque = _mm_cmplt_epi32(incoming, zero);
+        __m128i keep = _mm_andnot_si128(_mm_and_si128(priorityMask, incomingOpaque), existingOpaque);
+        _mm_storeu_si128((__m128i *)(scanline + p),
+                         _mm_or_si128(_mm_and_si128(keep, existing), _mm_andnot_si128(keep, incoming)));
+        collisions = _mm_or_si128(collisions, _mm_and_si128(existingOpaque, incomingOpaque));
+    }
+
+    return _mm_movemask_epi8(collisions) != 0;
+}
+
+/* this function converts a line of palette indexes into pixels in one go */
+__attribute__((target("avx2")))
+static void lookupLineAVX2(const emubyte *indexes, emuint paletteBase, emuint *pixels)
+{
+    /* define variables */
+    __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)indexes));
+    __m256i flag = _mm256_blendv_epi8(_mm256_set1_epi32(0xFF000000), _mm256_set1_epi32(0x01000000),
+                                      _mm256_cmpeq_epi32(index, _mm256_setzero_si256()));
+
+    _mm256_storeu_si256((__m256i *)pixels, _mm256_or_si256(flag, _mm256_add_epi32(index, _mm256_set1_epi32(paletteBase))));
+}
+
+/* this function merges a whole line of pixels into the scanline at once */
+__attribute__((target("avx2")))
+static emubool blendLineAVX2(emuint *scanline, const emuint *pixels, emubool priority)
+{
+    /* define variables */
+    __m256i zero = _mm256_setzero_si256();
+    __m256i existing = _mm256_loadu_si256((const __m256i *)scanline);
+    __m256i incoming = _mm256_loadu_si256((const __m256i *)pixels);
+    __m256i existingOpaque = _mm256_cmpgt_epi32(zero, existing);
+    __m256i incomingOpaque = _mm256_cmpgt_epi32(zero, incoming);
+    __m256i replace = _mm256_andnot_si256(existingOpaque, _mm256_set1_epi32(-1));
+
+    if (priority)
+        replace = _mm256_or_si256(replace, incomingOpaque);
+    _mm256_storeu_si256((__m256i *)scanline, _mm256_blendv_epi8(existing, incoming, replace));
+
+    return !_mm256_testz_si256(existingOpaque, incomingOpaque);
+}
+#endif
+
+#if defined(PIXEL_NEON)
+/* this function converts a pattern a line at a time - each bitplane byte is duplicated across
+   the line and tested against each pixel's bit to give its share of the index */
+static void decodePatternNEON(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes)
+{
+    /* define variables */
+    static const emubyte bitValues[8] = { 0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01 };
+    static const emubyte flippedBitValues[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+    uint8x8_t bits = vld1_u8(bitValues);
+    uint8x8_t flippedBits = vld1_u8(flippedBitValues);
+    emuint l, plane;
+
+    for (l = 0; l < 8; ++l, planar += 4) {
+        uint8x8_t result = vdup_n_u8(0);
+        uint8x8_t flippedResult = vdup_n_u8(0);
+        for (plane = 0; plane < 4; ++plane) {
+            uint8x8_t spread = vdup_n_u8(planar[plane]);
+            uint8x8_t weight = vdup_n_u8(1 << plane);
+            result = vorr_u8(result, vand_u8(vtst_u8(spread, bits), weight));
+            flippedResult = vorr_u8(flippedResult, vand_u8(vtst_u8(spread, flippedBits), weight));
+        }
+        vst1_u8(indexes + (l * 8), result);
+        vst1_u8(flippedIndexes + (l * 8), flippedResult);
+    }
+}
+
+/* this function converts a line of palette indexes into pixels four at a time */
+static void lookupLineNEON(const emubyte *indexes, emuint paletteBase, emuint *pixels)
+{
+    /* define variables */
+    uint16x8_t index = vmovl_u8(vld1_u8(indexes));
+    uint32x4_t base = vdupq_n_u32(paletteBase);
+    uint32x4_t opaque = vdupq_n_u32(0xFF000000);
+    uint32x4_t transparent = vdupq_n_u32(0x01000000);
+    uint32x4_t low = vmovl_u16(vget_low_u16(index));
+    uint32x4_t high = vmovl_u16(vget_high_u16(index));
+
+    vst1q_u32(pixels, vorrq_u32(vbslq_u32(vceqq_u32(low, vdupq_n_u32(0)), transparent, opaque), vaddq_u32(low, base)));
+    vst1q_u32(pixels + 4, vorrq_u32(vbslq_u32(vceqq_u32(high, vdupq_n_u32(0)), transparent, opaque), vaddq_u32(high, base)));
+}
+
+/* this function merges a line of pixels into the scanline four at a time */
+static emubool blendLineNEON(emuint *scanline, const emuint *pixels, emubool priority)
+{
+    /* define variables */
+    uint32x4_t priorityMask = vdupq_n_u32(priority ? 0xFFFFFFFF : 0);
+    uint32x4_t collisions = vdupq_n_u32(0);
+    uint32x2_t folded;
+    emuint p;
+
+    for (p = 0; p < 8; p += 4) {
+        uint32x4_t existing = vld1q_u32(scanline + p);
+        uint32x4_t incoming = vld1q_u32(pixels + p);
+        uint32x4_t existingOpaque = vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(existing), 31));
+        uint32x4_t incomingOpaque = vreinterpretq_u32_s32(vshrq_n_s32(vreinterpretq_s32_u32(incoming), 31));
+        uint32x4_t replace = vorrq_u32(vmvnq_u32(existingOpaque), vandq_u32(priorityMask, incomingOpaque));
+        vst1q_u32(scanline + p, vbslq_u32(replace, incoming, existing));
+        collisions = vorrq_u32(collisions, vandq_u32(existingOpaque, incomingOpaque));
+    }
+
+    folded = vorr_u32(vget_low_u32(collisions), vget_high_u32(collisions));
+    return (vget_lane_u32(folded, 0) | vget_lane_u32(folded, 1)) != 0;
+}
+#endif
@@ -0,0 +1,28 @@
+/* MasterEmu pixel kernel header file
+   copyright Phil Potter, 2024 */
+
+#ifndef PIXEL_INCLUDE
+#define PIXEL_INCLUDE
+#include "datatypes.h"
+
+/* this struct holds the mode 4 pixel kernels chosen for the CPU we are running on - pixels hold
+   a palette entry in their low byte, and a top byte of 0xFF if opaque, 0x01 if transparent, or 0
+   if nothing is there yet */
+typedef struct {
+    void (*decodePattern)(const emubyte *planar, emubyte *indexes, emubyte *flippedIndexes); /* converts the 32 planar bytes of a
+                                                                                                  pattern into 64 palette indexes,
+                                                                                                  plus a horizontally flipped copy */
+    void (*lookupLine)(const emubyte *indexes, emuint paletteBase, emuint *pixels); /* converts 8 palette indexes into 8 pixels from the
+                                                                                       16 entry palette starting at paletteBase, index 0
+                                                                                       being transparent */
+    emubool (*blendLine)(emuint *scanline, const emuint *pixels, emubool priority); /* merges 8 pixels into the scanline - each pixel replaces
+                                                                                      anything that isn't opaque, or anything at all if
+                                                                                      priority is set and the pixel is opaque - and returns
+                                                                                      whether any opaque pixel met an opaque one */
+    const char *name; /* this names the instruction set the kernels use */
+} PixelKernels;
+
+/* function declarations for public use */
+void pixel_selectKernels(PixelKernels *k); /* fills in the fastest kernels supported by this CPU */
+
+#endif
@@ -232,7 +232,7 @@ void soundchip_soundWrite(SN76489 s, emubyte b)
 void soundchip_executeCycles(SN76489 s, emuint c)
 {
     s->z80Cycles = s->z80Cycles + c;
-    if (s->z80Cycles >= 16) {
+    while (s->z80Cycles >= 16) {
         /* reset cycle count, compensating if number of cycles is over 16 */
         s->z80Cycles = s->z80Cycles - 16;
 
@@ -11,6 +11,9 @@
 #include "init.h"
 #include "../../SDL_image-release-2.8.2/include/SDL_image.h"
 
+/* internal function prototypes */
+static void copyFrameToTexture(EmulatorContainer *ec, emubyte *frame, emubyte *pixels, int pitch);
+
 /* this function deals with setting up SDL and initialising all needed structures */
 SDL_Collection util_setupSDL(JNIEnv *env, jclass cls, jobject obj, EmulatorContainer *ec, emubool noStretching, emubool isGameGear, emubool largerButtons, emubool fromResume)
 {
@@ -63,12 +66,6 @@ SDL_Collection util_setupSDL(JNIEnv *env, jclass cls, jobject obj, EmulatorConta
         s->sourceRect->h = 192;
     }
 
-    /* setup double buffer - zero out the memory in case we are using controller mapping mode */
-    if ((s->displayFrame = calloc(1, sizeof(emubyte) * 184320)) == NULL) {
-        __android_log_print(ANDROID_LOG_ERROR, "util.c", "Couldn't allocate space for display frame buffer...");
-        return NULL;
-    }
-
     /* setup window SDL rectangle */
     SDL_DisplayMode m;
     if (SDL_GetCurrentDisplayMode(0, &m) < 0) {
@@ -104,9 +101,16 @@ SDL_Collection util_setupSDL(JNIEnv *env, jclass cls, jobject obj, EmulatorConta
         return NULL;
     }
 
-    /* create SDL streaming texture */
+    /* create SDL streaming texture in the format the VDP renders in - indexed frames are
+       expanded to 32-bit pixels when they are copied in */
+    Uint32 textureFormat = SDL_PIXELFORMAT_XRGB8888;
+    switch (ec->pixelFormat) {
+        case FORMAT_BGR24: textureFormat = SDL_PIXELFORMAT_BGR24; break;
+        case FORMAT_RGB565: textureFormat = SDL_PIXELFORMAT_RGB565; break;
+        default: break;
+    }
     s->texture = SDL_CreateTexture(s->renderer,
-        SDL_PIXELFORMAT_BGR24,
+        textureFormat,
         SDL_TEXTUREACCESS_STREAMING,
         256, 240);
     if (s->texture == 0) {
@@ -114,6 +118,16 @@ SDL_Collection util_setupSDL(JNIEnv *env, jclass cls, jobject obj, EmulatorConta
         return NULL;
     }
 
+    /* blank the texture, as it is only updated when a frame is ready, and controller mapping mode never has one */
+    void *texturePixels = NULL;
+    int texturePitch = 0;
+    if (SDL_LockTexture(s->texture, NULL, &texturePixels, &texturePitch) != 0) {
+        __android_log_print(ANDROID_LOG_ERROR, "util.c", "Couldn't lock texture: %s\n", SDL_GetError());
+        return NULL;
+    }
+    memset(texturePixels, 0, texturePitch * 240);
+    SDL_UnlockTexture(s->texture);
+
     /* setup controller rectangles and textures */
     SDL_RWops *dpadFile = SDL_RWFromFile("dpad.png", "rb");
     if (dpadFile == NULL) {
@@ -353,9 +367,6 @@ void util_shutdownSDL(SDL_Collection s, emubool fromResume)
     if (!fromResume)
         SDL_Quit();
 
-    /* deallocate memory for display frame buffer */
-    free((void *)s->displayFrame);
-
     /* deallocate memory for SDL collection object */
     free((void *)s);
 }
@@ -426,6 +437,33 @@ emubool util_isPalOnlyROM(emuint checksum)
     return returnVal;
 }
 
+/* this function copies a frame from the VDP into a locked texture, row by row
+   as the texture's pitch can be wider than the frame */
+static void copyFrameToTexture(EmulatorContainer *ec, emubyte *frame, emubyte *pixels, int pitch)
+{
+    /* define variables */
+    emuint row, i;
+
+    if (ec->pixelFormat == FORMAT_INDEXED8) {
+        /* expand each line through the colours it was rendered with */
+        emubyte *indexes = frame;
+        emuint *colours = (emuint *)(frame + (256 * 240));
+        for (row = 0; row < 240; ++row, indexes += 256, colours += 32, pixels += pitch) {
+            Uint32 *destination = (Uint32 *)pixels;
+            for (i = 0; i < 256; ++i)
+                destination[i] = colours[indexes[i]];
+        }
+    } else {
+        emuint rowSize = console_getFrameSize(ec->pixelFormat) / 240;
+        if ((emuint)pitch == rowSize) {
+            memcpy((void *)pixels, (void *)frame, rowSize * 240);
+        } else {
+            for (row = 0; row < 240; ++row, pixels += pitch)
+                memcpy((void *)pixels, (void *)(frame + (row * rowSize)), rowSize);
+        }
+    }
+}
+
 /* this function redraws the frame */
 void util_paintFrame(EmuBundle *eb)
 {
@@ -440,26 +478,24 @@ void util_paintFrame(EmuBundle *eb)
     /* fetch relevant parameters */
     emubool noButtons = (ec->params >> 3) & 0x01;
 
-    /* lock texture */
-    int pitch = 0;
-    void *pixels = NULL;
-    if (SDL_LockTexture(s->texture, NULL, &pixels, &pitch) != 0) {
-        __android_log_print(ANDROID_LOG_ERROR, "util.c", "Couldn't lock texture: %s\n", SDL_GetError());
-        return;
-    }
-
-    /* check pitch is correct size */
-    if (pitch != 768) {
-        __android_log_print(ANDROID_LOG_ERROR, "util.c", "incorrect pitch size...\n");
-        return;
+    /* if the VDP has finished a frame since the last paint, copy it straight into the
+       texture - otherwise the texture still holds the last one - the frame is only used
+       within this paint, as the console it belongs to is only replaced while painting
+       is stopped */
+    emubyte *frame = ec->console != NULL ? console_acquireFrame(ec->console) : NULL;
+    if (frame != NULL) {
+        int pitch = 0;
+        void *pixels = NULL;
+        if (SDL_LockTexture(s->texture, NULL, &pixels, &pitch) != 0) {
+            /* hand the frame back so the next paint can try again with it */
+            __android_log_print(ANDROID_LOG_ERROR, "util.c", "Couldn't lock texture: %s\n", SDL_GetError());
+            console_returnFrame(ec->console);
+            return;
+        }
+        copyFrameToTexture(ec, frame, (emubyte *)pixels, pitch);
+        SDL_UnlockTexture(s->texture);
     }
 
-    /* copy pixels from display frame buffer to our SDL buffer */
-    memcpy((void *)pixels, (void *)s->displayFrame, 184320);
-
-    /* unlock texture */
-    SDL_UnlockTexture(s->texture);
-
     /* present pixels */
     SDL_RenderClear(s->renderer);
     SDL_RenderCopy(s->renderer, s->texture, s->sourceRect, s->windowRect);
@@ -1447,9 +1483,6 @@ void util_dealWithButtons(EmuBundle *eb)
    where we poll the state of the controller if one is attached */
 void util_triggerPainting(EmuBundle *eb)
 {
-    /* mirror VDP buffer to display frame buffer - should help prevent tearing */
-    console_handleFrame(eb->ec->console, (void *)eb->s->displayFrame);
-
     /* poll controller here */
     util_dealWithButtons(eb);
 
@@ -48,7 +48,6 @@ struct SDL_Collection {
     emuint usableScreenWidth;
     emuint usableScreenHeight;
     int pixelsForOneInch;
-    emubyte *displayFrame;
 };
 typedef struct SDL_Collection *SDL_Collection;
 
@@ -97,6 +96,7 @@ struct EmulatorContainer {
     emubool isCodemasters;
     emubool isPal;
     emuint params;
+    PixelFormat pixelFormat;
     Console console;
     emubyte *romData;
     signed_emulong romSize;
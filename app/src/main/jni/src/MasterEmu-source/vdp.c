@@ -6,9 +6,10 @@
 #include <stdio.h>
 #include <android/log.h>
 #include "vdp.h"
+#include "pixel.h"
 
-/* below is the Action Replay cheat code object reference */
-extern ArCheatArray arCheatArray;
+/* this is set alongside the ready frame's slot number until the paint thread takes it */
+#define VDP_FRAME_FRESH 0x04
 
 /* below is an array that contains all hCounter values for a scanline - 
    it can be accessed using number of Z80 cycles as the index */
@@ -233,8 +234,22 @@ struct VDP {
     emuint z80Cycles; /* this stores cycles before producing a scanline */
     emubool gameGearMode; /* this determines whether or not we start in Game Gear mode */
     emubyte latchedDataByte; /* this is for use with some cRam writes */
-    emubyte *frame; /* this stores the pixels for the whole frame in a displayable form */
-    emuint *scanline; /* this stores the pixels for the current scanline */
+    emuint palette[32]; /* this holds each cRam colour in the frame's pixel format, background palette first -
+                           24-bit, 32-bit and indexed frames all use ARGB form */
+    emubyte patterns[512][8][8]; /* this holds each vRam pattern decoded into palette indexes */
+    emubyte flippedPatterns[512][8][8]; /* this holds the same patterns flipped horizontally */
+    emubool patternDirty[512]; /* this marks patterns whose vRam has changed since they were decoded */
+    PixelKernels kernels; /* this holds the pixel kernels best suited to the CPU */
+    emubyte *frames[3]; /* this is a ring of three frames in a displayable form - at any time the VDP draws into one,
+                           the newest finished frame waits in another, and the paint thread reads the third */
+    emuint backFrame; /* this is the slot the VDP is drawing into */
+    emuint publishedFrame; /* this is the slot the VDP last finished */
+    emuint frontFrame; /* this is the slot the paint thread last took */
+    SDL_atomic_t readyFrame; /* this is the slot holding the newest finished frame, plus VDP_FRAME_FRESH if the paint
+                                thread hasn't taken it yet - both threads only ever swap it atomically */
+    PixelFormat format; /* this is the pixel format of the frame */
+    emuint *scanline; /* this stores the palette entry of each pixel on the current scanline, with its
+                         top byte marking it as opaque (0xFF), transparent (0x01) or not yet drawn (0) */
     tvType type; /* this stores whether the VDP is in PAL or NTSC TV mode */
     emubyte lineInterruptFlag; /* this is the line interrupt flag */
     emuint lineInterruptCounter; /* this counts down for the line interrupt */
@@ -242,8 +257,6 @@ struct VDP {
     emubyte tempVerticalScrollRegister; /* this stores the scroll value to be used during a frame */
     emubool tempVerticalScrollChange; /* this lets us change the vertical scroll register */
     
-    SDL_mutex *frameMutex; /* this prevents the frame buffer being accessed by more than one
-                              thread concurrently - it depends on SDL for portability */
     SDL_Rect *sourceRect; /* this is the source rectangle passed through from the initialisation routine -
                              referencing it here allows us to easily change the resolution displayed on screen
                              between 192, 224, and 240 line modes */
@@ -264,20 +277,24 @@ static emubool lineIsInActiveDisplayPeriod(VDP v, signed_emuint line);
 static void renderSpritesMode4(VDP v);
 static void scanForSpritesMode4(VDP v);
 static void renderBackgroundMode4(VDP v);
+static void updatePaletteEntry(VDP v, emuint entry);
+static void writeFrameLine(VDP v, emuint row);
+static void copyFrameLine(VDP v, emuint row);
+static void publishFrame(VDP v);
+static emubyte *getPatternLine(VDP v, emuint pattern, emuint line, emubool horizontalFlip);
 
 /* this creates and returns a VDP object */
-VDP createVDP(Console ms, emubool ggMode, emubool isPal, SDL_Rect *sourceRect, emubyte *vdpState, emubyte *wholePointer)
+VDP createVDP(Console ms, emubool ggMode, emubool isPal, PixelFormat format, SDL_Rect *sourceRect, emubyte *vdpState, emubyte *wholePointer)
 {
     /* allocate memory for VDP struct */
     VDP v = (VDP)wholePointer;
     wholePointer += sizeof(struct VDP);
     
     /* set all sub-pointers storing locally allocated references to NULL now */
-    v->frameMutex = NULL;
     v->cRam = NULL;
     v->vRam = NULL;
     v->vdpRegisters = NULL;
-    v->frame = NULL;
+    v->frames[0] = v->frames[1] = v->frames[2] = NULL;
     v->scanline = NULL;
     v->sprites = NULL;
 
@@ -341,10 +358,18 @@ VDP createVDP(Console ms, emubool ggMode, emubool isPal, SDL_Rect *sourceRect, e
     v->gameGearMode = ggMode;
     v->latchedDataByte = 0;
     
-    /* setup frame pixel buffer and scanline */
-    v->frame = wholePointer;
-    memset((void *)v->frame, 0, 184320);
-    wholePointer += 184320;
+    /* setup frame ring and scanline - the VDP starts by drawing into slot 0, with slot 1
+       as the last (blank) frame, which the paint thread hasn't been given */
+    v->format = format;
+    for (emuint i = 0; i < 3; ++i) {
+        v->frames[i] = wholePointer;
+        memset((void *)v->frames[i], 0, vdp_getFrameSize(format));
+        wholePointer += vdp_getFrameSize(format);
+    }
+    v->backFrame = 0;
+    v->publishedFrame = 1;
+    SDL_AtomicSet(&v->readyFrame, 1);
+    v->frontFrame = 2;
     v->scanline = (emuint *)wholePointer;
     memset((void *)v->scanline, 0, sizeof(emuint) * 256);
     wholePointer += sizeof(emuint) * 256;
@@ -360,13 +385,6 @@ VDP createVDP(Console ms, emubool ggMode, emubool isPal, SDL_Rect *sourceRect, e
     else
         v->type = NTSC;
     
-    /* setup the frame mutex */
-    if ((v->frameMutex = SDL_CreateMutex()) == NULL) {
-        __android_log_print(ANDROID_LOG_ERROR, "vdp.c", "Couldn't create SDL mutex for frame buffer access: %s\n", SDL_GetError());
-        destroyVDP(v);
-        return NULL;
-    }
-    
     /* store reference to source rectangle */
     v->sourceRect = sourceRect;
 
@@ -413,6 +431,18 @@ VDP createVDP(Console ms, emubool ggMode, emubool isPal, SDL_Rect *sourceRect, e
         memcpy((void *)v->vdpRegisters, (void *)tempPointer, 16);
     }
 
+    /* pick the pixel kernels for this CPU, convert the colours in cRam for the renderers,
+       and have every pattern decoded on first use */
+    pixel_selectKernels(&v->kernels);
+    for (emuint i = 0; i < 32; ++i)
+        updatePaletteEntry(v, i);
+    for (emuint i = 0; i < 512; ++i)
+        v->patternDirty[i] = true;
+
+    /* schedule the first line, and let the console pick up the interrupt output */
+    console_scheduleEvent(ms, CONSOLE_EVENT_LINE, v->z80Cycles < 228 ? 228 - v->z80Cycles : 1);
+    console_scheduleEvent(ms, CONSOLE_EVENT_INTERRUPT, 0);
+
     /* return VDP object */
     return v;
 }
@@ -420,9 +450,7 @@ VDP createVDP(Console ms, emubool ggMode, emubool isPal, SDL_Rect *sourceRect, e
 /* this function destroys the specified VDP object */
 void destroyVDP(VDP v)
 {
-    /* destroy frame mutex */
-    if (v->frameMutex != NULL)
-        SDL_DestroyMutex(v->frameMutex);
+    /* all VDP memory belongs to the console, so there is nothing to release here */
 }
 
 /* this function executes the VDP for the specified number of VDP cycles - it is
@@ -447,10 +475,13 @@ emubool vdp_executeCycles(VDP v, emuint cycles)
             if ((v->vdpRegisters[0] & 0x04) == 0x04) {
                 renderSpritesMode4(v);
                 renderBackgroundMode4(v);
-                vdp_handleFrame(v, 1, v->lineNumber, v->scanline, NULL);
+                writeFrameLine(v, v->lineNumber);
                 
                 /* clear scanline buffer and priority */
                 memset((void *)v->scanline, 0, sizeof(emuint) * 256);
+            } else {
+                /* nothing is drawn outside mode 4, so keep showing what the last frame had */
+                copyFrameLine(v, v->lineNumber);
             }
         }
 
@@ -463,10 +494,15 @@ emubool vdp_executeCycles(VDP v, emuint cycles)
             v->vdpRegisters[14] = 0;
         }
         
-        /* deal with line numbers, vCounter and interrupts */
+        /* deal with line numbers, vCounter and interrupts, handing the frame over at the start of vblank */
         updateFrame = handleCountersAndInterrupts(v);
+        if (updateFrame)
+            publishFrame(v);
     }
 
+    /* let the console know when the next line is due */
+    console_scheduleEvent(v->ms, CONSOLE_EVENT_LINE, v->z80Cycles < 228 ? 228 - v->z80Cycles : 1);
+
     return updateFrame;
 }
 
@@ -662,7 +698,9 @@ void vdp_controlWrite(VDP v, emubyte b)
                                 } break;
                         default: v->vdpRegisters[(returnAddressRegister(v) >> 8) & 0xF] =
                                      0xFF & returnAddressRegister(v); break;
-                    } break;
+                    }
+                    console_scheduleEvent(v->ms, CONSOLE_EVENT_INTERRUPT, 0); /* interrupts may have been enabled or disabled */
+                    break;
             default: break;
         }
         v->secondControlByte = false;
@@ -682,8 +720,9 @@ emubyte vdp_controlRead(VDP v)
     v->vdpStatus = 0;
     v->secondControlByte = false;
     
-    /* reset line interrupt flag */
+    /* reset line interrupt flag, and let the console know the interrupt output has changed */
     v->lineInterruptFlag = false;
+    console_scheduleEvent(v->ms, CONSOLE_EVENT_INTERRUPT, 0);
 
     /* return status byte */
     return tempStatus;
@@ -705,11 +744,15 @@ void vdp_dataWrite(VDP v, emubyte b)
                            write latched byte to current cRam address - 1 */
                         v->cRam[returnAddressRegister(v) & 0x3F] = b;
                         v->cRam[(returnAddressRegister(v) - 1) & 0x3F] = v->latchedDataByte;
+                        updatePaletteEntry(v, (returnAddressRegister(v) & 0x3F) >> 1);
                     }
                 } else {
                     v->cRam[returnAddressRegister(v) & 0x1F] = b;
+                    updatePaletteEntry(v, returnAddressRegister(v) & 0x1F);
                 } break;
-        default: v->vRam[returnAddressRegister(v)] = b; break;
+        default: v->vRam[returnAddressRegister(v)] = b;
+                 v->patternDirty[returnAddressRegister(v) >> 5] = true;
+                 break;
     }
 
     /* increment the address register and reset 1st/2nd control byte flag */
@@ -773,21 +816,19 @@ emubyte vdp_isInterruptAsserted(VDP v)
 /* this function triggers a frame interrupt */
 static void setFrameInterruptFlag(VDP v)
 {
-    /* set bit 7 of status byte */
+    /* set bit 7 of status byte, and let the console know the interrupt output may have changed */
     v->vdpStatus |= 0x80;
+    console_scheduleEvent(v->ms, CONSOLE_EVENT_INTERRUPT, 0);
 
-    /* check for Action Replay codes and write to relevant addresses if enabled */
-    if (arCheatArray.enabled) {
-        for (emuint i = 0; i < arCheatArray.cheatCount; ++i) {
-            console_memWrite(v->ms, arCheatArray.cheats[i].address, arCheatArray.cheats[i].value);
-        }
-    }
+    /* write any Action Replay codes to RAM */
+    console_applyActionReplayCodes(v->ms);
 }
 
 static void setLineInterruptFlag(VDP v)
 {
-    /* set line interrupt flag */
+    /* set line interrupt flag, and let the console know the interrupt output may have changed */
     v->lineInterruptFlag = 1;
+    console_scheduleEvent(v->ms, CONSOLE_EVENT_INTERRUPT, 0);
 }
 
 /* this function is intended for use in the rendering routines - it determines if we are
@@ -831,7 +872,7 @@ static void renderSpritesMode4(VDP v) {
     if ((v->vdpRegisters[1] & 0x40) == 0x40) {
 
         /* iterate through sprite buffer and display sprites */
-        emuint pixelLine[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        emuint pixelLine[16];
         for (i = 0; i <= 7; ++i) {
             /* check if a sprite is present at this index */
             if (v->sprites[i].present != 0) {
@@ -840,70 +881,38 @@ static void renderSpritesMode4(VDP v) {
                 if (neededLine > 15)
                     neededLine /= 2;
 
-                /* create temporary pointer referencing start of pattern line */
-                emubyte *patternLine = v->vRam + (v->sprites[i].patternIndex * 32);
-                patternLine += (neededLine * 4);
-
-                /* now compose bitfields for each pixel properly, retrieve the colour
-                   value, and place it into the buffer */
-                emubyte bit0 = patternLine[0];
-                emubyte bit1 = patternLine[1];
-                emubyte bit2 = patternLine[2];
-                emubyte bit3 = patternLine[3];
-                for (p = 0; p < 8; ++p) {
-
-                    /* compose colour palette index */
-                    emubool transparentPixel = false;
-                    pixelLine[p] = (((bit3 >> (7 - p)) & 0x01) << 3) |
-                                   (((bit2 >> (7 - p)) & 0x01) << 2) |
-                                   (((bit1 >> (7 - p)) & 0x01) << 1) |
-                                   ((bit0 >> (7 - p)) & 0x01);
-                    if (pixelLine[p] == 0)
-                        transparentPixel = true;
-
-                    /* pull colour value from colour palette and convert it for BGR24 display */
-                    if (v->gameGearMode) {
-                        pixelLine[p] =
-                                (v->cRam[32 + (pixelLine[p] * 2) + 1] << 8) |
-                                v->cRam[32 + (pixelLine[p] * 2)];
-                        pixelLine[p] = 0xFF000000 |
-                                       (((pixelLine[p] & 0xF) * 17) << 16) |
-                                       ((((pixelLine[p] >> 4) & 0xF) * 17) << 8) |
-                                       (((pixelLine[p] >> 8) & 0xF) * 17);
-                    } else {
-                        pixelLine[p] = v->cRam[16 + pixelLine[p]];
-                        pixelLine[p] = 0xFF000000 |
-                                       (((pixelLine[p] & 0x3) * 85) << 16) |
-                                       ((((pixelLine[p] >> 2) & 0x3) * 85) << 8) |
-                                       (((pixelLine[p] >> 4) & 0x3) * 85);
-                    }
-                    if (transparentPixel)
-                        pixelLine[p] = 0x01000000 | (pixelLine[p] & 0xFFFFFF);
-
+                /* fetch the decoded pattern line - lines 8 to 15 of a tall sprite
+                   come from the pattern after the one specified */
+                emubyte *patternLine = getPatternLine(v, (v->sprites[i].patternIndex + (neededLine >> 3)) & 0x1FF,
+                                                      neededLine & 0x07, false);
+
+                /* retrieve the colour value for each pixel into the buffer, doubling
+                   each one up for zoomed sprites */
+                v->kernels.lookupLine(patternLine, 16, pixelLine);
+                if (v->sprites[i].width == 16) {
+                    for (p = 7; p >= 0; --p)
+                        pixelLine[(p * 2) + 1] = pixelLine[p * 2] = pixelLine[p];
                 }
 
-                /* now that we have this sprite line, we can add it into the scanline */
-                for (j = v->sprites[i].x, p = 0;
-                     j < v->sprites[i].x + v->sprites[i].width; ++j, ++p) {
-                    if (j < 0 || j > 255) { ;
-                    } else {
-                        emubyte tempP = p;
-                        if (v->sprites[i].width == 16)
-                            tempP /= 2;
-
-                        if ((v->scanline[j] & 0xFF000000) == 0) {
+                /* now that we have this sprite line, we can add it into the scanline - lines
+                   that are entirely on screen are merged eight pixels at a time */
+                emubool collision = false;
+                if (v->sprites[i].x >= 0 && v->sprites[i].x + v->sprites[i].width <= 256) {
+                    for (p = 0; p < v->sprites[i].width; p += 8)
+                        collision |= v->kernels.blendLine(v->scanline + v->sprites[i].x + p, pixelLine + p, false);
+                } else {
+                    for (j = v->sprites[i].x, p = 0;
+                         j < v->sprites[i].x + v->sprites[i].width; ++j, ++p) {
+                        if (j < 0 || j > 255) { ;
+                        } else if ((v->scanline[j] & 0xFF000000) != 0xFF000000) {
                             v->scanline[j] = pixelLine[p];
-                        } else {
-                            if ((v->scanline[j] & 0xFF000000) == 0x01000000) {
-                                v->scanline[j] = pixelLine[p];
-                            } else {
-                                if ((pixelLine[p] & 0xFF000000) == 0xFF000000) {
-                                    v->vdpStatus |= 0x20;
-                                }
-                            }
+                        } else if ((pixelLine[p] & 0xFF000000) == 0xFF000000) {
+                            collision = true;
                         }
                     }
                 }
+                if (collision)
+                    v->vdpStatus |= 0x20;
 
                 /* mark sprite as processed */
                 v->sprites[i].present = 0;
@@ -1009,36 +1018,11 @@ static void renderBackgroundMode4(VDP v)
     /* form temporary pointer with which to address name table */
     emubyte *nameTable = v->vRam + nameTableAddress;
     
-    /* retrieve colour 0 from palette 1 and store in ARGB form */
-    emuint zeroTemp = 0, zeroColour = 0xFF000000;
-    if (v->gameGearMode) {
-        zeroTemp = v->cRam[0];
-        zeroTemp |= (v->cRam[1] << 8);
-        zeroColour |= ((zeroTemp & 0xF) * 17) << 16;
-        zeroColour |= (((zeroTemp >> 4) & 0xF) * 17) << 8;
-        zeroColour |= ((zeroTemp >> 8) & 0xF) * 17;
-    } else {
-        zeroTemp = v->cRam[0];
-        zeroColour |= ((zeroTemp & 0x3) * 85) << 16;
-        zeroColour |= (((zeroTemp >> 2) & 0x3) * 85) << 8;
-        zeroColour |= ((zeroTemp >> 4) & 0x3) * 85;
-    }
+    /* use colour 0 from palette 1 */
+    emuint zeroColour = 0xFF000000;
     
-    /* retrieve overscan colour index from register 7 and retrieve overscan
-       colour from sprite palette, storing in ARGB form */
-    emuint overscanTemp = 0, overscanColour = 0xFF000000;
-    if (v->gameGearMode) {
-        overscanTemp = v->cRam[32 + ((v->vdpRegisters[7] & 0xF) * 2)];
-        overscanTemp |= (v->cRam[32 + ((v->vdpRegisters[7] & 0xF) * 2) + 1] << 8);
-        overscanColour |= ((overscanTemp & 0xF) * 17) << 16;
-        overscanColour |= (((overscanTemp >> 4) & 0xF) * 17) << 8;
-        overscanColour |= ((overscanTemp >> 8) & 0xF) * 17;
-    } else {
-        overscanTemp = v->cRam[16 + (v->vdpRegisters[7] & 0xF)];
-        overscanColour |= ((overscanTemp & 0x3) * 85) << 16;
-        overscanColour |= (((overscanTemp >> 2) & 0x3) * 85) << 8;
-        overscanColour |= ((overscanTemp >> 4) & 0x3) * 85;
-    }
+    /* retrieve overscan colour index from register 7, which selects from the sprite palette */
+    emuint overscanColour = 0xFF000000 | (16 + (v->vdpRegisters[7] & 0xF));
 
     /* retrieve starting column and horizontal fine scroll values */
     emubyte startingColumn = 32 - ((v->vdpRegisters[8] & 0xF8) >> 3);
@@ -1107,82 +1091,41 @@ static void renderBackgroundMode4(VDP v)
         /* determine palette to use */
         emubyte paletteSelect = (pattern >> 11) & 0x01;
         
-        /* reference pattern we need with temporary pointer */
-        emubyte *patternStart = v->vRam + ((pattern & 0x1FF) * 32);
-        
         /* check for vertical flip */
         if (verticalFlipFlag)
             neededLine = 7 - neededLine;
         
-        /* modify pointer */
-        patternStart += (neededLine * 4);
+        /* fetch the decoded pattern line, already flipped horizontally if needed */
+        emubyte *patternLine = getPatternLine(v, pattern & 0x1FF, neededLine, horizontalFlipFlag);
         
-        /* compose colour indexes and colours */
+        /* retrieve the pixels in ARGB form */
         emubyte p;
-        emubyte bit0 = 0, bit1 = 0, bit2 = 0, bit3 = 0;
-        emuint colourArray[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
-        bit0 = patternStart[0];
-        bit1 = patternStart[1];
-        bit2 = patternStart[2];
-        bit3 = patternStart[3];
-        for (p = 0; p < 8; ++p) {
-            emubool transparentPixel = false;
-            colourArray[p] = (((bit3 >> (7 - p)) << 3) & 0x08) |
-                             (((bit2 >> (7 - p)) << 2) & 0x04) |
-                             (((bit1 >> (7 - p)) << 1) & 0x02) |
-                             ((bit0 >> (7 - p)) & 0x01);
-            
-            /* check if pixel is supposed to be transparent */
-            if (colourArray[p] == 0)
-                transparentPixel = true;
-            
-            /* now compose the pixel in ARGB form */
-            if (v->gameGearMode) {
-                colourArray[p] = (v->cRam[(32 * paletteSelect) + (colourArray[p] * 2) + 1] << 8) |
-                                 v->cRam[(32 * paletteSelect) + (colourArray[p] * 2)];
-                colourArray[p] = 0xFF000000 |
-                                 (((colourArray[p] & 0xF) * 17) << 16) |
-                                 ((((colourArray[p] >> 4) & 0xF) * 17) << 8) |
-                                 (((colourArray[p] >> 8) & 0xF) * 17);
-            } else {
-                colourArray[p] = v->cRam[(16 * paletteSelect) + colourArray[p]];
-                colourArray[p] = 0xFF000000 |
-                                 (((colourArray[p] & 0x3) * 85) << 16) |
-                                 ((((colourArray[p] >> 2) & 0x3) * 85) << 8) |
-                                 (((colourArray[p] >> 4) & 0x3) * 85);
-            }
-            
-            if (transparentPixel)
-                colourArray[p] = 0x01000000 | (colourArray[p] & 0xFFFFFF);
-        }
-        
-        /* check for horizontal flip */
-        if (horizontalFlipFlag) {
-            emuint tempStore = 0;
-            for (p = 0; p < 4; ++p) {
-                tempStore = colourArray[p];
-                colourArray[p] = colourArray[7 - p];
-                colourArray[7 - p] = tempStore;
-            }
-        }
+        emuint colourArray[8];
+        v->kernels.lookupLine(patternLine, 16 * paletteSelect, colourArray);
         
-        /* incorporate pixels into scanline */
-        for (p = 0; p < 8; ++p) {
-            /* don't write beyond edge of scanline */
-            if (horizontalFineScroll > 255)
-                break;
+        /* incorporate pixels into scanline, taking priority into account - all but the
+           last column are entirely on screen, so can be merged in one go */
+        if (horizontalFineScroll <= 248) {
+            v->kernels.blendLine(v->scanline + horizontalFineScroll, colourArray, priorityFlag);
+            horizontalFineScroll += 8;
+        } else {
+            for (p = 0; p < 8; ++p) {
+                /* don't write beyond edge of scanline */
+                if (horizontalFineScroll > 255)
+                    break;
             
-            /* add pixel to scanline, taking priority into account */
-            if ((v->scanline[horizontalFineScroll] & 0xFF000000) != 0xFF000000) {
-                v->scanline[horizontalFineScroll] = colourArray[p];
-            } else {
-                if (priorityFlag && ((colourArray[p] & 0xFF000000) == 0xFF000000)) {
+                /* add pixel to scanline, taking priority into account */
+                if ((v->scanline[horizontalFineScroll] & 0xFF000000) != 0xFF000000) {
                     v->scanline[horizontalFineScroll] = colourArray[p];
+                } else {
+                    if (priorityFlag && ((colourArray[p] & 0xFF000000) == 0xFF000000)) {
+                        v->scanline[horizontalFineScroll] = colourArray[p];
+                    }
                 }
-            }
             
-            /* increment horizontal fine scroll */
-            ++horizontalFineScroll;
+                /* increment horizontal fine scroll */
+                ++horizontalFineScroll;
+            }
         }
         
         /* now increment starting column value */
@@ -1197,44 +1140,147 @@ static void renderBackgroundMode4(VDP v)
     }
 }
 
-/* this function allows the calling thread to either copy bytes from scanline to the specified
-   row, return the frame as a pointer reference, or clear the frame buffer completely */
-emubool vdp_handleFrame(VDP v, emubyte action, emubyte row, emuint *scanline, void *external)
+/* this function converts the specified colour from cRam into ARGB form for the renderers -
+   Game Gear colours are 12 bit and take two bytes of cRam, while Master System colours are
+   6 bit and take one */
+static void updatePaletteEntry(VDP v, emuint entry)
 {
     /* define variables */
-    emuint i;
-    emubool success = true;
-    emubyte *temp;
-    
-    /* lock frame mutex */
-    if (SDL_LockMutex(v->frameMutex) == 0) {
-        /* act upon specified action */
-        switch (action) {
-            case 0: memset((void *)v->frame, 0, 256 * 240 * 3); break; /* wipe frame buffer */
-            case 1: temp = v->frame; /* copy scanline to right place in buffer */
-                    temp += (256 * 3 * row);
-                    for (i = 0; i < 256; ++i) {
-                        temp[i * 3] = v->scanline[i] & 0xFF;
-                        temp[(i * 3) + 1] = (v->scanline[i] >> 8) & 0xFF;
-                        temp[(i * 3) + 2] = (v->scanline[i] >> 16) & 0xFF;
-                    }
-                    break;
-            case 2: /* copy frame buffer to external buffer */
-                    memcpy(external, (void *)v->frame, 256 * 240 * 3); break;
-        }
-        
-        /* now unlock mutex as we have finished with the frame buffer */
-        if (SDL_UnlockMutex(v->frameMutex) != 0) {
-            __android_log_print(ANDROID_LOG_ERROR, "vdp.c", "Couldn't unlock frame mutex: %s\n", SDL_GetError());
-            success = false;
-        }
+    emuint colour;
+
+    if (v->gameGearMode) {
+        colour = (v->cRam[(entry * 2) + 1] << 8) | v->cRam[entry * 2];
+        v->palette[entry] = 0xFF000000 |
+                            (((colour & 0xF) * 17) << 16) |
+                            ((((colour >> 4) & 0xF) * 17) << 8) |
+                            (((colour >> 8) & 0xF) * 17);
     } else {
-        __android_log_print(ANDROID_LOG_ERROR, "vdp.c", "Couldn't lock frame mutex: %s\n", SDL_GetError());
-        success = false;
+        colour = v->cRam[entry];
+        v->palette[entry] = 0xFF000000 |
+                            (((colour & 0x3) * 85) << 16) |
+                            ((((colour >> 2) & 0x3) * 85) << 8) |
+                            (((colour >> 4) & 0x3) * 85);
+    }
+
+    /* pack the colour down for 16-bit frames */
+    if (v->format == FORMAT_RGB565) {
+        colour = v->palette[entry];
+        v->palette[entry] = (((colour >> 19) & 0x1F) << 11) | (((colour >> 10) & 0x3F) << 5) | ((colour >> 3) & 0x1F);
     }
-    
-    /* return whether or not the function succeeded */
-    return success;
+}
+
+/* this function hands the frame just drawn to the paint thread, and takes back whichever slot is
+   free to draw the next one into - that is either the last frame, if the paint thread never took
+   it, or the one the paint thread has since moved on from - SDL_AtomicSet only promises to swap
+   atomically, so the barriers make sure the frame is fully drawn before the paint thread can see
+   it, and that the paint thread has finished with the slot we get back before we draw into it */
+static void publishFrame(VDP v)
+{
+    v->publishedFrame = v->backFrame;
+    SDL_MemoryBarrierRelease();
+    v->backFrame = SDL_AtomicSet(&v->readyFrame, v->backFrame | VDP_FRAME_FRESH) & 0x03;
+    SDL_MemoryBarrierAcquire();
+}
+
+/* this function copies the specified row of the last finished frame into the frame being drawn */
+static void copyFrameLine(VDP v, emuint row)
+{
+    /* define variables */
+    emubyte *source = v->frames[v->publishedFrame];
+    emubyte *destination = v->frames[v->backFrame];
+
+    if (v->format == FORMAT_INDEXED8) {
+        memcpy(destination + (256 * row), source + (256 * row), 256);
+        memcpy(destination + (256 * 240) + (sizeof(emuint) * 32 * row),
+               source + (256 * 240) + (sizeof(emuint) * 32 * row), sizeof(emuint) * 32);
+    } else {
+        emuint rowSize = vdp_getFrameSize(v->format) / 240;
+        memcpy(destination + (rowSize * row), source + (rowSize * row), rowSize);
+    }
+}
+
+/* this function converts the scanline into the frame's pixel format and writes it to the specified row -
+   the scanline isn't drawn to while the display is blanked, so that gives a black line */
+static void writeFrameLine(VDP v, emuint row)
+{
+    /* define variables */
+    emubyte *frame = v->frames[v->backFrame];
+    emubool blanked = (v->vdpRegisters[1] & 0x40) == 0;
+    emuint i, colour;
+
+    switch (v->format) {
+        case FORMAT_BGR24: {
+            emubyte *pixels = frame + (256 * 3 * row);
+            for (i = 0; i < 256; ++i) {
+                colour = blanked ? 0 : v->palette[v->scanline[i] & 0x1F];
+                pixels[i * 3] = colour & 0xFF;
+                pixels[(i * 3) + 1] = (colour >> 8) & 0xFF;
+                pixels[(i * 3) + 2] = (colour >> 16) & 0xFF;
+            }
+        } break;
+        case FORMAT_RGB565: {
+            Uint16 *pixels = (Uint16 *)frame + (256 * row);
+            for (i = 0; i < 256; ++i)
+                pixels[i] = blanked ? 0 : v->palette[v->scanline[i] & 0x1F];
+        } break;
+        case FORMAT_XRGB8888: {
+            emuint *pixels = (emuint *)frame + (256 * row);
+            for (i = 0; i < 256; ++i)
+                pixels[i] = blanked ? 0xFF000000 : v->palette[v->scanline[i] & 0x1F];
+        } break;
+        case FORMAT_INDEXED8: {
+            /* the colours this line's indexes refer to go in the table after the indexes */
+            emubyte *indexes = frame + (256 * row);
+            emuint *colours = (emuint *)(frame + (256 * 240)) + (32 * row);
+            for (i = 0; i < 256; ++i)
+                indexes[i] = blanked ? 0 : v->scanline[i] & 0x1F;
+            for (i = 0; i < 32; ++i)
+                colours[i] = blanked ? 0xFF000000 : v->palette[i];
+        } break;
+    }
+}
+
+/* this function returns one line of a pattern as palette indexes, decoding the
+   pattern from vRam first if it has been written to since it was last decoded */
+static emubyte *getPatternLine(VDP v, emuint pattern, emuint line, emubool horizontalFlip)
+{
+    if (v->patternDirty[pattern]) {
+        v->kernels.decodePattern(v->vRam + (pattern * 32), v->patterns[pattern][0], v->flippedPatterns[pattern][0]);
+        v->patternDirty[pattern] = false;
+    }
+
+    return horizontalFlip ? v->flippedPatterns[pattern][line] : v->patterns[pattern][line];
+}
+
+/* this function returns the newest frame the VDP has finished, or NULL if it hasn't finished one
+   since the last call - it never blocks, and is only to be called from the paint thread, which
+   can read the frame until its next call - the frame lives in the console's memory, so it must
+   not be kept beyond that, and never once the console has been destroyed */
+emubyte *vdp_acquireFrame(VDP v)
+{
+    if ((SDL_AtomicGet(&v->readyFrame) & VDP_FRAME_FRESH) == 0)
+        return NULL;
+
+    /* swap the slot we were reading for the ready one - the barriers make sure we are done
+       with our old slot before the VDP can draw into it, and that we see everything the VDP
+       drew before publishing the new one */
+    SDL_MemoryBarrierRelease();
+    v->frontFrame = SDL_AtomicSet(&v->readyFrame, v->frontFrame) & 0x03;
+    SDL_MemoryBarrierAcquire();
+    return v->frames[v->frontFrame];
+}
+
+/* this function hands the frame last returned by vdp_acquireFrame back to the VDP as the newest
+   finished frame, for when the paint thread couldn't display it - if the VDP has finished a newer
+   frame in the meantime, that one is left to be acquired instead */
+void vdp_returnFrame(VDP v)
+{
+    /* define variables */
+    int ready = SDL_AtomicGet(&v->readyFrame);
+
+    /* the ready slot becomes ours in exchange, but we never read it */
+    if ((ready & VDP_FRAME_FRESH) == 0 && SDL_AtomicCAS(&v->readyFrame, ready, v->frontFrame | VDP_FRAME_FRESH))
+        v->frontFrame = ready & 0x03;
 }
 
 /* this function calculates and stores the current hCounter value */
@@ -1326,14 +1372,25 @@ SDL_Rect *vdp_getSourceRect(VDP v)
     return v->sourceRect;
 }
 
-/* this function returns the number of bytes needed to create a VDP object */
-emuint vdp_getMemoryUsage(void)
+/* this function returns the number of bytes needed to create a VDP object rendering the specified pixel format */
+emuint vdp_getMemoryUsage(PixelFormat format)
 {
     return (sizeof(struct VDP) * sizeof(emubyte)) + /* cRam size */ (sizeof(emubyte) * 64) + /* vRam size */ (sizeof(emubyte) * 16384) +
-    /* VDP registers size */ (sizeof(emubyte) * 16) + /* frame size */ (sizeof(emubyte) * 184320) + /* scanline size */ (sizeof(emuint) * 256) +
+    /* VDP registers size */ (sizeof(emubyte) * 16) + /* frame ring size */ (sizeof(emubyte) * vdp_getFrameSize(format) * 3) + /* scanline size */ (sizeof(emuint) * 256) +
     /* Sprite buffer size */ (sizeof(Sprite) * 8);
 }
 
+/* this function returns the number of bytes in a frame of the specified pixel format */
+emuint vdp_getFrameSize(PixelFormat format)
+{
+    switch (format) {
+        case FORMAT_RGB565: return 256 * 240 * 2;
+        case FORMAT_XRGB8888: return 256 * 240 * 4;
+        case FORMAT_INDEXED8: return (256 * 240) + (sizeof(emuint) * 32 * 240);
+        default: return 256 * 240 * 3;
+    }
+}
+
 /* this function returns the current line the VDP is on */
 emuint vdp_getCurrentLine(VDP v)
 {
@@ -11,7 +11,7 @@
 typedef struct VDP *VDP;
 
 /* function declarations for public use */
-VDP createVDP(Console ms, emubool ggMode, emubool isPal, SDL_Rect *sourceRect, emubyte *vdpState, emubyte *wholePointer); /* creates VDP object and returns a pointer to it */
+VDP createVDP(Console ms, emubool ggMode, emubool isPal, PixelFormat format, SDL_Rect *sourceRect, emubyte *vdpState, emubyte *wholePointer); /* creates VDP object and returns a pointer to it */
 void destroyVDP(VDP v); /* destroys specified VDP object */
 void vdp_controlWrite(VDP v, emubyte b); /* writes to the VDP control port */
 emubyte vdp_controlRead(VDP v); /* reads from the VDP control port */
@@ -25,10 +25,14 @@ emubyte vdp_isInterruptAsserted(VDP v); /* returns whether or not the VDP is tri
 void vdp_storeHCounterValue(VDP v); /* calculate and stores hCounter value */
 emubyte *vdp_saveState(VDP v); /* this returns a pointer to the state of the VDP */
 SDL_Rect *vdp_getSourceRect(VDP v); /* this returns the source rect of the VDP */
-emuint vdp_getMemoryUsage(void); /* this returns the number of bytes needed to create a VDP object */
+emuint vdp_getMemoryUsage(PixelFormat format); /* this returns the number of bytes needed to create a VDP object rendering the specified format */
+emuint vdp_getFrameSize(PixelFormat format); /* this returns the number of bytes in a 256x240 frame of the specified format - indexed
+                                                frames are followed by the 32 ARGB colours their indexes referred to on each line */
 emuint vdp_getCurrentLine(VDP v); /* this returns the current line the VDP is on */
 
-/* this function allows handling of the frame buffer in a thread-safe way */
-emubool vdp_handleFrame(VDP v, emubyte action, emubyte row, emuint *scanline, void *external);
+/* these functions let the paint thread take the newest finished frame without locking, and hand
+   it back if it couldn't be displayed */
+emubyte *vdp_acquireFrame(VDP v);
+void vdp_returnFrame(VDP v);
 
 #endif
@@ -2,7 +2,15 @@
    copyright Phil Potter, 2024 */
 
 #include <stdlib.h>
+#include <string.h>
 #include <android/log.h>
+#if defined(Z80_TRACE)
+#include <stdio.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../../SDL-release-2.30.2/include/SDL.h"
+#endif
 #include "z80.h"
 #include "console.h"
 
@@ -11,9 +19,85 @@
 enum cpuVal { A, B, C, D, E, H, L, n, IXd, IYd, aHL, IXh, IXl, IYh, IYl,
               a_nn, nn, SP, R, I, HL, BC, DE, aBC, aDE, IX, IY, AF, M,
               NC, NZ, P, PE, PO, Z, aSP, aC, AFShadow, a_n };
-enum calcType { subtraction = 128, addition = 0, subtraction16 =  32768, addition16 = 0 };
 typedef enum cpuVal cpuVal;
-typedef enum calcType calcType;
+
+/* these lookup tables hold precomputed flag values for the ALU instructions - they are
+   shared by all Z80 objects and filled in once by initialiseFlagTables, and any flag not
+   covered by a table is left as zero so the entry can be merged with the rest of reg F */
+static emubyte szpFlags[256]; /* S, Z and P/V (parity) flags for a byte value */
+static emubyte incFlags[256]; /* S, Z, H, P/V and N flags for INC, indexed by the old value */
+static emubyte decFlags[256]; /* S, Z, H, P/V and N flags for DEC, indexed by the old value */
+static emubyte bitFlags[256]; /* S, Z, H and P/V flags for BIT, indexed by the masked value */
+static emubyte addFlags[2][256][256]; /* all flags except bits 5 and 3 for ADD and ADC,
+                                         indexed by carry, accumulator and operand */
+static emubyte subFlags[2][256][256]; /* all flags except bits 5 and 3 for SUB, SBC and CP,
+                                         indexed by carry, accumulator and operand */
+static emuint daaValues[2048]; /* accumulator (high byte) and reg F (low byte) after DAA,
+                                  indexed by N, H and C flags and then accumulator */
+static emubool flagTablesReady = false;
+
+/* these lookup tables hold the number of operand bytes that follow each opcode, which the
+   block cache decodes along with the opcode - CB prefixed instructions have none, and the
+   displacement of DDCB and FDCB instructions is handled separately */
+static const emubyte baseOperandCounts[256] = {
+    0, 2, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* 00-0F */
+    1, 2, 0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0, 0, 1, 0, /* 10-1F */
+    1, 2, 2, 0, 0, 0, 1, 0, 1, 0, 2, 0, 0, 0, 1, 0, /* 20-2F */
+    1, 2, 2, 0, 0, 0, 1, 0, 1, 0, 2, 0, 0, 0, 1, 0, /* 30-3F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 40-4F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 50-5F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 60-6F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 70-7F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 80-8F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 90-9F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* A0-AF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* B0-BF */
+    0, 0, 2, 2, 2, 0, 1, 0, 0, 0, 2, 0, 2, 2, 1, 0, /* C0-CF */
+    0, 0, 2, 1, 2, 0, 1, 0, 0, 0, 2, 1, 2, 0, 1, 0, /* D0-DF */
+    0, 0, 2, 0, 2, 0, 1, 0, 0, 0, 2, 0, 2, 0, 1, 0, /* E0-EF */
+    0, 0, 2, 0, 2, 0, 1, 0, 0, 0, 2, 0, 2, 0, 1, 0  /* F0-FF */
+};
+static const emubyte edOperandCounts[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 00-0F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 10-1F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 20-2F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 30-3F */
+    0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, /* 40-4F */
+    0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, /* 50-5F */
+    0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, /* 60-6F */
+    0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, /* 70-7F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 80-8F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 90-9F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* A0-AF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* B0-BF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* C0-CF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* D0-DF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* E0-EF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0  /* F0-FF */
+};
+static const emubyte indexOperandCounts[256] = { /* DD and FD prefixed instructions */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 00-0F */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 10-1F */
+    0, 2, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1, 0, /* 20-2F */
+    0, 0, 0, 0, 1, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* 30-3F */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* 40-4F */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* 50-5F */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* 60-6F */
+    1, 1, 1, 1, 1, 1, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, /* 70-7F */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* 80-8F */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* 90-9F */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* A0-AF */
+    0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 1, 0, /* B0-BF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* C0-CF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* D0-DF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, /* E0-EF */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0  /* F0-FF */
+};
+
+/* the block cache and idle loop structs are defined alongside the Z80 struct below */
+struct DecodedInstruction;
+struct DecodedBlock;
+struct IdleLoopPass;
 
 /* miscellaneous static function declarations for use within file 
    - see each function's comment for its purpose */
@@ -21,32 +105,73 @@ static void writeToMemory(Z80 z, emuint address, emubyte data);
 static emubyte readFromMemory(Z80 z, emuint address);
 static void writeToIO(Z80 z, emuint address, emubyte data);
 static emubyte readFromIO(Z80 z, emuint address);
-static void setSFlag(Z80 z, emubool value);
-static void setZFlag(Z80 z, emubool value);
-static void setHFlag(Z80 z, emubool value);
-static void setPVFlag(Z80 z, emubool value);
-static void setNFlag(Z80 z, emubool value);
-static void setCFlag(Z80 z, emubool value);
 static void writeProgramCounter(Z80 z, emuint address);
 static emuint readProgramCounter(Z80 z);
 static void incrementProgramCounter(Z80 z);
 static void decrementProgramCounter(Z80 z);
+static emubyte fetchOpcode(Z80 z);
+static inline emubyte fetchOperand(Z80 z);
+static emubyte readIndexedCbDisplacement(Z80 z);
 static void incrementRefreshRegister(Z80 z);
+static emubyte readRefreshRegister(Z80 z);
+static void writeRefreshRegister(Z80 z, emubyte value);
+static emuint countHaltedNops(Z80 z);
+static emubool isDirectRead(Z80 z, emuint address);
+static emubool isDirectWrite(Z80 z, emuint address);
+static emubool repeatBlockInstruction(Z80 z, emubyte opcode);
+static struct DecodedInstruction *findDecodedInstruction(Z80 z);
+static emubool decodeInstruction(emubyte *page, emuint offset, struct DecodedInstruction *decoded);
+static emubool isBlockValid(Z80 z, struct DecodedBlock *block);
+static void invalidateRamCode(Z80 z, uint64_t pages);
+static void updateCodePages(Z80 z);
+static void captureIdleLoopPass(Z80 z, struct IdleLoopPass *pass);
+static emubool isSameIdleLoopPass(struct IdleLoopPass *first, struct IdleLoopPass *second);
+static void checkIdleLoop(Z80 z, emuint target);
+static void fillProfile(Z80Profile *p);
+void Z80Fast_fillProfile(Z80Profile *p); /* this and the next come from the fast profile's build of this file */
+emuint Z80Fast_getMemoryUsage(void);
+#if defined(Z80_PROFILER)
+static void recordOpcodeProfile(Z80 z);
+static int compareProfileEntries(const void *first, const void *second);
+#endif
+#if defined(Z80_TRACE)
+struct TraceEntry;
+static void beginTraceEntry(Z80 z);
+static void endTraceEntry(Z80 z);
+static char *appendTraceText(char *out, const char *text);
+static char *appendTraceHex(char *out, emuint value, emuint digits);
+static char *appendTraceDecimal(char *out, emuint value, emuint width);
+static emuint formatTraceEntry(struct TraceEntry *entry, emuint number, emubool inProgress, char *line);
+static void writeTraceLine(int fd, const char *line, emuint length);
+static void writeTrace(Z80 z, int fd, char *line);
+static void dumpTraceOnCrash(int signalNumber);
+#endif
 static void writeStackPointer(Z80 z, emuint address);
 static emuint readStackPointer(Z80 z);
 static void incrementStackPointer(Z80 z);
 static void decrementStackPointer(Z80 z);
-static void calculatePVFlag(Z80 z, emubyte temp);
-static void calculateZFlag(Z80 z, emubyte temp);
-static void calculateSFlag(Z80 z, emubyte temp);
-static void calculateHFlag(Z80 z, emubyte operand1, emubyte operand2, emuint result);
-static void calculateCFlag(Z80 z, emubyte operand, emuint result);
-static void calculatePVOverflow(Z80 z, emubyte operand, emuint result, calcType type);
-static void calculateZFlag16(Z80 z, emuint temp);
-static void calculateSFlag16(Z80 z, emuint temp);
-static void calculateHFlag16(Z80 z, emuint tempHL, emuint operand, emuint result);
-static void calculateCFlag16(Z80 z, emuint tempHL, emuint operand, emuint result);
-static void calculatePVOverflow16(Z80 z, emuint tempHL, emuint operand, emuint result, calcType type);
+static void initialiseFlagTables(void);
+static emuint calculateDAA(emubyte a, emubool cFlag, emubool hFlag, emubool nFlag);
+
+/* instruction functions that take cpuVal or constant arguments are always inlined into
+   the per-opcode handlers below, so that each opcode gets its own specialised body with
+   the operands and cycle counts as constants and the operand switches folded away */
+#if defined(__GNUC__)
+#define Z80_SPECIALISED static inline __attribute__((always_inline))
+#else
+#define Z80_SPECIALISED static inline
+#endif
+
+/* the accurate profile, which is the default, keeps the undocumented bits 5 and 3 of reg F
+   through the instructions that don't change them, and counts every opcode fetch in the
+   refresh register - z80_fast.c builds this file again with FAST_PROFILE, which compiles both
+   out, so instructions clear those two bits instead, and reg R is worked out from the cycles
+   run whenever it is read */
+#if defined(FAST_PROFILE)
+#define Z80_KEEP_FLAGS(mask) ((mask) & 0xD7)
+#else
+#define Z80_KEEP_FLAGS(mask) (mask)
+#endif
 
 /* static function declarations for Z80 instructions
    - see each function's comment for its purpose */
@@ -55,29 +180,29 @@ static void DAA(Z80 z);
 static void EI(Z80 z);
 static void DI(Z80 z);
 static void HALT(Z80 z);
-static void IM(Z80 z, emubyte mode);
-static void XOR(Z80 z, cpuVal value);
-static void BIT(Z80 z, emubyte bit, cpuVal value);
-static void RST(Z80 z, emubyte vector);
+Z80_SPECIALISED void IM(Z80 z, emubyte mode);
+Z80_SPECIALISED void XOR(Z80 z, cpuVal value);
+Z80_SPECIALISED void BIT(Z80 z, emubyte bit, cpuVal value);
+Z80_SPECIALISED void RST(Z80 z, emubyte vector);
 static void EXX(Z80 z);
-static void SET(Z80 z, emubyte bit, cpuVal value);
-static void RES(Z80 z, emubyte bit, cpuVal value);
-static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source);
-static void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer);
-static void OR(Z80 z, cpuVal value);
-static void SUB(Z80 z, cpuVal value);
-static void SBC(Z80 z, cpuVal value);
-static void PUSH(Z80 z, cpuVal value);
-static void POP(Z80 z, cpuVal value);
-static void RET_CONDITIONAL(Z80 z, cpuVal value);
+Z80_SPECIALISED void SET(Z80 z, emubyte bit, cpuVal value);
+Z80_SPECIALISED void RES(Z80 z, emubyte bit, cpuVal value);
+Z80_SPECIALISED void LD_8Bit(Z80 z, cpuVal destination, cpuVal source);
+Z80_SPECIALISED void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer);
+Z80_SPECIALISED void OR(Z80 z, cpuVal value);
+Z80_SPECIALISED void SUB(Z80 z, cpuVal value);
+Z80_SPECIALISED void SBC(Z80 z, cpuVal value);
+Z80_SPECIALISED void PUSH(Z80 z, cpuVal value);
+Z80_SPECIALISED void POP(Z80 z, cpuVal value);
+Z80_SPECIALISED void RET_CONDITIONAL(Z80 z, cpuVal value);
 static void RET(Z80 z);
-static void ADC(Z80 z, cpuVal value);
-static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo);
-static void AND(Z80 z, cpuVal value);
-static void CALL_CONDITIONAL(Z80 z, cpuVal value);
+Z80_SPECIALISED void ADC(Z80 z, cpuVal value);
+Z80_SPECIALISED void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo);
+Z80_SPECIALISED void AND(Z80 z, cpuVal value);
+Z80_SPECIALISED void CALL_CONDITIONAL(Z80 z, cpuVal value);
 static void CALL(Z80 z);
 static void CCF(Z80 z);
-static void CP(Z80 z, cpuVal value);
+Z80_SPECIALISED void CP(Z80 z, cpuVal value);
 static void CPD(Z80 z);
 static void CPDR(Z80 z);
 static void CPI(Z80 z);
@@ -89,11 +214,11 @@ static void LDI(Z80 z);
 static void LDDR(Z80 z);
 static void LDIR(Z80 z);
 static void DJNZ(Z80 z);
-static void EX(Z80 z, cpuVal valueone, cpuVal valuetwo);
-static void DEC(Z80 z, cpuVal value);
-static void INC(Z80 z, cpuVal value);
-static void IN(Z80 z, cpuVal destination, cpuVal source);
-static void OUT(Z80 z, cpuVal destination, cpuVal source);
+Z80_SPECIALISED void EX(Z80 z, cpuVal valueone, cpuVal valuetwo);
+Z80_SPECIALISED void DEC(Z80 z, cpuVal value);
+Z80_SPECIALISED void INC(Z80 z, cpuVal value);
+Z80_SPECIALISED void IN(Z80 z, cpuVal destination, cpuVal source);
+Z80_SPECIALISED void OUT(Z80 z, cpuVal destination, cpuVal source);
 static void IND(Z80 z);
 static void INDR(Z80 z);
 static void INI(Z80 z);
@@ -102,33 +227,184 @@ static void OUTD(Z80 z);
 static void OTDR(Z80 z);
 static void OUTI(Z80 z);
 static void OTIR(Z80 z);
-static void JP_CONDITIONAL(Z80 z, cpuVal value);
-static void JP(Z80 z, cpuVal value);
-static void JR_CONDITIONAL(Z80 z, cpuVal value);
+Z80_SPECIALISED void JP_CONDITIONAL(Z80 z, cpuVal value);
+Z80_SPECIALISED void JP(Z80 z, cpuVal value);
+Z80_SPECIALISED void JR_CONDITIONAL(Z80 z, cpuVal value);
 static void JR(Z80 z);
 static void RETI(Z80 z);
 static void RETN(Z80 z);
-static void RL(Z80 z, cpuVal value);
+Z80_SPECIALISED void RL(Z80 z, cpuVal value);
 static void RLA(Z80 z);
-static void RLC(Z80 z, cpuVal value);
+Z80_SPECIALISED void RLC(Z80 z, cpuVal value);
 static void RLCA(Z80 z);
 static void RLD(Z80 z);
-static void RR(Z80 z, cpuVal value);
+Z80_SPECIALISED void RR(Z80 z, cpuVal value);
 static void RRA(Z80 z);
-static void RRC(Z80 z, cpuVal value);
+Z80_SPECIALISED void RRC(Z80 z, cpuVal value);
 static void RRCA(Z80 z);
 static void RRD(Z80 z);
-static void SLA(Z80 z, cpuVal value);
-static void SLL(Z80 z, cpuVal value);
-static void SRA(Z80 z, cpuVal value);
-static void SRL(Z80 z, cpuVal value);
+Z80_SPECIALISED void SLA(Z80 z, cpuVal value);
+Z80_SPECIALISED void SLL(Z80 z, cpuVal value);
+Z80_SPECIALISED void SRA(Z80 z, cpuVal value);
+Z80_SPECIALISED void SRL(Z80 z, cpuVal value);
 static void SCF(Z80 z);
 
+/* this union holds a register pair, so that the 16 bit value and its high and low
+   8 bit halves share the same storage - the halves are ordered to match the byte
+   order of the host, so no shifting or masking is needed to move between them */
+union RegisterPair {
+    uint16_t pair;
+    struct {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        emubyte high;
+        emubyte low;
+#else
+        emubyte low;
+        emubyte high;
+#endif
+    } half;
+};
+typedef union RegisterPair RegisterPair;
+
+/* these macros map the register names used throughout this file onto the halves
+   and full values of the register pairs in the Z80 struct */
+#define regB bc.half.high
+#define regC bc.half.low
+#define regD de.half.high
+#define regE de.half.low
+#define regH hl.half.high
+#define regL hl.half.low
+#define regBC bc.pair
+#define regDE de.pair
+#define regHL hl.pair
+#define regBShadow bcShadow.half.high
+#define regCShadow bcShadow.half.low
+#define regDShadow deShadow.half.high
+#define regEShadow deShadow.half.low
+#define regHShadow hlShadow.half.high
+#define regLShadow hlShadow.half.low
+#define regBCShadow bcShadow.pair
+#define regDEShadow deShadow.pair
+#define regHLShadow hlShadow.pair
+
+/* sizes of the block cache - blocks are looked up by a hash of the address of their first
+   instruction, and each holds up to Z80_BLOCK_LENGTH instructions in the order they ran */
+#define Z80_BLOCK_COUNT 512
+#define Z80_BLOCK_LENGTH 16
+#define Z80_MAX_OPERANDS 2
+
+/* these identify which opcode table a decoded instruction's handler comes from */
+enum OpcodeTable { BASE_TABLE, CB_TABLE, DD_TABLE, ED_TABLE, FD_TABLE, DDCB_TABLE, FDCB_TABLE, OPCODE_TABLE_COUNT };
+
+/* this struct holds one pre-decoded instruction, with the handler it dispatches to
+   once all of its prefix and opcode bytes have been fetched, and copies of the immediate
+   and displacement bytes the handler would otherwise read from memory */
+struct DecodedInstruction {
+#if defined(__GNUC__)
+    const void *handler; /* label address within Z80_executeInstruction, NULL until resolved */
+#else
+    void (*handler)(Z80 z); /* handler function, NULL until resolved */
+#endif
+    uint16_t offset; /* offset of the first opcode byte within its 1KB page */
+    emubyte length; /* number of prefix, opcode and displacement bytes fetched before the handler runs */
+    emubyte table; /* the opcode table the handler comes from */
+    emubyte opcode; /* the index of the handler within that table */
+    emubyte operandCount; /* number of operand bytes copied below */
+    emubyte operands[Z80_MAX_OPERANDS]; /* operand bytes in the order the handler fetches them */
+};
+
+/* this struct holds a block of pre-decoded instructions from one 1KB page of ROM or RAM -
+   the page pointer is the host address of the page, so ROM blocks are effectively keyed by
+   bank and offset and remain valid across bank switches, whereas blocks decoded from RAM
+   are thrown away when their page is written to */
+struct DecodedBlock {
+    emubyte *page; /* host address of the page the block was decoded from, NULL if unused */
+    emuint count; /* number of instructions decoded so far */
+    emubool isRam; /* whether the block could have come from RAM */
+    emuint pageNumber; /* the page of the address space a RAM block was decoded from */
+    emuint generation; /* value of that page's generation when a RAM block was decoded */
+    struct DecodedInstruction instructions[Z80_BLOCK_LENGTH];
+};
+
+/* these set the size of the idle loop records below */
+#define Z80_IDLE_REGISTER_COUNT 14
+#define Z80_IDLE_POLL_COUNT 4
+#define Z80_NO_IDLE_LOOP 0xFFFFFFFF
+
+/* this struct records one pass around a possible idle loop - the registers as they were when
+   it branched back to the top, and every value read from the polled VDP ports on the way */
+struct IdleLoopPass {
+    emuint registers[Z80_IDLE_REGISTER_COUNT];
+    emuint polls[Z80_IDLE_POLL_COUNT];
+    emuint pollCount;
+};
+
+#if defined(Z80_TRACE)
+/* size of the instruction trace, which must be a power of two */
+#define Z80_TRACE_LENGTH 4096
+
+/* these bits of a trace entry's flags record the interrupt state an instruction started in */
+#define Z80_TRACE_NMI 0x01
+#define Z80_TRACE_INTERRUPT_LINE 0x02
+#define Z80_TRACE_IFF1 0x04
+#define Z80_TRACE_HALT 0x08
+
+/* this struct is one instruction of the trace - the state the Z80 was in as it started the
+   instruction, and the number of cycles the instruction then took */
+struct TraceEntry {
+    uint16_t pc;
+    uint16_t af;
+    uint16_t bc;
+    uint16_t de;
+    uint16_t hl;
+    uint16_t ix;
+    uint16_t iy;
+    uint16_t sp;
+    emubyte i;
+    emubyte r;
+    emubyte flags;
+    emubyte opcodeCount; /* number of bytes from the program counter that could be read without side effects */
+    emubyte opcodes[4];
+    emuint bankState; /* the cartridge's mapping registers, as packed by cart_getBankState */
+    emuint runCycles; /* cycles into the current run at which the instruction started */
+    emuint cycles;
+};
+
+/* these publish and fetch the trace's head index - entries are filled in before the index
+   moves past them, so a dump from a signal handler or another thread never sees a half
+   written entry as finished */
+#if defined(__GNUC__)
+#define Z80_TRACE_PUBLISH(z, head) __atomic_store_n(&(z)->traceHead, (head), __ATOMIC_RELEASE)
+#define Z80_TRACE_HEAD(z) __atomic_load_n(&(z)->traceHead, __ATOMIC_ACQUIRE)
+#else
+#define Z80_TRACE_PUBLISH(z, head) ((z)->traceHead = (head))
+#define Z80_TRACE_HEAD(z) ((z)->traceHead)
+#endif
+
+/* size of the buffer each line of the trace is formatted into, which fits the longest line */
+#define Z80_TRACE_LINE_SIZE 256
+
+/* the signals the trace is dumped on, and the Z80 whose trace that is - the file the trace
+   is written to and the buffer its lines are formatted in are set up beforehand, as neither
+   can be safely done once a crash signal has been caught */
+static const int crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+#define Z80_CRASH_SIGNAL_COUNT (sizeof(crashSignals) / sizeof(crashSignals[0]))
+static struct sigaction previousCrashActions[Z80_CRASH_SIGNAL_COUNT];
+static emubool crashHandlersInstalled = false;
+static Z80 volatile crashTraceZ80 = NULL;
+static int crashTraceFd = -1;
+static char crashTraceLine[Z80_TRACE_LINE_SIZE];
+#endif
+
 /* this struct models the Z80's internal state */
 struct Z80 {
     /* pointer to main console object */
     Console ms;
 
+    /* memory map tables owned by the console, used for direct memory access */
+    emubyte **readPages;
+    emubyte **writePages;
+
     /* interrupt related attributes */
     emubyte nmi; /* signals a non-maskable interrupt if set to 1 */
     emubyte iff1; /* first interrupt flip-flop register */
@@ -137,26 +413,21 @@ struct Z80 {
     emubyte intMode; /* shows interrupt mode processor is set to */
     emubool followingInstruction; /* stops maskable interrupts in the instruction
                                      immediately following EI */
+    emubool interruptLine; /* state of the maskable interrupt line, as last passed on by the console */
 
-    /* Z80 main 8 bit registers */
+    /* Z80 main registers */
     emubyte regA;
-    emubyte regB;
-    emubyte regC;
-    emubyte regD;
-    emubyte regE;
-    emubyte regH;
-    emubyte regL;
     emubyte regF;
+    RegisterPair bc;
+    RegisterPair de;
+    RegisterPair hl;
 
-    /* Z80 shadow 8 bit registers */
+    /* Z80 shadow registers */
     emubyte regAShadow;
-    emubyte regBShadow;
-    emubyte regCShadow;
-    emubyte regDShadow;
-    emubyte regEShadow;
-    emubyte regHShadow;
-    emubyte regLShadow;
     emubyte regFShadow;
+    RegisterPair bcShadow;
+    RegisterPair deShadow;
+    RegisterPair hlShadow;
 
     /* miscellaneous registers */
     emuint regIX; /* 16 bit register */
@@ -172,16 +443,66 @@ struct Z80 {
     emubool fdStub; /* this allows long sequences of FD */
     emuint interruptCounter; /* this allows us to delay the servicing of maskable interrupts */
     emubool interruptPending; /* this also allows us to delay the servicing of maskable interrupts */
+    emuint runCycles; /* counts cycles executed so far by the current call to Z80_run */
+    emuint runTarget; /* the number of cycles the current call to Z80_run is aiming for */
+    emuint syncedCycles; /* counts how many of those cycles have been passed on to other devices */
+#if defined(FAST_PROFILE)
+    emuint refreshCycles; /* counts cycles executed by previous runs, which reg R is worked out from */
+#endif
+
+    /* block cache attributes */
+    emubool blockCache; /* if true, instructions run from pre-decoded blocks where possible */
+    struct DecodedBlock *currentBlock; /* the block being worked through, or NULL */
+    emuint blockPosition; /* index of the instruction expected next in the current block */
+    const emubyte *operands; /* decoded operand bytes of the current instruction not yet fetched */
+    emuint operandCount; /* how many of those there are, 0 if the operands come from memory */
+    emuint pageGenerations[CONSOLE_PAGE_COUNT]; /* incremented to throw away the RAM blocks decoded from each page */
+    uint64_t ramPages; /* one bit per page whose code counts as RAM, worked out when the memory map changes */
+    uint64_t pageAliases[CONSOLE_PAGE_COUNT]; /* for each page, the pages whose code a write to it could change */
+    uint64_t ramCodePages; /* one bit per page that RAM blocks have been decoded from */
+    struct DecodedBlock blocks[Z80_BLOCK_COUNT];
+
+    /* idle loop attributes */
+    emuint idleLoopTarget; /* the address the last backward branch went to, or Z80_NO_IDLE_LOOP */
+    emuint idleLoopPasses; /* number of passes in a row this run has made round the loop at that address */
+    emuint idleLoopCycles; /* cycles into the current run at which that branch finished */
+    emubyte idleLoopRefresh; /* value of the refresh register at that branch */
+    emubool idleLoopClean; /* false once the pass since that branch did something a skipped pass couldn't */
+    struct IdleLoopPass lastPass; /* the pass that ended at that branch */
+    struct IdleLoopPass thisPass; /* the pass in progress, which only has its polls filled in as it goes */
+
+#if defined(Z80_PROFILER)
+    /* opcode profiler attributes */
+    emubyte profileTable; /* table of the opcode being executed, or OPCODE_TABLE_COUNT if none */
+    emubyte profileOpcode; /* the opcode being executed within that table */
+    emulong profileCounts[OPCODE_TABLE_COUNT][256]; /* number of times each opcode has been executed */
+    emulong profileCycles[OPCODE_TABLE_COUNT][256]; /* number of cycles each opcode has taken in total */
+#endif
+
+#if defined(Z80_TRACE)
+    /* instruction trace attributes */
+    emubool traceEnabled; /* whether instructions are currently being traced */
+    emubool traceOpen; /* whether the entry at the head is an instruction still in progress */
+    emubool traceFull; /* whether the head has been all the way round the ring */
+    emuint traceTrigger; /* address whose next execution dumps the trace, or Z80_NO_TRACE_TRIGGER */
+    volatile emuint traceHead; /* index of the next entry to write, which keeps counting past the end of the ring */
+    struct TraceEntry trace[Z80_TRACE_LENGTH];
+#endif
 };
 
 /* this function creates a new Z80 object and returns a pointer to it */
-Z80 createZ80(Console ms, emubyte *z80State, emubyte *wholePointer)
+Z80 createZ80(Console ms, emubyte *z80State, emubool blockCache, emubyte *wholePointer)
 {
     /* first, we allocate memory for a Z80 struct */
     Z80 z = (Z80)wholePointer;
  
     /* set Console reference to point to parent Master System object */
     z->ms = ms;
+    z->readPages = console_getReadPages(ms);
+    z->writePages = console_getWritePages(ms);
+
+    /* make sure the flag lookup tables are ready */
+    initialiseFlagTables();
 
     /* initialise cycle counter to zero */
     z->cycles = 0;
@@ -193,8 +514,12 @@ Z80 createZ80(Console ms, emubyte *z80State, emubyte *wholePointer)
     z->halt = 0;
     z->intMode = 1;
     z->followingInstruction = false;
+    z->interruptLine = false;
     z->interruptCounter = 0;
     z->interruptPending = false;
+    z->runCycles = 0;
+    z->runTarget = 0;
+    z->syncedCycles = 0;
 
     /* set main register set */
     z->regA = 0;
@@ -222,12 +547,79 @@ Z80 createZ80(Console ms, emubyte *z80State, emubyte *wholePointer)
     z->regSP = 0xDFF0; /* this seems to be the default stack pointer for a few games */
     z->regI = 0;
     z->regR = 0;
+#if defined(FAST_PROFILE)
+    z->refreshCycles = 0;
+#endif
     z->regPC = 0;
 
     /* setup stub variables */
     z->ddStub = false;
     z->fdStub = false;
 
+    /* setup block cache, which starts off empty */
+    z->blockCache = blockCache;
+    z->currentBlock = NULL;
+    z->blockPosition = 0;
+    z->operands = NULL;
+    z->operandCount = 0;
+    memset((void *)z->pageGenerations, 0, sizeof(z->pageGenerations));
+    memset((void *)z->pageAliases, 0, sizeof(z->pageAliases));
+    z->ramPages = 0;
+    z->ramCodePages = 0;
+    memset((void *)z->blocks, 0, sizeof(z->blocks));
+    if (blockCache)
+        updateCodePages(z);
+
+    /* setup idle loop detection, with no loop seen yet */
+    z->idleLoopTarget = Z80_NO_IDLE_LOOP;
+    z->idleLoopPasses = 0;
+    z->idleLoopCycles = 0;
+    z->idleLoopRefresh = 0;
+    z->idleLoopClean = false;
+    memset((void *)&z->lastPass, 0, sizeof(z->lastPass));
+    memset((void *)&z->thisPass, 0, sizeof(z->thisPass));
+
+#if defined(Z80_PROFILER)
+    /* setup opcode profiler */
+    Z80_resetProfile(z);
+#endif
+
+#if defined(Z80_TRACE)
+    /* setup instruction trace, tracing from the start unless told otherwise */
+    z->traceEnabled = true;
+    z->traceOpen = false;
+    z->traceFull = false;
+    z->traceHead = 0;
+#if defined(Z80_TRACE_TRIGGER)
+    z->traceTrigger = Z80_TRACE_TRIGGER;
+#else
+    z->traceTrigger = Z80_NO_TRACE_TRIGGER;
+#endif
+
+    /* dump the trace to a file next to the save states if the emulator crashes, passing the
+       crash on to whoever was handling it before (such as the system's crash reporter)
+       afterwards - the file stays open from here on so the handler doesn't need to open it */
+    if (crashTraceFd < 0) {
+        char *internalPath = (char *)SDL_AndroidGetInternalStoragePath();
+        if (internalPath != NULL) {
+            char crashTracePath[strlen(internalPath) + 32];
+            sprintf(crashTracePath, "%s/z80_crash_trace.txt", internalPath);
+            if ((crashTraceFd = open(crashTracePath, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+                __android_log_print(ANDROID_LOG_ERROR, "z80.c", "Couldn't create crash trace file at %s\n", crashTracePath);
+        }
+    }
+    if (!crashHandlersInstalled) {
+        struct sigaction action;
+        memset((void *)&action, 0, sizeof(action));
+        action.sa_handler = dumpTraceOnCrash;
+        sigemptyset(&action.sa_mask);
+        for (emuint i = 0; i < Z80_CRASH_SIGNAL_COUNT; ++i)
+            sigaction(crashSignals[i], &action, &previousCrashActions[i]);
+        crashHandlersInstalled = true;
+    }
+    crashTraceZ80 = z;
+#endif
+
     /* set state if present */
     if (z80State != NULL) {
         emuint marker = 4;
@@ -288,20 +680,1898 @@ Z80 createZ80(Console ms, emubyte *z80State, emubyte *wholePointer)
 /* this function destroys the Z80 object */
 void destroyZ80(Z80 z)
 {
-    ;
+#if defined(Z80_PROFILER)
+    /* report on the opcodes executed this session */
+    Z80_reportProfile(z);
+#endif
+#if defined(Z80_TRACE)
+    /* stop the crash handlers from looking at this Z80's trace */
+    if (crashTraceZ80 == z)
+        crashTraceZ80 = NULL;
+#endif
 }
 
+/* the opcode tables below list the instruction function called for every possible opcode
+   of each prefix group, in opcode order - entries doing nothing are opcodes this core does
+   not implement, which (as before) execute no instruction and take no cycles */
+/* this is the table of unprefixed opcodes */
+#define Z80_BASE_OPCODES(X) \
+    X(BASE, 00, NOP(z)) \
+    X(BASE, 01, LD_16Bit(z, BC, nn, 0)) \
+    X(BASE, 02, LD_8Bit(z, aBC, A)) \
+    X(BASE, 03, INC(z, BC)) \
+    X(BASE, 04, INC(z, B)) \
+    X(BASE, 05, DEC(z, B)) \
+    X(BASE, 06, LD_8Bit(z, B, n)) \
+    X(BASE, 07, RLCA(z)) \
+    X(BASE, 08, EX(z, AF, AFShadow)) \
+    X(BASE, 09, ADD(z, HL, BC)) \
+    X(BASE, 0A, LD_8Bit(z, A, aBC)) \
+    X(BASE, 0B, DEC(z, BC)) \
+    X(BASE, 0C, INC(z, C)) \
+    X(BASE, 0D, DEC(z, C)) \
+    X(BASE, 0E, LD_8Bit(z, C, n)) \
+    X(BASE, 0F, RRCA(z)) \
+    X(BASE, 10, DJNZ(z)) \
+    X(BASE, 11, LD_16Bit(z, DE, nn, 0)) \
+    X(BASE, 12, LD_8Bit(z, aDE, A)) \
+    X(BASE, 13, INC(z, DE)) \
+    X(BASE, 14, INC(z, D)) \
+    X(BASE, 15, DEC(z, D)) \
+    X(BASE, 16, LD_8Bit(z, D, n)) \
+    X(BASE, 17, RLA(z)) \
+    X(BASE, 18, JR(z)) \
+    X(BASE, 19, ADD(z, HL, DE)) \
+    X(BASE, 1A, LD_8Bit(z, A, aDE)) \
+    X(BASE, 1B, DEC(z, DE)) \
+    X(BASE, 1C, INC(z, E)) \
+    X(BASE, 1D, DEC(z, E)) \
+    X(BASE, 1E, LD_8Bit(z, E, n)) \
+    X(BASE, 1F, RRA(z)) \
+    X(BASE, 20, JR_CONDITIONAL(z, NZ)) \
+    X(BASE, 21, LD_16Bit(z, HL, nn, 0)) \
+    X(BASE, 22, LD_16Bit(z, a_nn, HL, 0)) \
+    X(BASE, 23, INC(z, HL)) \
+    X(BASE, 24, INC(z, H)) \
+    X(BASE, 25, DEC(z, H)) \
+    X(BASE, 26, LD_8Bit(z, H, n)) \
+    X(BASE, 27, DAA(z)) \
+    X(BASE, 28, JR_CONDITIONAL(z, Z)) \
+    X(BASE, 29, ADD(z, HL, HL)) \
+    X(BASE, 2A, LD_16Bit(z, HL, a_nn, 0)) \
+    X(BASE, 2B, DEC(z, HL)) \
+    X(BASE, 2C, INC(z, L)) \
+    X(BASE, 2D, DEC(z, L)) \
+    X(BASE, 2E, LD_8Bit(z, L, n)) \
+    X(BASE, 2F, CPL(z)) \
+    X(BASE, 30, JR_CONDITIONAL(z, NC)) \
+    X(BASE, 31, LD_16Bit(z, SP, nn, 0)) \
+    X(BASE, 32, LD_8Bit(z, a_nn, A)) \
+    X(BASE, 33, INC(z, SP)) \
+    X(BASE, 34, INC(z, aHL)) \
+    X(BASE, 35, DEC(z, aHL)) \
+    X(BASE, 36, LD_8Bit(z, aHL, n)) \
+    X(BASE, 37, SCF(z)) \
+    X(BASE, 38, JR_CONDITIONAL(z, C)) \
+    X(BASE, 39, ADD(z, HL, SP)) \
+    X(BASE, 3A, LD_8Bit(z, A, a_nn)) \
+    X(BASE, 3B, DEC(z, SP)) \
+    X(BASE, 3C, INC(z, A)) \
+    X(BASE, 3D, DEC(z, A)) \
+    X(BASE, 3E, LD_8Bit(z, A, n)) \
+    X(BASE, 3F, CCF(z)) \
+    X(BASE, 40, LD_8Bit(z, B, B)) \
+    X(BASE, 41, LD_8Bit(z, B, C)) \
+    X(BASE, 42, LD_8Bit(z, B, D)) \
+    X(BASE, 43, LD_8Bit(z, B, E)) \
+    X(BASE, 44, LD_8Bit(z, B, H)) \
+    X(BASE, 45, LD_8Bit(z, B, L)) \
+    X(BASE, 46, LD_8Bit(z, B, aHL)) \
+    X(BASE, 47, LD_8Bit(z, B, A)) \
+    X(BASE, 48, LD_8Bit(z, C, B)) \
+    X(BASE, 49, LD_8Bit(z, C, C)) \
+    X(BASE, 4A, LD_8Bit(z, C, D)) \
+    X(BASE, 4B, LD_8Bit(z, C, E)) \
+    X(BASE, 4C, LD_8Bit(z, C, H)) \
+    X(BASE, 4D, LD_8Bit(z, C, L)) \
+    X(BASE, 4E, LD_8Bit(z, C, aHL)) \
+    X(BASE, 4F, LD_8Bit(z, C, A)) \
+    X(BASE, 50, LD_8Bit(z, D, B)) \
+    X(BASE, 51, LD_8Bit(z, D, C)) \
+    X(BASE, 52, LD_8Bit(z, D, D)) \
+    X(BASE, 53, LD_8Bit(z, D, E)) \
+    X(BASE, 54, LD_8Bit(z, D, H)) \
+    X(BASE, 55, LD_8Bit(z, D, L)) \
+    X(BASE, 56, LD_8Bit(z, D, aHL)) \
+    X(BASE, 57, LD_8Bit(z, D, A)) \
+    X(BASE, 58, LD_8Bit(z, E, B)) \
+    X(BASE, 59, LD_8Bit(z, E, C)) \
+    X(BASE, 5A, LD_8Bit(z, E, D)) \
+    X(BASE, 5B, LD_8Bit(z, E, E)) \
+    X(BASE, 5C, LD_8Bit(z, E, H)) \
+    X(BASE, 5D, LD_8Bit(z, E, L)) \
+    X(BASE, 5E, LD_8Bit(z, E, aHL)) \
+    X(BASE, 5F, LD_8Bit(z, E, A)) \
+    X(BASE, 60, LD_8Bit(z, H, B)) \
+    X(BASE, 61, LD_8Bit(z, H, C)) \
+    X(BASE, 62, LD_8Bit(z, H, D)) \
+    X(BASE, 63, LD_8Bit(z, H, E)) \
+    X(BASE, 64, LD_8Bit(z, H, H)) \
+    X(BASE, 65, LD_8Bit(z, H, L)) \
+    X(BASE, 66, LD_8Bit(z, H, aHL)) \
+    X(BASE, 67, LD_8Bit(z, H, A)) \
+    X(BASE, 68, LD_8Bit(z, L, B)) \
+    X(BASE, 69, LD_8Bit(z, L, C)) \
+    X(BASE, 6A, LD_8Bit(z, L, D)) \
+    X(BASE, 6B, LD_8Bit(z, L, E)) \
+    X(BASE, 6C, LD_8Bit(z, L, H)) \
+    X(BASE, 6D, LD_8Bit(z, L, L)) \
+    X(BASE, 6E, LD_8Bit(z, L, aHL)) \
+    X(BASE, 6F, LD_8Bit(z, L, A)) \
+    X(BASE, 70, LD_8Bit(z, aHL, B)) \
+    X(BASE, 71, LD_8Bit(z, aHL, C)) \
+    X(BASE, 72, LD_8Bit(z, aHL, D)) \
+    X(BASE, 73, LD_8Bit(z, aHL, E)) \
+    X(BASE, 74, LD_8Bit(z, aHL, H)) \
+    X(BASE, 75, LD_8Bit(z, aHL, L)) \
+    X(BASE, 76, HALT(z)) \
+    X(BASE, 77, LD_8Bit(z, aHL, A)) \
+    X(BASE, 78, LD_8Bit(z, A, B)) \
+    X(BASE, 79, LD_8Bit(z, A, C)) \
+    X(BASE, 7A, LD_8Bit(z, A, D)) \
+    X(BASE, 7B, LD_8Bit(z, A, E)) \
+    X(BASE, 7C, LD_8Bit(z, A, H)) \
+    X(BASE, 7D, LD_8Bit(z, A, L)) \
+    X(BASE, 7E, LD_8Bit(z, A, aHL)) \
+    X(BASE, 7F, LD_8Bit(z, A, A)) \
+    X(BASE, 80, ADD(z, A, B)) \
+    X(BASE, 81, ADD(z, A, C)) \
+    X(BASE, 82, ADD(z, A, D)) \
+    X(BASE, 83, ADD(z, A, E)) \
+    X(BASE, 84, ADD(z, A, H)) \
+    X(BASE, 85, ADD(z, A, L)) \
+    X(BASE, 86, ADD(z, A, aHL)) \
+    X(BASE, 87, ADD(z, A, A)) \
+    X(BASE, 88, ADC(z, B)) \
+    X(BASE, 89, ADC(z, C)) \
+    X(BASE, 8A, ADC(z, D)) \
+    X(BASE, 8B, ADC(z, E)) \
+    X(BASE, 8C, ADC(z, H)) \
+    X(BASE, 8D, ADC(z, L)) \
+    X(BASE, 8E, ADC(z, aHL)) \
+    X(BASE, 8F, ADC(z, A)) \
+    X(BASE, 90, SUB(z, B)) \
+    X(BASE, 91, SUB(z, C)) \
+    X(BASE, 92, SUB(z, D)) \
+    X(BASE, 93, SUB(z, E)) \
+    X(BASE, 94, SUB(z, H)) \
+    X(BASE, 95, SUB(z, L)) \
+    X(BASE, 96, SUB(z, aHL)) \
+    X(BASE, 97, SUB(z, A)) \
+    X(BASE, 98, SBC(z, B)) \
+    X(BASE, 99, SBC(z, C)) \
+    X(BASE, 9A, SBC(z, D)) \
+    X(BASE, 9B, SBC(z, E)) \
+    X(BASE, 9C, SBC(z, H)) \
+    X(BASE, 9D, SBC(z, L)) \
+    X(BASE, 9E, SBC(z, aHL)) \
+    X(BASE, 9F, SBC(z, A)) \
+    X(BASE, A0, AND(z, B)) \
+    X(BASE, A1, AND(z, C)) \
+    X(BASE, A2, AND(z, D)) \
+    X(BASE, A3, AND(z, E)) \
+    X(BASE, A4, AND(z, H)) \
+    X(BASE, A5, AND(z, L)) \
+    X(BASE, A6, AND(z, aHL)) \
+    X(BASE, A7, AND(z, A)) \
+    X(BASE, A8, XOR(z, B)) \
+    X(BASE, A9, XOR(z, C)) \
+    X(BASE, AA, XOR(z, D)) \
+    X(BASE, AB, XOR(z, E)) \
+    X(BASE, AC, XOR(z, H)) \
+    X(BASE, AD, XOR(z, L)) \
+    X(BASE, AE, XOR(z, aHL)) \
+    X(BASE, AF, XOR(z, A)) \
+    X(BASE, B0, OR(z, B)) \
+    X(BASE, B1, OR(z, C)) \
+    X(BASE, B2, OR(z, D)) \
+    X(BASE, B3, OR(z, E)) \
+    X(BASE, B4, OR(z, H)) \
+    X(BASE, B5, OR(z, L)) \
+    X(BASE, B6, OR(z, aHL)) \
+    X(BASE, B7, OR(z, A)) \
+    X(BASE, B8, CP(z, B)) \
+    X(BASE, B9, CP(z, C)) \
+    X(BASE, BA, CP(z, D)) \
+    X(BASE, BB, CP(z, E)) \
+    X(BASE, BC, CP(z, H)) \
+    X(BASE, BD, CP(z, L)) \
+    X(BASE, BE, CP(z, aHL)) \
+    X(BASE, BF, CP(z, A)) \
+    X(BASE, C0, RET_CONDITIONAL(z, NZ)) \
+    X(BASE, C1, POP(z, BC)) \
+    X(BASE, C2, JP_CONDITIONAL(z, NZ)) \
+    X(BASE, C3, JP(z, nn)) \
+    X(BASE, C4, CALL_CONDITIONAL(z, NZ)) \
+    X(BASE, C5, PUSH(z, BC)) \
+    X(BASE, C6, ADD(z, A, n)) \
+    X(BASE, C7, RST(z, 0x00)) \
+    X(BASE, C8, RET_CONDITIONAL(z, Z)) \
+    X(BASE, C9, RET(z)) \
+    X(BASE, CA, JP_CONDITIONAL(z, Z)) \
+    X(BASE, CB, Z80_DISPATCH(CB)) \
+    X(BASE, CC, CALL_CONDITIONAL(z, Z)) \
+    X(BASE, CD, CALL(z)) \
+    X(BASE, CE, ADC(z, n)) \
+    X(BASE, CF, RST(z, 0x08)) \
+    X(BASE, D0, RET_CONDITIONAL(z, NC)) \
+    X(BASE, D1, POP(z, DE)) \
+    X(BASE, D2, JP_CONDITIONAL(z, NC)) \
+    X(BASE, D3, OUT(z, a_n, A)) \
+    X(BASE, D4, CALL_CONDITIONAL(z, NC)) \
+    X(BASE, D5, PUSH(z, DE)) \
+    X(BASE, D6, SUB(z, n)) \
+    X(BASE, D7, RST(z, 0x10)) \
+    X(BASE, D8, RET_CONDITIONAL(z, C)) \
+    X(BASE, D9, EXX(z)) \
+    X(BASE, DA, JP_CONDITIONAL(z, C)) \
+    X(BASE, DB, IN(z, A, a_n)) \
+    X(BASE, DC, CALL_CONDITIONAL(z, C)) \
+    X(BASE, DD, Z80_DISPATCH(DD)) \
+    X(BASE, DE, SBC(z, n)) \
+    X(BASE, DF, RST(z, 0x18)) \
+    X(BASE, E0, RET_CONDITIONAL(z, PO)) \
+    X(BASE, E1, POP(z, HL)) \
+    X(BASE, E2, JP_CONDITIONAL(z, PO)) \
+    X(BASE, E3, EX(z, aSP, HL)) \
+    X(BASE, E4, CALL_CONDITIONAL(z, PO)) \
+    X(BASE, E5, PUSH(z, HL)) \
+    X(BASE, E6, AND(z, n)) \
+    X(BASE, E7, RST(z, 0x20)) \
+    X(BASE, E8, RET_CONDITIONAL(z, PE)) \
+    X(BASE, E9, JP(z, HL)) \
+    X(BASE, EA, JP_CONDITIONAL(z, PE)) \
+    X(BASE, EB, EX(z, DE, HL)) \
+    X(BASE, EC, CALL_CONDITIONAL(z, PE)) \
+    X(BASE, ED, Z80_DISPATCH(ED)) \
+    X(BASE, EE, XOR(z, n)) \
+    X(BASE, EF, RST(z, 0x28)) \
+    X(BASE, F0, RET_CONDITIONAL(z, P)) \
+    X(BASE, F1, POP(z, AF)) \
+    X(BASE, F2, JP_CONDITIONAL(z, P)) \
+    X(BASE, F3, DI(z)) \
+    X(BASE, F4, CALL_CONDITIONAL(z, P)) \
+    X(BASE, F5, PUSH(z, AF)) \
+    X(BASE, F6, OR(z, n)) \
+    X(BASE, F7, RST(z, 0x30)) \
+    X(BASE, F8, RET_CONDITIONAL(z, M)) \
+    X(BASE, F9, LD_16Bit(z, SP, HL, 0)) \
+    X(BASE, FA, JP_CONDITIONAL(z, M)) \
+    X(BASE, FB, EI(z)) \
+    X(BASE, FC, CALL_CONDITIONAL(z, M)) \
+    X(BASE, FD, Z80_DISPATCH(FD)) \
+    X(BASE, FE, CP(z, n)) \
+    X(BASE, FF, RST(z, 0x38))
+
+/* this is the table of CB prefixed opcodes */
+#define Z80_CB_OPCODES(X) \
+    X(CB, 00, RLC(z, B)) \
+    X(CB, 01, RLC(z, C)) \
+    X(CB, 02, RLC(z, D)) \
+    X(CB, 03, RLC(z, E)) \
+    X(CB, 04, RLC(z, H)) \
+    X(CB, 05, RLC(z, L)) \
+    X(CB, 06, RLC(z, aHL)) \
+    X(CB, 07, RLC(z, A)) \
+    X(CB, 08, RRC(z, B)) \
+    X(CB, 09, RRC(z, C)) \
+    X(CB, 0A, RRC(z, D)) \
+    X(CB, 0B, RRC(z, E)) \
+    X(CB, 0C, RRC(z, H)) \
+    X(CB, 0D, RRC(z, L)) \
+    X(CB, 0E, RRC(z, aHL)) \
+    X(CB, 0F, RRC(z, A)) \
+    X(CB, 10, RL(z, B)) \
+    X(CB, 11, RL(z, C)) \
+    X(CB, 12, RL(z, D)) \
+    X(CB, 13, RL(z, E)) \
+    X(CB, 14, RL(z, H)) \
+    X(CB, 15, RL(z, L)) \
+    X(CB, 16, RL(z, aHL)) \
+    X(CB, 17, RL(z, A)) \
+    X(CB, 18, RR(z, B)) \
+    X(CB, 19, RR(z, C)) \
+    X(CB, 1A, RR(z, D)) \
+    X(CB, 1B, RR(z, E)) \
+    X(CB, 1C, RR(z, H)) \
+    X(CB, 1D, RR(z, L)) \
+    X(CB, 1E, RR(z, aHL)) \
+    X(CB, 1F, RR(z, A)) \
+    X(CB, 20, SLA(z, B)) \
+    X(CB, 21, SLA(z, C)) \
+    X(CB, 22, SLA(z, D)) \
+    X(CB, 23, SLA(z, E)) \
+    X(CB, 24, SLA(z, H)) \
+    X(CB, 25, SLA(z, L)) \
+    X(CB, 26, SLA(z, aHL)) \
+    X(CB, 27, SLA(z, A)) \
+    X(CB, 28, SRA(z, B)) \
+    X(CB, 29, SRA(z, C)) \
+    X(CB, 2A, SRA(z, D)) \
+    X(CB, 2B, SRA(z, E)) \
+    X(CB, 2C, SRA(z, H)) \
+    X(CB, 2D, SRA(z, L)) \
+    X(CB, 2E, SRA(z, aHL)) \
+    X(CB, 2F, SRA(z, A)) \
+    X(CB, 30, SLL(z, B)) /* undocumented */ \
+    X(CB, 31, SLL(z, C)) /* undocumented */ \
+    X(CB, 32, SLL(z, D)) /* undocumented */ \
+    X(CB, 33, SLL(z, E)) /* undocumented */ \
+    X(CB, 34, SLL(z, H)) /* undocumented */ \
+    X(CB, 35, SLL(z, L)) /* undocumented */ \
+    X(CB, 36, SLL(z, aHL)) /* undocumented */ \
+    X(CB, 37, SLL(z, A)) /* undocumented */ \
+    X(CB, 38, SRL(z, B)) \
+    X(CB, 39, SRL(z, C)) \
+    X(CB, 3A, SRL(z, D)) \
+    X(CB, 3B, SRL(z, E)) \
+    X(CB, 3C, SRL(z, H)) \
+    X(CB, 3D, SRL(z, L)) \
+    X(CB, 3E, SRL(z, aHL)) \
+    X(CB, 3F, SRL(z, A)) \
+    X(CB, 40, BIT(z, 0, B)) \
+    X(CB, 41, BIT(z, 0, C)) \
+    X(CB, 42, BIT(z, 0, D)) \
+    X(CB, 43, BIT(z, 0, E)) \
+    X(CB, 44, BIT(z, 0, H)) \
+    X(CB, 45, BIT(z, 0, L)) \
+    X(CB, 46, BIT(z, 0, aHL)) \
+    X(CB, 47, BIT(z, 0, A)) \
+    X(CB, 48, BIT(z, 1, B)) \
+    X(CB, 49, BIT(z, 1, C)) \
+    X(CB, 4A, BIT(z, 1, D)) \
+    X(CB, 4B, BIT(z, 1, E)) \
+    X(CB, 4C, BIT(z, 1, H)) \
+    X(CB, 4D, BIT(z, 1, L)) \
+    X(CB, 4E, BIT(z, 1, aHL)) \
+    X(CB, 4F, BIT(z, 1, A)) \
+    X(CB, 50, BIT(z, 2, B)) \
+    X(CB, 51, BIT(z, 2, C)) \
+    X(CB, 52, BIT(z, 2, D)) \
+    X(CB, 53, BIT(z, 2, E)) \
+    X(CB, 54, BIT(z, 2, H)) \
+    X(CB, 55, BIT(z, 2, L)) \
+    X(CB, 56, BIT(z, 2, aHL)) \
+    X(CB, 57, BIT(z, 2, A)) \
+    X(CB, 58, BIT(z, 3, B)) \
+    X(CB, 59, BIT(z, 3, C)) \
+    X(CB, 5A, BIT(z, 3, D)) \
+    X(CB, 5B, BIT(z, 3, E)) \
+    X(CB, 5C, BIT(z, 3, H)) \
+    X(CB, 5D, BIT(z, 3, L)) \
+    X(CB, 5E, BIT(z, 3, aHL)) \
+    X(CB, 5F, BIT(z, 3, A)) \
+    X(CB, 60, BIT(z, 4, B)) \
+    X(CB, 61, BIT(z, 4, C)) \
+    X(CB, 62, BIT(z, 4, D)) \
+    X(CB, 63, BIT(z, 4, E)) \
+    X(CB, 64, BIT(z, 4, H)) \
+    X(CB, 65, BIT(z, 4, L)) \
+    X(CB, 66, BIT(z, 4, aHL)) \
+    X(CB, 67, BIT(z, 4, A)) \
+    X(CB, 68, BIT(z, 5, B)) \
+    X(CB, 69, BIT(z, 5, C)) \
+    X(CB, 6A, BIT(z, 5, D)) \
+    X(CB, 6B, BIT(z, 5, E)) \
+    X(CB, 6C, BIT(z, 5, H)) \
+    X(CB, 6D, BIT(z, 5, L)) \
+    X(CB, 6E, BIT(z, 5, aHL)) \
+    X(CB, 6F, BIT(z, 5, A)) \
+    X(CB, 70, BIT(z, 6, B)) \
+    X(CB, 71, BIT(z, 6, C)) \
+    X(CB, 72, BIT(z, 6, D)) \
+    X(CB, 73, BIT(z, 6, E)) \
+    X(CB, 74, BIT(z, 6, H)) \
+    X(CB, 75, BIT(z, 6, L)) \
+    X(CB, 76, BIT(z, 6, aHL)) \
+    X(CB, 77, BIT(z, 6, A)) \
+    X(CB, 78, BIT(z, 7, B)) \
+    X(CB, 79, BIT(z, 7, C)) \
+    X(CB, 7A, BIT(z, 7, D)) \
+    X(CB, 7B, BIT(z, 7, E)) \
+    X(CB, 7C, BIT(z, 7, H)) \
+    X(CB, 7D, BIT(z, 7, L)) \
+    X(CB, 7E, BIT(z, 7, aHL)) \
+    X(CB, 7F, BIT(z, 7, A)) \
+    X(CB, 80, RES(z, 0, B)) \
+    X(CB, 81, RES(z, 0, C)) \
+    X(CB, 82, RES(z, 0, D)) \
+    X(CB, 83, RES(z, 0, E)) \
+    X(CB, 84, RES(z, 0, H)) \
+    X(CB, 85, RES(z, 0, L)) \
+    X(CB, 86, RES(z, 0, aHL)) \
+    X(CB, 87, RES(z, 0, A)) \
+    X(CB, 88, RES(z, 1, B)) \
+    X(CB, 89, RES(z, 1, C)) \
+    X(CB, 8A, RES(z, 1, D)) \
+    X(CB, 8B, RES(z, 1, E)) \
+    X(CB, 8C, RES(z, 1, H)) \
+    X(CB, 8D, RES(z, 1, L)) \
+    X(CB, 8E, RES(z, 1, aHL)) \
+    X(CB, 8F, RES(z, 1, A)) \
+    X(CB, 90, RES(z, 2, B)) \
+    X(CB, 91, RES(z, 2, C)) \
+    X(CB, 92, RES(z, 2, D)) \
+    X(CB, 93, RES(z, 2, E)) \
+    X(CB, 94, RES(z, 2, H)) \
+    X(CB, 95, RES(z, 2, L)) \
+    X(CB, 96, RES(z, 2, aHL)) \
+    X(CB, 97, RES(z, 2, A)) \
+    X(CB, 98, RES(z, 3, B)) \
+    X(CB, 99, RES(z, 3, C)) \
+    X(CB, 9A, RES(z, 3, D)) \
+    X(CB, 9B, RES(z, 3, E)) \
+    X(CB, 9C, RES(z, 3, H)) \
+    X(CB, 9D, RES(z, 3, L)) \
+    X(CB, 9E, RES(z, 3, aHL)) \
+    X(CB, 9F, RES(z, 3, A)) \
+    X(CB, A0, RES(z, 4, B)) \
+    X(CB, A1, RES(z, 4, C)) \
+    X(CB, A2, RES(z, 4, D)) \
+    X(CB, A3, RES(z, 4, E)) \
+    X(CB, A4, RES(z, 4, H)) \
+    X(CB, A5, RES(z, 4, L)) \
+    X(CB, A6, RES(z, 4, aHL)) \
+    X(CB, A7, RES(z, 4, A)) \
+    X(CB, A8, RES(z, 5, B)) \
+    X(CB, A9, RES(z, 5, C)) \
+    X(CB, AA, RES(z, 5, D)) \
+    X(CB, AB, RES(z, 5, E)) \
+    X(CB, AC, RES(z, 5, H)) \
+    X(CB, AD, RES(z, 5, L)) \
+    X(CB, AE, RES(z, 5, aHL)) \
+    X(CB, AF, RES(z, 5, A)) \
+    X(CB, B0, RES(z, 6, B)) \
+    X(CB, B1, RES(z, 6, C)) \
+    X(CB, B2, RES(z, 6, D)) \
+    X(CB, B3, RES(z, 6, E)) \
+    X(CB, B4, RES(z, 6, H)) \
+    X(CB, B5, RES(z, 6, L)) \
+    X(CB, B6, RES(z, 6, aHL)) \
+    X(CB, B7, RES(z, 6, A)) \
+    X(CB, B8, RES(z, 7, B)) \
+    X(CB, B9, RES(z, 7, C)) \
+    X(CB, BA, RES(z, 7, D)) \
+    X(CB, BB, RES(z, 7, E)) \
+    X(CB, BC, RES(z, 7, H)) \
+    X(CB, BD, RES(z, 7, L)) \
+    X(CB, BE, RES(z, 7, aHL)) \
+    X(CB, BF, RES(z, 7, A)) \
+    X(CB, C0, SET(z, 0, B)) \
+    X(CB, C1, SET(z, 0, C)) \
+    X(CB, C2, SET(z, 0, D)) \
+    X(CB, C3, SET(z, 0, E)) \
+    X(CB, C4, SET(z, 0, H)) \
+    X(CB, C5, SET(z, 0, L)) \
+    X(CB, C6, SET(z, 0, aHL)) \
+    X(CB, C7, SET(z, 0, A)) \
+    X(CB, C8, SET(z, 1, B)) \
+    X(CB, C9, SET(z, 1, C)) \
+    X(CB, CA, SET(z, 1, D)) \
+    X(CB, CB, SET(z, 1, E)) \
+    X(CB, CC, SET(z, 1, H)) \
+    X(CB, CD, SET(z, 1, L)) \
+    X(CB, CE, SET(z, 1, aHL)) \
+    X(CB, CF, SET(z, 1, A)) \
+    X(CB, D0, SET(z, 2, B)) \
+    X(CB, D1, SET(z, 2, C)) \
+    X(CB, D2, SET(z, 2, D)) \
+    X(CB, D3, SET(z, 2, E)) \
+    X(CB, D4, SET(z, 2, H)) \
+    X(CB, D5, SET(z, 2, L)) \
+    X(CB, D6, SET(z, 2, aHL)) \
+    X(CB, D7, SET(z, 2, A)) \
+    X(CB, D8, SET(z, 3, B)) \
+    X(CB, D9, SET(z, 3, C)) \
+    X(CB, DA, SET(z, 3, D)) \
+    X(CB, DB, SET(z, 3, E)) \
+    X(CB, DC, SET(z, 3, H)) \
+    X(CB, DD, SET(z, 3, L)) \
+    X(CB, DE, SET(z, 3, aHL)) \
+    X(CB, DF, SET(z, 3, A)) \
+    X(CB, E0, SET(z, 4, B)) \
+    X(CB, E1, SET(z, 4, C)) \
+    X(CB, E2, SET(z, 4, D)) \
+    X(CB, E3, SET(z, 4, E)) \
+    X(CB, E4, SET(z, 4, H)) \
+    X(CB, E5, SET(z, 4, L)) \
+    X(CB, E6, SET(z, 4, aHL)) \
+    X(CB, E7, SET(z, 4, A)) \
+    X(CB, E8, SET(z, 5, B)) \
+    X(CB, E9, SET(z, 5, C)) \
+    X(CB, EA, SET(z, 5, D)) \
+    X(CB, EB, SET(z, 5, E)) \
+    X(CB, EC, SET(z, 5, H)) \
+    X(CB, ED, SET(z, 5, L)) \
+    X(CB, EE, SET(z, 5, aHL)) \
+    X(CB, EF, SET(z, 5, A)) \
+    X(CB, F0, SET(z, 6, B)) \
+    X(CB, F1, SET(z, 6, C)) \
+    X(CB, F2, SET(z, 6, D)) \
+    X(CB, F3, SET(z, 6, E)) \
+    X(CB, F4, SET(z, 6, H)) \
+    X(CB, F5, SET(z, 6, L)) \
+    X(CB, F6, SET(z, 6, aHL)) \
+    X(CB, F7, SET(z, 6, A)) \
+    X(CB, F8, SET(z, 7, B)) \
+    X(CB, F9, SET(z, 7, C)) \
+    X(CB, FA, SET(z, 7, D)) \
+    X(CB, FB, SET(z, 7, E)) \
+    X(CB, FC, SET(z, 7, H)) \
+    X(CB, FD, SET(z, 7, L)) \
+    X(CB, FE, SET(z, 7, aHL)) \
+    X(CB, FF, SET(z, 7, A))
+
+/* this is the table of DD prefixed opcodes */
+#define Z80_DD_OPCODES(X) \
+    X(DD, 00, (void)z) \
+    X(DD, 01, (void)z) \
+    X(DD, 02, (void)z) \
+    X(DD, 03, (void)z) \
+    X(DD, 04, (void)z) \
+    X(DD, 05, (void)z) \
+    X(DD, 06, (void)z) \
+    X(DD, 07, (void)z) \
+    X(DD, 08, (void)z) \
+    X(DD, 09, ADD(z, IX, BC)) \
+    X(DD, 0A, (void)z) \
+    X(DD, 0B, (void)z) \
+    X(DD, 0C, (void)z) \
+    X(DD, 0D, (void)z) \
+    X(DD, 0E, (void)z) \
+    X(DD, 0F, (void)z) \
+    X(DD, 10, (void)z) \
+    X(DD, 11, (void)z) \
+    X(DD, 12, (void)z) \
+    X(DD, 13, (void)z) \
+    X(DD, 14, (void)z) \
+    X(DD, 15, (void)z) \
+    X(DD, 16, (void)z) \
+    X(DD, 17, (void)z) \
+    X(DD, 18, (void)z) \
+    X(DD, 19, ADD(z, IX, DE)) \
+    X(DD, 1A, (void)z) \
+    X(DD, 1B, (void)z) \
+    X(DD, 1C, (void)z) \
+    X(DD, 1D, (void)z) \
+    X(DD, 1E, (void)z) \
+    X(DD, 1F, (void)z) \
+    X(DD, 20, (void)z) \
+    X(DD, 21, LD_16Bit(z, IX, nn, 0)) \
+    X(DD, 22, LD_16Bit(z, a_nn, IX, 0)) \
+    X(DD, 23, INC(z, IX)) \
+    X(DD, 24, INC(z, IXh)) /* undocumented */ \
+    X(DD, 25, DEC(z, IXh)) /* undocumented */ \
+    X(DD, 26, LD_8Bit(z, IXh, n)) /* undocumented */ \
+    X(DD, 27, (void)z) \
+    X(DD, 28, (void)z) \
+    X(DD, 29, ADD(z, IX, IX)) \
+    X(DD, 2A, LD_16Bit(z, IX, a_nn, 0)) \
+    X(DD, 2B, DEC(z, IX)) \
+    X(DD, 2C, INC(z, IXl)) /* undocumented */ \
+    X(DD, 2D, DEC(z, IXl)) /* undocumented */ \
+    X(DD, 2E, LD_8Bit(z, IXl, n)) /* undocumented */ \
+    X(DD, 2F, (void)z) \
+    X(DD, 30, (void)z) \
+    X(DD, 31, (void)z) \
+    X(DD, 32, (void)z) \
+    X(DD, 33, (void)z) \
+    X(DD, 34, INC(z, IXd)) \
+    X(DD, 35, DEC(z, IXd)) \
+    X(DD, 36, LD_8Bit(z, IXd, n)) \
+    X(DD, 37, (void)z) \
+    X(DD, 38, (void)z) \
+    X(DD, 39, ADD(z, IX, SP)) \
+    X(DD, 3A, (void)z) \
+    X(DD, 3B, (void)z) \
+    X(DD, 3C, (void)z) \
+    X(DD, 3D, (void)z) \
+    X(DD, 3E, (void)z) \
+    X(DD, 3F, (void)z) \
+    X(DD, 40, LD_8Bit(z, B, B)) /* undocumented call */ \
+    X(DD, 41, LD_8Bit(z, B, C)) /* undocumented call */ \
+    X(DD, 42, LD_8Bit(z, B, D)) /* undocumented call */ \
+    X(DD, 43, LD_8Bit(z, B, E)) /* undocumented call */ \
+    X(DD, 44, LD_8Bit(z, B, IXh)) /* undocumented */ \
+    X(DD, 45, LD_8Bit(z, B, IXl)) /* undocumented */ \
+    X(DD, 46, LD_8Bit(z, B, IXd)) \
+    X(DD, 47, LD_8Bit(z, B, A)) /* undocumented call */ \
+    X(DD, 48, LD_8Bit(z, C, B)) /* undocumented call */ \
+    X(DD, 49, LD_8Bit(z, C, C)) /* undocumented call */ \
+    X(DD, 4A, LD_8Bit(z, C, D)) /* undocumented call */ \
+    X(DD, 4B, LD_8Bit(z, C, E)) /* undocumented call */ \
+    X(DD, 4C, LD_8Bit(z, C, IXh)) /* undocumented */ \
+    X(DD, 4D, LD_8Bit(z, C, IXl)) /* undocumented */ \
+    X(DD, 4E, LD_8Bit(z, C, IXd)) \
+    X(DD, 4F, LD_8Bit(z, C, A)) /* undocumented call */ \
+    X(DD, 50, LD_8Bit(z, D, B)) /* undocumented call */ \
+    X(DD, 51, LD_8Bit(z, D, C)) /* undocumented call */ \
+    X(DD, 52, LD_8Bit(z, D, D)) /* undocumented call */ \
+    X(DD, 53, LD_8Bit(z, D, E)) /* undocumented call */ \
+    X(DD, 54, LD_8Bit(z, D, IXh)) /* undocumented */ \
+    X(DD, 55, LD_8Bit(z, D, IXl)) /* undocumented */ \
+    X(DD, 56, LD_8Bit(z, D, IXd)) \
+    X(DD, 57, LD_8Bit(z, D, A)) /* undocumented call */ \
+    X(DD, 58, LD_8Bit(z, E, B)) /* undocumented call */ \
+    X(DD, 59, LD_8Bit(z, E, C)) /* undocumented call */ \
+    X(DD, 5A, LD_8Bit(z, E, D)) /* undocumented call */ \
+    X(DD, 5B, LD_8Bit(z, E, E)) /* undocumented call */ \
+    X(DD, 5C, LD_8Bit(z, E, IXh)) /* undocumented */ \
+    X(DD, 5D, LD_8Bit(z, E, IXl)) /* undocumented */ \
+    X(DD, 5E, LD_8Bit(z, E, IXd)) \
+    X(DD, 5F, LD_8Bit(z, E, A)) /* undocumented call */ \
+    X(DD, 60, LD_8Bit(z, IXh, B)) /* undocumented */ \
+    X(DD, 61, LD_8Bit(z, IXh, C)) /* undocumented */ \
+    X(DD, 62, LD_8Bit(z, IXh, D)) /* undocumented */ \
+    X(DD, 63, LD_8Bit(z, IXh, E)) /* undocumented */ \
+    X(DD, 64, LD_8Bit(z, IXh, IXh)) /* undocumented */ \
+    X(DD, 65, LD_8Bit(z, IXh, IXl)) /* undocumented */ \
+    X(DD, 66, LD_8Bit(z, H, IXd)) \
+    X(DD, 67, LD_8Bit(z, IXh, A)) /* undocumented */ \
+    X(DD, 68, LD_8Bit(z, IXl, B)) /* undocumented */ \
+    X(DD, 69, LD_8Bit(z, IXl, C)) /* undocumented */ \
+    X(DD, 6A, LD_8Bit(z, IXl, D)) /* undocumented */ \
+    X(DD, 6B, LD_8Bit(z, IXl, E)) /* undocumented */ \
+    X(DD, 6C, LD_8Bit(z, IXl, IXh)) /* undocumented */ \
+    X(DD, 6D, LD_8Bit(z, IXl, IXl)) /* undocumented */ \
+    X(DD, 6E, LD_8Bit(z, L, IXd)) \
+    X(DD, 6F, LD_8Bit(z, IXl, A)) /* undocumented */ \
+    X(DD, 70, LD_8Bit(z, IXd, B)) \
+    X(DD, 71, LD_8Bit(z, IXd, C)) \
+    X(DD, 72, LD_8Bit(z, IXd, D)) \
+    X(DD, 73, LD_8Bit(z, IXd, E)) \
+    X(DD, 74, LD_8Bit(z, IXd, H)) \
+    X(DD, 75, LD_8Bit(z, IXd, L)) \
+    X(DD, 76, (void)z) \
+    X(DD, 77, LD_8Bit(z, IXd, A)) \
+    X(DD, 78, LD_8Bit(z, A, B)) /* undocumented call */ \
+    X(DD, 79, LD_8Bit(z, A, C)) /* undocumented call */ \
+    X(DD, 7A, LD_8Bit(z, A, D)) /* undocumented call */ \
+    X(DD, 7B, LD_8Bit(z, A, E)) /* undocumented call */ \
+    X(DD, 7C, LD_8Bit(z, A, IXh)) /* undocumented */ \
+    X(DD, 7D, LD_8Bit(z, A, IXl)) /* undocumented */ \
+    X(DD, 7E, LD_8Bit(z, A, IXd)) \
+    X(DD, 7F, LD_8Bit(z, A, A)) /* undocumented call */ \
+    X(DD, 80, (void)z) \
+    X(DD, 81, (void)z) \
+    X(DD, 82, (void)z) \
+    X(DD, 83, (void)z) \
+    X(DD, 84, ADD(z, A, IXh)) /* undocumented */ \
+    X(DD, 85, ADD(z, A, IXl)) /* undocumented */ \
+    X(DD, 86, ADD(z, A, IXd)) \
+    X(DD, 87, (void)z) \
+    X(DD, 88, (void)z) \
+    X(DD, 89, (void)z) \
+    X(DD, 8A, (void)z) \
+    X(DD, 8B, (void)z) \
+    X(DD, 8C, ADC(z, IXh)) /* undocumented */ \
+    X(DD, 8D, ADC(z, IXl)) /* undocumented */ \
+    X(DD, 8E, ADC(z, IXd)) \
+    X(DD, 8F, (void)z) \
+    X(DD, 90, (void)z) \
+    X(DD, 91, (void)z) \
+    X(DD, 92, (void)z) \
+    X(DD, 93, (void)z) \
+    X(DD, 94, SUB(z, IXh)) /* undocumented */ \
+    X(DD, 95, SUB(z, IXl)) /* undocumented */ \
+    X(DD, 96, SUB(z, IXd)) \
+    X(DD, 97, (void)z) \
+    X(DD, 98, (void)z) \
+    X(DD, 99, (void)z) \
+    X(DD, 9A, (void)z) \
+    X(DD, 9B, (void)z) \
+    X(DD, 9C, SBC(z, IXh)) /* undocumented */ \
+    X(DD, 9D, SBC(z, IXl)) /* undocumented */ \
+    X(DD, 9E, SBC(z, IXd)) \
+    X(DD, 9F, (void)z) \
+    X(DD, A0, (void)z) \
+    X(DD, A1, (void)z) \
+    X(DD, A2, (void)z) \
+    X(DD, A3, (void)z) \
+    X(DD, A4, AND(z, IXh)) /* undocumented */ \
+    X(DD, A5, AND(z, IXl)) /* undocumented */ \
+    X(DD, A6, AND(z, IXd)) \
+    X(DD, A7, (void)z) \
+    X(DD, A8, (void)z) \
+    X(DD, A9, (void)z) \
+    X(DD, AA, (void)z) \
+    X(DD, AB, (void)z) \
+    X(DD, AC, XOR(z, IXh)) /* undocumented */ \
+    X(DD, AD, XOR(z, IXl)) /* undocumented */ \
+    X(DD, AE, XOR(z, IXd)) \
+    X(DD, AF, (void)z) \
+    X(DD, B0, (void)z) \
+    X(DD, B1, (void)z) \
+    X(DD, B2, (void)z) \
+    X(DD, B3, (void)z) \
+    X(DD, B4, OR(z, IXh)) /* undocumented */ \
+    X(DD, B5, OR(z, IXl)) /* undocumented */ \
+    X(DD, B6, OR(z, IXd)) \
+    X(DD, B7, (void)z) \
+    X(DD, B8, (void)z) \
+    X(DD, B9, (void)z) \
+    X(DD, BA, (void)z) \
+    X(DD, BB, (void)z) \
+    X(DD, BC, CP(z, IXh)) /* undocumented */ \
+    X(DD, BD, CP(z, IXl)) /* undocumented */ \
+    X(DD, BE, CP(z, IXd)) \
+    X(DD, BF, (void)z) \
+    X(DD, C0, (void)z) \
+    X(DD, C1, (void)z) \
+    X(DD, C2, (void)z) \
+    X(DD, C3, (void)z) \
+    X(DD, C4, (void)z) \
+    X(DD, C5, (void)z) \
+    X(DD, C6, (void)z) \
+    X(DD, C7, (void)z) \
+    X(DD, C8, (void)z) \
+    X(DD, C9, (void)z) \
+    X(DD, CA, (void)z) \
+    X(DD, CB, incrementProgramCounter(z); Z80_DISPATCH(DDCB)) \
+    X(DD, CC, (void)z) \
+    X(DD, CD, (void)z) \
+    X(DD, CE, (void)z) \
+    X(DD, CF, (void)z) \
+    X(DD, D0, (void)z) \
+    X(DD, D1, (void)z) \
+    X(DD, D2, (void)z) \
+    X(DD, D3, (void)z) \
+    X(DD, D4, (void)z) \
+    X(DD, D5, (void)z) \
+    X(DD, D6, (void)z) \
+    X(DD, D7, (void)z) \
+    X(DD, D8, (void)z) \
+    X(DD, D9, (void)z) \
+    X(DD, DA, (void)z) \
+    X(DD, DB, (void)z) \
+    X(DD, DC, (void)z) \
+    X(DD, DD, z->ddStub = true) \
+    X(DD, DE, (void)z) \
+    X(DD, DF, (void)z) \
+    X(DD, E0, (void)z) \
+    X(DD, E1, POP(z, IX)) \
+    X(DD, E2, (void)z) \
+    X(DD, E3, EX(z, aSP, IX)) \
+    X(DD, E4, (void)z) \
+    X(DD, E5, PUSH(z, IX)) \
+    X(DD, E6, (void)z) \
+    X(DD, E7, (void)z) \
+    X(DD, E8, (void)z) \
+    X(DD, E9, JP(z, IX)) \
+    X(DD, EA, (void)z) \
+    X(DD, EB, (void)z) \
+    X(DD, EC, (void)z) \
+    X(DD, ED, (void)z) \
+    X(DD, EE, (void)z) \
+    X(DD, EF, (void)z) \
+    X(DD, F0, (void)z) \
+    X(DD, F1, (void)z) \
+    X(DD, F2, (void)z) \
+    X(DD, F3, (void)z) \
+    X(DD, F4, (void)z) \
+    X(DD, F5, (void)z) \
+    X(DD, F6, (void)z) \
+    X(DD, F7, (void)z) \
+    X(DD, F8, (void)z) \
+    X(DD, F9, LD_16Bit(z, SP, IX, 0)) \
+    X(DD, FA, (void)z) \
+    X(DD, FB, (void)z) \
+    X(DD, FC, (void)z) \
+    X(DD, FD, z->fdStub = true) \
+    X(DD, FE, (void)z) \
+    X(DD, FF, (void)z)
+
+/* this is the table of ED prefixed opcodes */
+#define Z80_ED_OPCODES(X) \
+    X(ED, 00, (void)z) \
+    X(ED, 01, (void)z) \
+    X(ED, 02, (void)z) \
+    X(ED, 03, (void)z) \
+    X(ED, 04, (void)z) \
+    X(ED, 05, (void)z) \
+    X(ED, 06, (void)z) \
+    X(ED, 07, (void)z) \
+    X(ED, 08, (void)z) \
+    X(ED, 09, (void)z) \
+    X(ED, 0A, (void)z) \
+    X(ED, 0B, (void)z) \
+    X(ED, 0C, (void)z) \
+    X(ED, 0D, (void)z) \
+    X(ED, 0E, (void)z) \
+    X(ED, 0F, (void)z) \
+    X(ED, 10, (void)z) \
+    X(ED, 11, (void)z) \
+    X(ED, 12, (void)z) \
+    X(ED, 13, (void)z) \
+    X(ED, 14, (void)z) \
+    X(ED, 15, (void)z) \
+    X(ED, 16, (void)z) \
+    X(ED, 17, (void)z) \
+    X(ED, 18, (void)z) \
+    X(ED, 19, (void)z) \
+    X(ED, 1A, (void)z) \
+    X(ED, 1B, (void)z) \
+    X(ED, 1C, (void)z) \
+    X(ED, 1D, (void)z) \
+    X(ED, 1E, (void)z) \
+    X(ED, 1F, (void)z) \
+    X(ED, 20, (void)z) \
+    X(ED, 21, (void)z) \
+    X(ED, 22, (void)z) \
+    X(ED, 23, (void)z) \
+    X(ED, 24, (void)z) \
+    X(ED, 25, (void)z) \
+    X(ED, 26, (void)z) \
+    X(ED, 27, (void)z) \
+    X(ED, 28, (void)z) \
+    X(ED, 29, (void)z) \
+    X(ED, 2A, (void)z) \
+    X(ED, 2B, (void)z) \
+    X(ED, 2C, (void)z) \
+    X(ED, 2D, (void)z) \
+    X(ED, 2E, (void)z) \
+    X(ED, 2F, (void)z) \
+    X(ED, 30, (void)z) \
+    X(ED, 31, (void)z) \
+    X(ED, 32, (void)z) \
+    X(ED, 33, (void)z) \
+    X(ED, 34, (void)z) \
+    X(ED, 35, (void)z) \
+    X(ED, 36, (void)z) \
+    X(ED, 37, (void)z) \
+    X(ED, 38, (void)z) \
+    X(ED, 39, (void)z) \
+    X(ED, 3A, (void)z) \
+    X(ED, 3B, (void)z) \
+    X(ED, 3C, (void)z) \
+    X(ED, 3D, (void)z) \
+    X(ED, 3E, (void)z) \
+    X(ED, 3F, (void)z) \
+    X(ED, 40, IN(z, B, aC)) \
+    X(ED, 41, OUT(z, aC, B)) \
+    X(ED, 42, SBC(z, BC)) \
+    X(ED, 43, LD_16Bit(z, a_nn, BC, 0)) \
+    X(ED, 44, NEG(z)) \
+    X(ED, 45, RETN(z)) \
+    X(ED, 46, IM(z, 0)) \
+    X(ED, 47, LD_8Bit(z, I, A)) \
+    X(ED, 48, IN(z, C, aC)) \
+    X(ED, 49, OUT(z, aC, C)) \
+    X(ED, 4A, ADC(z, BC)) \
+    X(ED, 4B, LD_16Bit(z, BC, a_nn, 0)) \
+    X(ED, 4C, (void)z) \
+    X(ED, 4D, RETI(z)) \
+    X(ED, 4E, (void)z) \
+    X(ED, 4F, LD_8Bit(z, R, A)) \
+    X(ED, 50, IN(z, D, aC)) \
+    X(ED, 51, OUT(z, aC, D)) \
+    X(ED, 52, SBC(z, DE)) \
+    X(ED, 53, LD_16Bit(z, a_nn, DE, 0)) \
+    X(ED, 54, (void)z) \
+    X(ED, 55, (void)z) \
+    X(ED, 56, IM(z, 1)) \
+    X(ED, 57, LD_8Bit(z, A, I)) \
+    X(ED, 58, IN(z, E, aC)) \
+    X(ED, 59, OUT(z, aC, E)) \
+    X(ED, 5A, ADC(z, DE)) \
+    X(ED, 5B, LD_16Bit(z, DE, a_nn, 0)) \
+    X(ED, 5C, (void)z) \
+    X(ED, 5D, (void)z) \
+    X(ED, 5E, IM(z, 2)) \
+    X(ED, 5F, LD_8Bit(z, A, R)) \
+    X(ED, 60, IN(z, H, aC)) \
+    X(ED, 61, OUT(z, aC, H)) \
+    X(ED, 62, SBC(z, HL)) \
+    X(ED, 63, LD_16Bit(z, a_nn, HL, 1)) \
+    X(ED, 64, (void)z) \
+    X(ED, 65, (void)z) \
+    X(ED, 66, (void)z) \
+    X(ED, 67, RRD(z)) \
+    X(ED, 68, IN(z, L, aC)) \
+    X(ED, 69, OUT(z, aC, L)) \
+    X(ED, 6A, ADC(z, HL)) \
+    X(ED, 6B, LD_16Bit(z, HL, a_nn, 1)) \
+    X(ED, 6C, (void)z) \
+    X(ED, 6D, (void)z) \
+    X(ED, 6E, (void)z) \
+    X(ED, 6F, RLD(z)) \
+    X(ED, 70, (void)z) \
+    X(ED, 71, (void)z) \
+    X(ED, 72, SBC(z, SP)) \
+    X(ED, 73, LD_16Bit(z, a_nn, SP, 0)) \
+    X(ED, 74, (void)z) \
+    X(ED, 75, (void)z) \
+    X(ED, 76, (void)z) \
+    X(ED, 77, (void)z) \
+    X(ED, 78, IN(z, A, aC)) \
+    X(ED, 79, OUT(z, aC, A)) \
+    X(ED, 7A, ADC(z, SP)) \
+    X(ED, 7B, LD_16Bit(z, SP, a_nn, 0)) \
+    X(ED, 7C, (void)z) \
+    X(ED, 7D, (void)z) \
+    X(ED, 7E, (void)z) \
+    X(ED, 7F, (void)z) \
+    X(ED, 80, (void)z) \
+    X(ED, 81, (void)z) \
+    X(ED, 82, (void)z) \
+    X(ED, 83, (void)z) \
+    X(ED, 84, (void)z) \
+    X(ED, 85, (void)z) \
+    X(ED, 86, (void)z) \
+    X(ED, 87, (void)z) \
+    X(ED, 88, (void)z) \
+    X(ED, 89, (void)z) \
+    X(ED, 8A, (void)z) \
+    X(ED, 8B, (void)z) \
+    X(ED, 8C, (void)z) \
+    X(ED, 8D, (void)z) \
+    X(ED, 8E, (void)z) \
+    X(ED, 8F, (void)z) \
+    X(ED, 90, (void)z) \
+    X(ED, 91, (void)z) \
+    X(ED, 92, (void)z) \
+    X(ED, 93, (void)z) \
+    X(ED, 94, (void)z) \
+    X(ED, 95, (void)z) \
+    X(ED, 96, (void)z) \
+    X(ED, 97, (void)z) \
+    X(ED, 98, (void)z) \
+    X(ED, 99, (void)z) \
+    X(ED, 9A, (void)z) \
+    X(ED, 9B, (void)z) \
+    X(ED, 9C, (void)z) \
+    X(ED, 9D, (void)z) \
+    X(ED, 9E, (void)z) \
+    X(ED, 9F, (void)z) \
+    X(ED, A0, LDI(z)) \
+    X(ED, A1, CPI(z)) \
+    X(ED, A2, INI(z)) \
+    X(ED, A3, OUTI(z)) \
+    X(ED, A4, (void)z) \
+    X(ED, A5, (void)z) \
+    X(ED, A6, (void)z) \
+    X(ED, A7, (void)z) \
+    X(ED, A8, LDD(z)) \
+    X(ED, A9, CPD(z)) \
+    X(ED, AA, IND(z)) \
+    X(ED, AB, OUTD(z)) \
+    X(ED, AC, (void)z) \
+    X(ED, AD, (void)z) \
+    X(ED, AE, (void)z) \
+    X(ED, AF, (void)z) \
+    X(ED, B0, LDIR(z)) \
+    X(ED, B1, CPIR(z)) \
+    X(ED, B2, INIR(z)) \
+    X(ED, B3, OTIR(z)) \
+    X(ED, B4, (void)z) \
+    X(ED, B5, (void)z) \
+    X(ED, B6, (void)z) \
+    X(ED, B7, (void)z) \
+    X(ED, B8, LDDR(z)) \
+    X(ED, B9, CPDR(z)) \
+    X(ED, BA, INDR(z)) \
+    X(ED, BB, OTDR(z)) \
+    X(ED, BC, (void)z) \
+    X(ED, BD, (void)z) \
+    X(ED, BE, (void)z) \
+    X(ED, BF, (void)z) \
+    X(ED, C0, (void)z) \
+    X(ED, C1, (void)z) \
+    X(ED, C2, (void)z) \
+    X(ED, C3, (void)z) \
+    X(ED, C4, (void)z) \
+    X(ED, C5, (void)z) \
+    X(ED, C6, (void)z) \
+    X(ED, C7, (void)z) \
+    X(ED, C8, (void)z) \
+    X(ED, C9, (void)z) \
+    X(ED, CA, (void)z) \
+    X(ED, CB, (void)z) \
+    X(ED, CC, (void)z) \
+    X(ED, CD, (void)z) \
+    X(ED, CE, (void)z) \
+    X(ED, CF, (void)z) \
+    X(ED, D0, (void)z) \
+    X(ED, D1, (void)z) \
+    X(ED, D2, (void)z) \
+    X(ED, D3, (void)z) \
+    X(ED, D4, (void)z) \
+    X(ED, D5, (void)z) \
+    X(ED, D6, (void)z) \
+    X(ED, D7, (void)z) \
+    X(ED, D8, (void)z) \
+    X(ED, D9, (void)z) \
+    X(ED, DA, (void)z) \
+    X(ED, DB, (void)z) \
+    X(ED, DC, (void)z) \
+    X(ED, DD, (void)z) \
+    X(ED, DE, (void)z) \
+    X(ED, DF, (void)z) \
+    X(ED, E0, (void)z) \
+    X(ED, E1, (void)z) \
+    X(ED, E2, (void)z) \
+    X(ED, E3, (void)z) \
+    X(ED, E4, (void)z) \
+    X(ED, E5, (void)z) \
+    X(ED, E6, (void)z) \
+    X(ED, E7, (void)z) \
+    X(ED, E8, (void)z) \
+    X(ED, E9, (void)z) \
+    X(ED, EA, (void)z) \
+    X(ED, EB, (void)z) \
+    X(ED, EC, (void)z) \
+    X(ED, ED, (void)z) \
+    X(ED, EE, (void)z) \
+    X(ED, EF, (void)z) \
+    X(ED, F0, (void)z) \
+    X(ED, F1, (void)z) \
+    X(ED, F2, (void)z) \
+    X(ED, F3, (void)z) \
+    X(ED, F4, (void)z) \
+    X(ED, F5, (void)z) \
+    X(ED, F6, (void)z) \
+    X(ED, F7, (void)z) \
+    X(ED, F8, (void)z) \
+    X(ED, F9, (void)z) \
+    X(ED, FA, (void)z) \
+    X(ED, FB, (void)z) \
+    X(ED, FC, (void)z) \
+    X(ED, FD, (void)z) \
+    X(ED, FE, (void)z) \
+    X(ED, FF, (void)z)
+
+/* this is the table of FD prefixed opcodes */
+#define Z80_FD_OPCODES(X) \
+    X(FD, 00, (void)z) \
+    X(FD, 01, (void)z) \
+    X(FD, 02, (void)z) \
+    X(FD, 03, (void)z) \
+    X(FD, 04, (void)z) \
+    X(FD, 05, (void)z) \
+    X(FD, 06, (void)z) \
+    X(FD, 07, (void)z) \
+    X(FD, 08, (void)z) \
+    X(FD, 09, ADD(z, IY, BC)) \
+    X(FD, 0A, (void)z) \
+    X(FD, 0B, (void)z) \
+    X(FD, 0C, (void)z) \
+    X(FD, 0D, (void)z) \
+    X(FD, 0E, (void)z) \
+    X(FD, 0F, (void)z) \
+    X(FD, 10, (void)z) \
+    X(FD, 11, (void)z) \
+    X(FD, 12, (void)z) \
+    X(FD, 13, (void)z) \
+    X(FD, 14, (void)z) \
+    X(FD, 15, (void)z) \
+    X(FD, 16, (void)z) \
+    X(FD, 17, (void)z) \
+    X(FD, 18, (void)z) \
+    X(FD, 19, ADD(z, IY, DE)) \
+    X(FD, 1A, (void)z) \
+    X(FD, 1B, (void)z) \
+    X(FD, 1C, (void)z) \
+    X(FD, 1D, (void)z) \
+    X(FD, 1E, (void)z) \
+    X(FD, 1F, (void)z) \
+    X(FD, 20, (void)z) \
+    X(FD, 21, LD_16Bit(z, IY, nn, 0)) \
+    X(FD, 22, LD_16Bit(z, a_nn, IY, 0)) \
+    X(FD, 23, INC(z, IY)) \
+    X(FD, 24, INC(z, IYh)) /* undocumented */ \
+    X(FD, 25, DEC(z, IYh)) /* undocumented */ \
+    X(FD, 26, LD_8Bit(z, IYh, n)) /* undocumented */ \
+    X(FD, 27, (void)z) \
+    X(FD, 28, (void)z) \
+    X(FD, 29, ADD(z, IY, IY)) \
+    X(FD, 2A, LD_16Bit(z, IY, a_nn, 0)) \
+    X(FD, 2B, DEC(z, IY)) \
+    X(FD, 2C, INC(z, IYl)) /* undocumented */ \
+    X(FD, 2D, DEC(z, IYl)) /* undocumented */ \
+    X(FD, 2E, LD_8Bit(z, IYl, n)) /* undocumented */ \
+    X(FD, 2F, (void)z) \
+    X(FD, 30, (void)z) \
+    X(FD, 31, (void)z) \
+    X(FD, 32, (void)z) \
+    X(FD, 33, (void)z) \
+    X(FD, 34, INC(z, IYd)) \
+    X(FD, 35, DEC(z, IYd)) \
+    X(FD, 36, LD_8Bit(z, IYd, n)) \
+    X(FD, 37, (void)z) \
+    X(FD, 38, (void)z) \
+    X(FD, 39, ADD(z, IY, SP)) \
+    X(FD, 3A, (void)z) \
+    X(FD, 3B, (void)z) \
+    X(FD, 3C, (void)z) \
+    X(FD, 3D, (void)z) \
+    X(FD, 3E, (void)z) \
+    X(FD, 3F, (void)z) \
+    X(FD, 40, LD_8Bit(z, B, B)) /* undocumented call */ \
+    X(FD, 41, LD_8Bit(z, B, C)) /* undocumented call */ \
+    X(FD, 42, LD_8Bit(z, B, D)) /* undocumented call */ \
+    X(FD, 43, LD_8Bit(z, B, E)) /* undocumented call */ \
+    X(FD, 44, LD_8Bit(z, B, IYh)) /* undocumented */ \
+    X(FD, 45, LD_8Bit(z, B, IYl)) /* undocumented */ \
+    X(FD, 46, LD_8Bit(z, B, IYd)) \
+    X(FD, 47, LD_8Bit(z, B, A)) /* undocumented call */ \
+    X(FD, 48, LD_8Bit(z, C, B)) /* undocumented call */ \
+    X(FD, 49, LD_8Bit(z, C, C)) /* undocumented call */ \
+    X(FD, 4A, LD_8Bit(z, C, D)) /* undocumented call */ \
+    X(FD, 4B, LD_8Bit(z, C, E)) /* undocumented call */ \
+    X(FD, 4C, LD_8Bit(z, C, IYh)) /* undocumented */ \
+    X(FD, 4D, LD_8Bit(z, C, IYl)) /* undocumented */ \
+    X(FD, 4E, LD_8Bit(z, C, IYd)) \
+    X(FD, 4F, LD_8Bit(z, C, A)) /* undocumented call */ \
+    X(FD, 50, LD_8Bit(z, D, B)) /* undocumented call */ \
+    X(FD, 51, LD_8Bit(z, D, C)) /* undocumented call */ \
+    X(FD, 52, LD_8Bit(z, D, D)) /* undocumented call */ \
+    X(FD, 53, LD_8Bit(z, D, E)) /* undocumented call */ \
+    X(FD, 54, LD_8Bit(z, D, IYh)) /* undocumented */ \
+    X(FD, 55, LD_8Bit(z, D, IYl)) /* undocumented */ \
+    X(FD, 56, LD_8Bit(z, D, IYd)) \
+    X(FD, 57, LD_8Bit(z, D, A)) /* undocumented call */ \
+    X(FD, 58, LD_8Bit(z, E, B)) /* undocumented call */ \
+    X(FD, 59, LD_8Bit(z, E, C)) /* undocumented call */ \
+    X(FD, 5A, LD_8Bit(z, E, D)) /* undocumented call */ \
+    X(FD, 5B, LD_8Bit(z, E, E)) /* undocumented call */ \
+    X(FD, 5C, LD_8Bit(z, E, IYh)) /* undocumented */ \
+    X(FD, 5D, LD_8Bit(z, E, IYl)) /* undocumented */ \
+    X(FD, 5E, LD_8Bit(z, E, IYd)) \
+    X(FD, 5F, LD_8Bit(z, E, A)) /* undocumented call */ \
+    X(FD, 60, LD_8Bit(z, IYh, B)) /* undocumented */ \
+    X(FD, 61, LD_8Bit(z, IYh, C)) /* undocumented */ \
+    X(FD, 62, LD_8Bit(z, IYh, D)) /* undocumented */ \
+    X(FD, 63, LD_8Bit(z, IYh, E)) /* undocumented */ \
+    X(FD, 64, LD_8Bit(z, IYh, IYh)) /* undocumented */ \
+    X(FD, 65, LD_8Bit(z, IYh, IYl)) /* undocumented */ \
+    X(FD, 66, LD_8Bit(z, H, IYd)) \
+    X(FD, 67, LD_8Bit(z, IYh, A)) /* undocumented */ \
+    X(FD, 68, LD_8Bit(z, IYl, B)) /* undocumented */ \
+    X(FD, 69, LD_8Bit(z, IYl, C)) /* undocumented */ \
+    X(FD, 6A, LD_8Bit(z, IYl, D)) /* undocumented */ \
+    X(FD, 6B, LD_8Bit(z, IYl, E)) /* undocumented */ \
+    X(FD, 6C, LD_8Bit(z, IYl, IYh)) /* undocumented */ \
+    X(FD, 6D, LD_8Bit(z, IYl, IYl)) /* undocumented */ \
+    X(FD, 6E, LD_8Bit(z, L, IYd)) \
+    X(FD, 6F, LD_8Bit(z, IYl, A)) /* undocumented */ \
+    X(FD, 70, LD_8Bit(z, IYd, B)) \
+    X(FD, 71, LD_8Bit(z, IYd, C)) \
+    X(FD, 72, LD_8Bit(z, IYd, D)) \
+    X(FD, 73, LD_8Bit(z, IYd, E)) \
+    X(FD, 74, LD_8Bit(z, IYd, H)) \
+    X(FD, 75, LD_8Bit(z, IYd, L)) \
+    X(FD, 76, (void)z) \
+    X(FD, 77, LD_8Bit(z, IYd, A)) \
+    X(FD, 78, LD_8Bit(z, A, B)) /* undocumented call */ \
+    X(FD, 79, LD_8Bit(z, A, C)) /* undocumented call */ \
+    X(FD, 7A, LD_8Bit(z, A, D)) /* undocumented call */ \
+    X(FD, 7B, LD_8Bit(z, A, E)) /* undocumented call */ \
+    X(FD, 7C, LD_8Bit(z, A, IYh)) /* undocumented */ \
+    X(FD, 7D, LD_8Bit(z, A, IYl)) /* undocumented */ \
+    X(FD, 7E, LD_8Bit(z, A, IYd)) \
+    X(FD, 7F, LD_8Bit(z, A, A)) /* undocumented call */ \
+    X(FD, 80, (void)z) \
+    X(FD, 81, (void)z) \
+    X(FD, 82, (void)z) \
+    X(FD, 83, (void)z) \
+    X(FD, 84, ADD(z, A, IYh)) /* undocumented */ \
+    X(FD, 85, ADD(z, A, IYl)) /* undocumented */ \
+    X(FD, 86, ADD(z, A, IYd)) \
+    X(FD, 87, (void)z) \
+    X(FD, 88, (void)z) \
+    X(FD, 89, (void)z) \
+    X(FD, 8A, (void)z) \
+    X(FD, 8B, (void)z) \
+    X(FD, 8C, ADC(z, IYh)) /* undocumented */ \
+    X(FD, 8D, ADC(z, IYl)) /* undocumented */ \
+    X(FD, 8E, ADC(z, IYd)) \
+    X(FD, 8F, (void)z) \
+    X(FD, 90, (void)z) \
+    X(FD, 91, (void)z) \
+    X(FD, 92, (void)z) \
+    X(FD, 93, (void)z) \
+    X(FD, 94, SUB(z, IYh)) /* undocumented */ \
+    X(FD, 95, SUB(z, IYl)) /* undocumented */ \
+    X(FD, 96, SUB(z, IYd)) \
+    X(FD, 97, (void)z) \
+    X(FD, 98, (void)z) \
+    X(FD, 99, (void)z) \
+    X(FD, 9A, (void)z) \
+    X(FD, 9B, (void)z) \
+    X(FD, 9C, SBC(z, IYh)) /* undocumented */ \
+    X(FD, 9D, SBC(z, IYl)) /* undocumented */ \
+    X(FD, 9E, SBC(z, IYd)) \
+    X(FD, 9F, (void)z) \
+    X(FD, A0, (void)z) \
+    X(FD, A1, (void)z) \
+    X(FD, A2, (void)z) \
+    X(FD, A3, (void)z) \
+    X(FD, A4, AND(z, IYh)) /* undocumented */ \
+    X(FD, A5, AND(z, IYl)) /* undocumented */ \
+    X(FD, A6, AND(z, IYd)) \
+    X(FD, A7, (void)z) \
+    X(FD, A8, (void)z) \
+    X(FD, A9, (void)z) \
+    X(FD, AA, (void)z) \
+    X(FD, AB, (void)z) \
+    X(FD, AC, XOR(z, IYh)) /* undocumented */ \
+    X(FD, AD, XOR(z, IYl)) /* undocumented */ \
+    X(FD, AE, XOR(z, IYd)) \
+    X(FD, AF, (void)z) \
+    X(FD, B0, (void)z) \
+    X(FD, B1, (void)z) \
+    X(FD, B2, (void)z) \
+    X(FD, B3, (void)z) \
+    X(FD, B4, OR(z, IYh)) /* undocumented */ \
+    X(FD, B5, OR(z, IYl)) /* undocumented */ \
+    X(FD, B6, OR(z, IYd)) \
+    X(FD, B7, (void)z) \
+    X(FD, B8, (void)z) \
+    X(FD, B9, (void)z) \
+    X(FD, BA, (void)z) \
+    X(FD, BB, (void)z) \
+    X(FD, BC, CP(z, IYh)) /* undocumented */ \
+    X(FD, BD, CP(z, IYl)) /* undocumented */ \
+    X(FD, BE, CP(z, IYd)) \
+    X(FD, BF, (void)z) \
+    X(FD, C0, (void)z) \
+    X(FD, C1, (void)z) \
+    X(FD, C2, (void)z) \
+    X(FD, C3, (void)z) \
+    X(FD, C4, (void)z) \
+    X(FD, C5, (void)z) \
+    X(FD, C6, (void)z) \
+    X(FD, C7, (void)z) \
+    X(FD, C8, (void)z) \
+    X(FD, C9, (void)z) \
+    X(FD, CA, (void)z) \
+    X(FD, CB, incrementProgramCounter(z); Z80_DISPATCH(FDCB)) \
+    X(FD, CC, (void)z) \
+    X(FD, CD, (void)z) \
+    X(FD, CE, (void)z) \
+    X(FD, CF, (void)z) \
+    X(FD, D0, (void)z) \
+    X(FD, D1, (void)z) \
+    X(FD, D2, (void)z) \
+    X(FD, D3, (void)z) \
+    X(FD, D4, (void)z) \
+    X(FD, D5, (void)z) \
+    X(FD, D6, (void)z) \
+    X(FD, D7, (void)z) \
+    X(FD, D8, (void)z) \
+    X(FD, D9, (void)z) \
+    X(FD, DA, (void)z) \
+    X(FD, DB, (void)z) \
+    X(FD, DC, (void)z) \
+    X(FD, DD, z->ddStub = true) \
+    X(FD, DE, (void)z) \
+    X(FD, DF, (void)z) \
+    X(FD, E0, (void)z) \
+    X(FD, E1, POP(z, IY)) \
+    X(FD, E2, (void)z) \
+    X(FD, E3, EX(z, aSP, IY)) \
+    X(FD, E4, (void)z) \
+    X(FD, E5, PUSH(z, IY)) \
+    X(FD, E6, (void)z) \
+    X(FD, E7, (void)z) \
+    X(FD, E8, (void)z) \
+    X(FD, E9, JP(z, IY)) \
+    X(FD, EA, (void)z) \
+    X(FD, EB, (void)z) \
+    X(FD, EC, (void)z) \
+    X(FD, ED, (void)z) \
+    X(FD, EE, (void)z) \
+    X(FD, EF, (void)z) \
+    X(FD, F0, (void)z) \
+    X(FD, F1, (void)z) \
+    X(FD, F2, (void)z) \
+    X(FD, F3, (void)z) \
+    X(FD, F4, (void)z) \
+    X(FD, F5, (void)z) \
+    X(FD, F6, (void)z) \
+    X(FD, F7, (void)z) \
+    X(FD, F8, (void)z) \
+    X(FD, F9, LD_16Bit(z, SP, IY, 0)) \
+    X(FD, FA, (void)z) \
+    X(FD, FB, (void)z) \
+    X(FD, FC, (void)z) \
+    X(FD, FD, z->fdStub = true) \
+    X(FD, FE, (void)z) \
+    X(FD, FF, (void)z)
+
+/* this is the table of DDCB prefixed opcodes */
+#define Z80_DDCB_OPCODES(X) \
+    X(DDCB, 00, (void)z) \
+    X(DDCB, 01, (void)z) \
+    X(DDCB, 02, (void)z) \
+    X(DDCB, 03, (void)z) \
+    X(DDCB, 04, (void)z) \
+    X(DDCB, 05, (void)z) \
+    X(DDCB, 06, RLC(z, IXd)) \
+    X(DDCB, 07, (void)z) \
+    X(DDCB, 08, (void)z) \
+    X(DDCB, 09, (void)z) \
+    X(DDCB, 0A, (void)z) \
+    X(DDCB, 0B, (void)z) \
+    X(DDCB, 0C, (void)z) \
+    X(DDCB, 0D, (void)z) \
+    X(DDCB, 0E, RRC(z, IXd)) \
+    X(DDCB, 0F, (void)z) \
+    X(DDCB, 10, (void)z) \
+    X(DDCB, 11, (void)z) \
+    X(DDCB, 12, (void)z) \
+    X(DDCB, 13, (void)z) \
+    X(DDCB, 14, (void)z) \
+    X(DDCB, 15, (void)z) \
+    X(DDCB, 16, RL(z, IXd)) \
+    X(DDCB, 17, (void)z) \
+    X(DDCB, 18, (void)z) \
+    X(DDCB, 19, (void)z) \
+    X(DDCB, 1A, (void)z) \
+    X(DDCB, 1B, (void)z) \
+    X(DDCB, 1C, (void)z) \
+    X(DDCB, 1D, (void)z) \
+    X(DDCB, 1E, RR(z, IXd)) \
+    X(DDCB, 1F, (void)z) \
+    X(DDCB, 20, (void)z) \
+    X(DDCB, 21, (void)z) \
+    X(DDCB, 22, (void)z) \
+    X(DDCB, 23, (void)z) \
+    X(DDCB, 24, (void)z) \
+    X(DDCB, 25, (void)z) \
+    X(DDCB, 26, SLA(z, IXd)) \
+    X(DDCB, 27, (void)z) \
+    X(DDCB, 28, (void)z) \
+    X(DDCB, 29, (void)z) \
+    X(DDCB, 2A, (void)z) \
+    X(DDCB, 2B, (void)z) \
+    X(DDCB, 2C, (void)z) \
+    X(DDCB, 2D, (void)z) \
+    X(DDCB, 2E, SRA(z, IXd)) \
+    X(DDCB, 2F, (void)z) \
+    X(DDCB, 30, (void)z) \
+    X(DDCB, 31, (void)z) \
+    X(DDCB, 32, (void)z) \
+    X(DDCB, 33, (void)z) \
+    X(DDCB, 34, (void)z) \
+    X(DDCB, 35, (void)z) \
+    X(DDCB, 36, SLL(z, IXd)) /* undocumented */ \
+    X(DDCB, 37, (void)z) \
+    X(DDCB, 38, (void)z) \
+    X(DDCB, 39, (void)z) \
+    X(DDCB, 3A, (void)z) \
+    X(DDCB, 3B, (void)z) \
+    X(DDCB, 3C, (void)z) \
+    X(DDCB, 3D, (void)z) \
+    X(DDCB, 3E, SRL(z, IXd)) \
+    X(DDCB, 3F, (void)z) \
+    X(DDCB, 40, (void)z) \
+    X(DDCB, 41, (void)z) \
+    X(DDCB, 42, (void)z) \
+    X(DDCB, 43, (void)z) \
+    X(DDCB, 44, (void)z) \
+    X(DDCB, 45, (void)z) \
+    X(DDCB, 46, BIT(z, 0, IXd)) \
+    X(DDCB, 47, (void)z) \
+    X(DDCB, 48, (void)z) \
+    X(DDCB, 49, (void)z) \
+    X(DDCB, 4A, (void)z) \
+    X(DDCB, 4B, (void)z) \
+    X(DDCB, 4C, (void)z) \
+    X(DDCB, 4D, (void)z) \
+    X(DDCB, 4E, BIT(z, 1, IXd)) \
+    X(DDCB, 4F, (void)z) \
+    X(DDCB, 50, (void)z) \
+    X(DDCB, 51, (void)z) \
+    X(DDCB, 52, (void)z) \
+    X(DDCB, 53, (void)z) \
+    X(DDCB, 54, (void)z) \
+    X(DDCB, 55, (void)z) \
+    X(DDCB, 56, BIT(z, 2, IXd)) \
+    X(DDCB, 57, (void)z) \
+    X(DDCB, 58, (void)z) \
+    X(DDCB, 59, (void)z) \
+    X(DDCB, 5A, (void)z) \
+    X(DDCB, 5B, (void)z) \
+    X(DDCB, 5C, (void)z) \
+    X(DDCB, 5D, (void)z) \
+    X(DDCB, 5E, BIT(z, 3, IXd)) \
+    X(DDCB, 5F, (void)z) \
+    X(DDCB, 60, (void)z) \
+    X(DDCB, 61, (void)z) \
+    X(DDCB, 62, (void)z) \
+    X(DDCB, 63, (void)z) \
+    X(DDCB, 64, (void)z) \
+    X(DDCB, 65, (void)z) \
+    X(DDCB, 66, BIT(z, 4, IXd)) \
+    X(DDCB, 67, (void)z) \
+    X(DDCB, 68, (void)z) \
+    X(DDCB, 69, (void)z) \
+    X(DDCB, 6A, (void)z) \
+    X(DDCB, 6B, (void)z) \
+    X(DDCB, 6C, (void)z) \
+    X(DDCB, 6D, (void)z) \
+    X(DDCB, 6E, BIT(z, 5, IXd)) \
+    X(DDCB, 6F, (void)z) \
+    X(DDCB, 70, (void)z) \
+    X(DDCB, 71, (void)z) \
+    X(DDCB, 72, (void)z) \
+    X(DDCB, 73, (void)z) \
+    X(DDCB, 74, (void)z) \
+    X(DDCB, 75, (void)z) \
+    X(DDCB, 76, BIT(z, 6, IXd)) \
+    X(DDCB, 77, (void)z) \
+    X(DDCB, 78, (void)z) \
+    X(DDCB, 79, (void)z) \
+    X(DDCB, 7A, (void)z) \
+    X(DDCB, 7B, (void)z) \
+    X(DDCB, 7C, (void)z) \
+    X(DDCB, 7D, (void)z) \
+    X(DDCB, 7E, BIT(z, 7, IXd)) \
+    X(DDCB, 7F, (void)z) \
+    X(DDCB, 80, (void)z) \
+    X(DDCB, 81, (void)z) \
+    X(DDCB, 82, (void)z) \
+    X(DDCB, 83, (void)z) \
+    X(DDCB, 84, (void)z) \
+    X(DDCB, 85, (void)z) \
+    X(DDCB, 86, RES(z, 0, IXd)) \
+    X(DDCB, 87, (void)z) \
+    X(DDCB, 88, (void)z) \
+    X(DDCB, 89, (void)z) \
+    X(DDCB, 8A, (void)z) \
+    X(DDCB, 8B, (void)z) \
+    X(DDCB, 8C, (void)z) \
+    X(DDCB, 8D, (void)z) \
+    X(DDCB, 8E, RES(z, 1, IXd)) \
+    X(DDCB, 8F, (void)z) \
+    X(DDCB, 90, (void)z) \
+    X(DDCB, 91, (void)z) \
+    X(DDCB, 92, (void)z) \
+    X(DDCB, 93, (void)z) \
+    X(DDCB, 94, (void)z) \
+    X(DDCB, 95, (void)z) \
+    X(DDCB, 96, RES(z, 2, IXd)) \
+    X(DDCB, 97, (void)z) \
+    X(DDCB, 98, (void)z) \
+    X(DDCB, 99, (void)z) \
+    X(DDCB, 9A, (void)z) \
+    X(DDCB, 9B, (void)z) \
+    X(DDCB, 9C, (void)z) \
+    X(DDCB, 9D, (void)z) \
+    X(DDCB, 9E, RES(z, 3, IXd)) \
+    X(DDCB, 9F, (void)z) \
+    X(DDCB, A0, (void)z) \
+    X(DDCB, A1, (void)z) \
+    X(DDCB, A2, (void)z) \
+    X(DDCB, A3, (void)z) \
+    X(DDCB, A4, (void)z) \
+    X(DDCB, A5, (void)z) \
+    X(DDCB, A6, RES(z, 4, IXd)) \
+    X(DDCB, A7, (void)z) \
+    X(DDCB, A8, (void)z) \
+    X(DDCB, A9, (void)z) \
+    X(DDCB, AA, (void)z) \
+    X(DDCB, AB, (void)z) \
+    X(DDCB, AC, (void)z) \
+    X(DDCB, AD, (void)z) \
+    X(DDCB, AE, RES(z, 5, IXd)) \
+    X(DDCB, AF, (void)z) \
+    X(DDCB, B0, (void)z) \
+    X(DDCB, B1, (void)z) \
+    X(DDCB, B2, (void)z) \
+    X(DDCB, B3, (void)z) \
+    X(DDCB, B4, (void)z) \
+    X(DDCB, B5, (void)z) \
+    X(DDCB, B6, RES(z, 6, IXd)) \
+    X(DDCB, B7, (void)z) \
+    X(DDCB, B8, (void)z) \
+    X(DDCB, B9, (void)z) \
+    X(DDCB, BA, (void)z) \
+    X(DDCB, BB, (void)z) \
+    X(DDCB, BC, (void)z) \
+    X(DDCB, BD, (void)z) \
+    X(DDCB, BE, RES(z, 7, IXd)) \
+    X(DDCB, BF, (void)z) \
+    X(DDCB, C0, (void)z) \
+    X(DDCB, C1, (void)z) \
+    X(DDCB, C2, (void)z) \
+    X(DDCB, C3, (void)z) \
+    X(DDCB, C4, (void)z) \
+    X(DDCB, C5, (void)z) \
+    X(DDCB, C6, SET(z, 0, IXd)) \
+    X(DDCB, C7, (void)z) \
+    X(DDCB, C8, (void)z) \
+    X(DDCB, C9, (void)z) \
+    X(DDCB, CA, (void)z) \
+    X(DDCB, CB, (void)z) \
+    X(DDCB, CC, (void)z) \
+    X(DDCB, CD, (void)z) \
+    X(DDCB, CE, SET(z, 1, IXd)) \
+    X(DDCB, CF, (void)z) \
+    X(DDCB, D0, (void)z) \
+    X(DDCB, D1, (void)z) \
+    X(DDCB, D2, (void)z) \
+    X(DDCB, D3, (void)z) \
+    X(DDCB, D4, (void)z) \
+    X(DDCB, D5, (void)z) \
+    X(DDCB, D6, SET(z, 2, IXd)) \
+    X(DDCB, D7, (void)z) \
+    X(DDCB, D8, (void)z) \
+    X(DDCB, D9, (void)z) \
+    X(DDCB, DA, (void)z) \
+    X(DDCB, DB, (void)z) \
+    X(DDCB, DC, (void)z) \
+    X(DDCB, DD, (void)z) \
+    X(DDCB, DE, SET(z, 3, IXd)) \
+    X(DDCB, DF, (void)z) \
+    X(DDCB, E0, (void)z) \
+    X(DDCB, E1, (void)z) \
+    X(DDCB, E2, (void)z) \
+    X(DDCB, E3, (void)z) \
+    X(DDCB, E4, (void)z) \
+    X(DDCB, E5, (void)z) \
+    X(DDCB, E6, SET(z, 4, IXd)) \
+    X(DDCB, E7, (void)z) \
+    X(DDCB, E8, (void)z) \
+    X(DDCB, E9, (void)z) \
+    X(DDCB, EA, (void)z) \
+    X(DDCB, EB, (void)z) \
+    X(DDCB, EC, (void)z) \
+    X(DDCB, ED, (void)z) \
+    X(DDCB, EE, SET(z, 5, IXd)) \
+    X(DDCB, EF, (void)z) \
+    X(DDCB, F0, (void)z) \
+    X(DDCB, F1, (void)z) \
+    X(DDCB, F2, (void)z) \
+    X(DDCB, F3, (void)z) \
+    X(DDCB, F4, (void)z) \
+    X(DDCB, F5, (void)z) \
+    X(DDCB, F6, SET(z, 6, IXd)) \
+    X(DDCB, F7, (void)z) \
+    X(DDCB, F8, (void)z) \
+    X(DDCB, F9, (void)z) \
+    X(DDCB, FA, (void)z) \
+    X(DDCB, FB, (void)z) \
+    X(DDCB, FC, (void)z) \
+    X(DDCB, FD, (void)z) \
+    X(DDCB, FE, SET(z, 7, IXd)) \
+    X(DDCB, FF, (void)z)
+
+/* this is the table of FDCB prefixed opcodes */
+#define Z80_FDCB_OPCODES(X) \
+    X(FDCB, 00, (void)z) \
+    X(FDCB, 01, (void)z) \
+    X(FDCB, 02, (void)z) \
+    X(FDCB, 03, (void)z) \
+    X(FDCB, 04, (void)z) \
+    X(FDCB, 05, (void)z) \
+    X(FDCB, 06, RLC(z, IYd)) \
+    X(FDCB, 07, (void)z) \
+    X(FDCB, 08, (void)z) \
+    X(FDCB, 09, (void)z) \
+    X(FDCB, 0A, (void)z) \
+    X(FDCB, 0B, (void)z) \
+    X(FDCB, 0C, (void)z) \
+    X(FDCB, 0D, (void)z) \
+    X(FDCB, 0E, RRC(z, IYd)) \
+    X(FDCB, 0F, (void)z) \
+    X(FDCB, 10, (void)z) \
+    X(FDCB, 11, (void)z) \
+    X(FDCB, 12, (void)z) \
+    X(FDCB, 13, (void)z) \
+    X(FDCB, 14, (void)z) \
+    X(FDCB, 15, (void)z) \
+    X(FDCB, 16, RL(z, IYd)) \
+    X(FDCB, 17, (void)z) \
+    X(FDCB, 18, (void)z) \
+    X(FDCB, 19, (void)z) \
+    X(FDCB, 1A, (void)z) \
+    X(FDCB, 1B, (void)z) \
+    X(FDCB, 1C, (void)z) \
+    X(FDCB, 1D, (void)z) \
+    X(FDCB, 1E, RR(z, IYd)) \
+    X(FDCB, 1F, (void)z) \
+    X(FDCB, 20, (void)z) \
+    X(FDCB, 21, (void)z) \
+    X(FDCB, 22, (void)z) \
+    X(FDCB, 23, (void)z) \
+    X(FDCB, 24, (void)z) \
+    X(FDCB, 25, (void)z) \
+    X(FDCB, 26, SLA(z, IYd)) \
+    X(FDCB, 27, (void)z) \
+    X(FDCB, 28, (void)z) \
+    X(FDCB, 29, (void)z) \
+    X(FDCB, 2A, (void)z) \
+    X(FDCB, 2B, (void)z) \
+    X(FDCB, 2C, (void)z) \
+    X(FDCB, 2D, (void)z) \
+    X(FDCB, 2E, SRA(z, IYd)) \
+    X(FDCB, 2F, (void)z) \
+    X(FDCB, 30, (void)z) \
+    X(FDCB, 31, (void)z) \
+    X(FDCB, 32, (void)z) \
+    X(FDCB, 33, (void)z) \
+    X(FDCB, 34, (void)z) \
+    X(FDCB, 35, (void)z) \
+    X(FDCB, 36, SLL(z, IXd)) /* undocumented */ \
+    X(FDCB, 37, (void)z) \
+    X(FDCB, 38, (void)z) \
+    X(FDCB, 39, (void)z) \
+    X(FDCB, 3A, (void)z) \
+    X(FDCB, 3B, (void)z) \
+    X(FDCB, 3C, (void)z) \
+    X(FDCB, 3D, (void)z) \
+    X(FDCB, 3E, SRL(z, IYd)) \
+    X(FDCB, 3F, (void)z) \
+    X(FDCB, 40, (void)z) \
+    X(FDCB, 41, (void)z) \
+    X(FDCB, 42, (void)z) \
+    X(FDCB, 43, (void)z) \
+    X(FDCB, 44, (void)z) \
+    X(FDCB, 45, (void)z) \
+    X(FDCB, 46, BIT(z, 0, IYd)) \
+    X(FDCB, 47, (void)z) \
+    X(FDCB, 48, (void)z) \
+    X(FDCB, 49, (void)z) \
+    X(FDCB, 4A, (void)z) \
+    X(FDCB, 4B, (void)z) \
+    X(FDCB, 4C, (void)z) \
+    X(FDCB, 4D, (void)z) \
+    X(FDCB, 4E, BIT(z, 1, IYd)) \
+    X(FDCB, 4F, (void)z) \
+    X(FDCB, 50, (void)z) \
+    X(FDCB, 51, (void)z) \
+    X(FDCB, 52, (void)z) \
+    X(FDCB, 53, (void)z) \
+    X(FDCB, 54, (void)z) \
+    X(FDCB, 55, (void)z) \
+    X(FDCB, 56, BIT(z, 2, IYd)) \
+    X(FDCB, 57, (void)z) \
+    X(FDCB, 58, (void)z) \
+    X(FDCB, 59, (void)z) \
+    X(FDCB, 5A, (void)z) \
+    X(FDCB, 5B, (void)z) \
+    X(FDCB, 5C, (void)z) \
+    X(FDCB, 5D, (void)z) \
+    X(FDCB, 5E, BIT(z, 3, IYd)) \
+    X(FDCB, 5F, (void)z) \
+    X(FDCB, 60, (void)z) \
+    X(FDCB, 61, (void)z) \
+    X(FDCB, 62, (void)z) \
+    X(FDCB, 63, (void)z) \
+    X(FDCB, 64, (void)z) \
+    X(FDCB, 65, (void)z) \
+    X(FDCB, 66, BIT(z, 4, IYd)) \
+    X(FDCB, 67, (void)z) \
+    X(FDCB, 68, (void)z) \
+    X(FDCB, 69, (void)z) \
+    X(FDCB, 6A, (void)z) \
+    X(FDCB, 6B, (void)z) \
+    X(FDCB, 6C, (void)z) \
+    X(FDCB, 6D, (void)z) \
+    X(FDCB, 6E, BIT(z, 5, IYd)) \
+    X(FDCB, 6F, (void)z) \
+    X(FDCB, 70, (void)z) \
+    X(FDCB, 71, (void)z) \
+    X(FDCB, 72, (void)z) \
+    X(FDCB, 73, (void)z) \
+    X(FDCB, 74, (void)z) \
+    X(FDCB, 75, (void)z) \
+    X(FDCB, 76, BIT(z, 6, IYd)) \
+    X(FDCB, 77, (void)z) \
+    X(FDCB, 78, (void)z) \
+    X(FDCB, 79, (void)z) \
+    X(FDCB, 7A, (void)z) \
+    X(FDCB, 7B, (void)z) \
+    X(FDCB, 7C, (void)z) \
+    X(FDCB, 7D, (void)z) \
+    X(FDCB, 7E, BIT(z, 7, IYd)) \
+    X(FDCB, 7F, (void)z) \
+    X(FDCB, 80, (void)z) \
+    X(FDCB, 81, (void)z) \
+    X(FDCB, 82, (void)z) \
+    X(FDCB, 83, (void)z) \
+    X(FDCB, 84, (void)z) \
+    X(FDCB, 85, (void)z) \
+    X(FDCB, 86, RES(z, 0, IYd)) \
+    X(FDCB, 87, (void)z) \
+    X(FDCB, 88, (void)z) \
+    X(FDCB, 89, (void)z) \
+    X(FDCB, 8A, (void)z) \
+    X(FDCB, 8B, (void)z) \
+    X(FDCB, 8C, (void)z) \
+    X(FDCB, 8D, (void)z) \
+    X(FDCB, 8E, RES(z, 1, IYd)) \
+    X(FDCB, 8F, (void)z) \
+    X(FDCB, 90, (void)z) \
+    X(FDCB, 91, (void)z) \
+    X(FDCB, 92, (void)z) \
+    X(FDCB, 93, (void)z) \
+    X(FDCB, 94, (void)z) \
+    X(FDCB, 95, (void)z) \
+    X(FDCB, 96, RES(z, 2, IYd)) \
+    X(FDCB, 97, (void)z) \
+    X(FDCB, 98, (void)z) \
+    X(FDCB, 99, (void)z) \
+    X(FDCB, 9A, (void)z) \
+    X(FDCB, 9B, (void)z) \
+    X(FDCB, 9C, (void)z) \
+    X(FDCB, 9D, (void)z) \
+    X(FDCB, 9E, RES(z, 3, IYd)) \
+    X(FDCB, 9F, (void)z) \
+    X(FDCB, A0, (void)z) \
+    X(FDCB, A1, (void)z) \
+    X(FDCB, A2, (void)z) \
+    X(FDCB, A3, (void)z) \
+    X(FDCB, A4, (void)z) \
+    X(FDCB, A5, (void)z) \
+    X(FDCB, A6, RES(z, 4, IYd)) \
+    X(FDCB, A7, (void)z) \
+    X(FDCB, A8, (void)z) \
+    X(FDCB, A9, (void)z) \
+    X(FDCB, AA, (void)z) \
+    X(FDCB, AB, (void)z) \
+    X(FDCB, AC, (void)z) \
+    X(FDCB, AD, (void)z) \
+    X(FDCB, AE, RES(z, 5, IYd)) \
+    X(FDCB, AF, (void)z) \
+    X(FDCB, B0, (void)z) \
+    X(FDCB, B1, (void)z) \
+    X(FDCB, B2, (void)z) \
+    X(FDCB, B3, (void)z) \
+    X(FDCB, B4, (void)z) \
+    X(FDCB, B5, (void)z) \
+    X(FDCB, B6, RES(z, 6, IYd)) \
+    X(FDCB, B7, (void)z) \
+    X(FDCB, B8, (void)z) \
+    X(FDCB, B9, (void)z) \
+    X(FDCB, BA, (void)z) \
+    X(FDCB, BB, (void)z) \
+    X(FDCB, BC, (void)z) \
+    X(FDCB, BD, (void)z) \
+    X(FDCB, BE, RES(z, 7, IYd)) \
+    X(FDCB, BF, (void)z) \
+    X(FDCB, C0, (void)z) \
+    X(FDCB, C1, (void)z) \
+    X(FDCB, C2, (void)z) \
+    X(FDCB, C3, (void)z) \
+    X(FDCB, C4, (void)z) \
+    X(FDCB, C5, (void)z) \
+    X(FDCB, C6, SET(z, 0, IYd)) \
+    X(FDCB, C7, (void)z) \
+    X(FDCB, C8, (void)z) \
+    X(FDCB, C9, (void)z) \
+    X(FDCB, CA, (void)z) \
+    X(FDCB, CB, (void)z) \
+    X(FDCB, CC, (void)z) \
+    X(FDCB, CD, (void)z) \
+    X(FDCB, CE, SET(z, 1, IYd)) \
+    X(FDCB, CF, (void)z) \
+    X(FDCB, D0, (void)z) \
+    X(FDCB, D1, (void)z) \
+    X(FDCB, D2, (void)z) \
+    X(FDCB, D3, (void)z) \
+    X(FDCB, D4, (void)z) \
+    X(FDCB, D5, (void)z) \
+    X(FDCB, D6, SET(z, 2, IYd)) \
+    X(FDCB, D7, (void)z) \
+    X(FDCB, D8, (void)z) \
+    X(FDCB, D9, (void)z) \
+    X(FDCB, DA, (void)z) \
+    X(FDCB, DB, (void)z) \
+    X(FDCB, DC, (void)z) \
+    X(FDCB, DD, (void)z) \
+    X(FDCB, DE, SET(z, 3, IYd)) \
+    X(FDCB, DF, (void)z) \
+    X(FDCB, E0, (void)z) \
+    X(FDCB, E1, (void)z) \
+    X(FDCB, E2, (void)z) \
+    X(FDCB, E3, (void)z) \
+    X(FDCB, E4, (void)z) \
+    X(FDCB, E5, (void)z) \
+    X(FDCB, E6, SET(z, 4, IYd)) \
+    X(FDCB, E7, (void)z) \
+    X(FDCB, E8, (void)z) \
+    X(FDCB, E9, (void)z) \
+    X(FDCB, EA, (void)z) \
+    X(FDCB, EB, (void)z) \
+    X(FDCB, EC, (void)z) \
+    X(FDCB, ED, (void)z) \
+    X(FDCB, EE, SET(z, 5, IYd)) \
+    X(FDCB, EF, (void)z) \
+    X(FDCB, F0, (void)z) \
+    X(FDCB, F1, (void)z) \
+    X(FDCB, F2, (void)z) \
+    X(FDCB, F3, (void)z) \
+    X(FDCB, F4, (void)z) \
+    X(FDCB, F5, (void)z) \
+    X(FDCB, F6, SET(z, 6, IYd)) \
+    X(FDCB, F7, (void)z) \
+    X(FDCB, F8, (void)z) \
+    X(FDCB, F9, (void)z) \
+    X(FDCB, FA, (void)z) \
+    X(FDCB, FB, (void)z) \
+    X(FDCB, FC, (void)z) \
+    X(FDCB, FD, (void)z) \
+    X(FDCB, FE, SET(z, 7, IYd)) \
+    X(FDCB, FF, (void)z)
+
+/* with the opcode profiler compiled in, every opcode handler notes down which opcode it is -
+   prefix handlers do this too, but are then overwritten by the opcode they dispatch to */
+#if defined(Z80_PROFILER)
+#define Z80_PROFILE_OPCODE(prefix, op) z->profileTable = prefix##_TABLE; z->profileOpcode = 0x##op;
+#else
+#define Z80_PROFILE_OPCODE(prefix, op)
+#endif
+
+/* these macros turn the opcode tables into dispatch code - GCC compatible compilers get
+   labels plus tables of label addresses for use within Z80_executeInstruction, and
+   other compilers get a small static function per opcode plus tables of function pointers */
+#if defined(__GNUC__)
+#define Z80_DISPATCH(prefix) goto *prefix##Labels[fetchOpcode(z)]
+#define Z80_OPCODE_ADDRESS(prefix, op, ...) &&prefix##_##op,
+#define Z80_OPCODE_LABEL(prefix, op, ...) prefix##_##op: Z80_PROFILE_OPCODE(prefix, op) __VA_ARGS__; goto opcodeDone;
+#else
+#define Z80_DISPATCH(prefix) prefix##Handlers[fetchOpcode(z)](z)
+#define Z80_OPCODE_HANDLER(prefix, op, ...) static void prefix##_##op(Z80 z) { Z80_PROFILE_OPCODE(prefix, op) __VA_ARGS__; }
+#define Z80_OPCODE_POINTER(prefix, op, ...) prefix##_##op,
+
+/* this is the type of an opcode handler function */
+typedef void (*opcodeHandler)(Z80 z);
+
+/* declare the handler tables first, as the prefix handlers refer to them */
+static const opcodeHandler BASEHandlers[256];
+static const opcodeHandler CBHandlers[256];
+static const opcodeHandler DDHandlers[256];
+static const opcodeHandler EDHandlers[256];
+static const opcodeHandler FDHandlers[256];
+static const opcodeHandler DDCBHandlers[256];
+static const opcodeHandler FDCBHandlers[256];
+
+/* define the handler functions themselves */
+Z80_BASE_OPCODES(Z80_OPCODE_HANDLER)
+Z80_CB_OPCODES(Z80_OPCODE_HANDLER)
+Z80_DD_OPCODES(Z80_OPCODE_HANDLER)
+Z80_ED_OPCODES(Z80_OPCODE_HANDLER)
+Z80_FD_OPCODES(Z80_OPCODE_HANDLER)
+Z80_DDCB_OPCODES(Z80_OPCODE_HANDLER)
+Z80_FDCB_OPCODES(Z80_OPCODE_HANDLER)
+
+/* now fill in the handler tables */
+static const opcodeHandler BASEHandlers[256] = { Z80_BASE_OPCODES(Z80_OPCODE_POINTER) };
+static const opcodeHandler CBHandlers[256] = { Z80_CB_OPCODES(Z80_OPCODE_POINTER) };
+static const opcodeHandler DDHandlers[256] = { Z80_DD_OPCODES(Z80_OPCODE_POINTER) };
+static const opcodeHandler EDHandlers[256] = { Z80_ED_OPCODES(Z80_OPCODE_POINTER) };
+static const opcodeHandler FDHandlers[256] = { Z80_FD_OPCODES(Z80_OPCODE_POINTER) };
+static const opcodeHandler DDCBHandlers[256] = { Z80_DDCB_OPCODES(Z80_OPCODE_POINTER) };
+static const opcodeHandler FDCBHandlers[256] = { Z80_FDCB_OPCODES(Z80_OPCODE_POINTER) };
+#endif
+
 /* this is the main execute block of the Z80 core, fetching instructions and executing them
    accordingly, then returning the correct number of cycles */
 emuint Z80_executeInstruction(Z80 z)
 {
     /* initialise cycle count to zero and setup some other local variables */
     z->cycles = 0;
-    emubyte opcode = 0, cbOpcode = 0, ddOpcode = 0, edOpcode = 0, fdOpcode = 0;
-    
-    /* this checks for non-maskable interrupts every instruction */
-    if (console_checkNmi(z->ms))
-        z->nmi = 1;
+    emubyte opcode = 0;
+#if defined(Z80_PROFILER)
+    z->profileTable = OPCODE_TABLE_COUNT;
+#endif
+#if defined(Z80_TRACE)
+    if (z->traceEnabled)
+        beginTraceEntry(z);
+#endif
 
     /* handle non-maskable interrupt if received */
     if (z->nmi) {
@@ -315,6 +2585,7 @@ emuint Z80_executeInstruction(Z80 z)
         z->iff2 = z->iff1;
         z->iff1 = 0;
         z->halt = 0;
+        z->idleLoopClean = false;
 
         /* store program counter on the stack */
         decrementStackPointer(z);
@@ -327,7 +2598,7 @@ emuint Z80_executeInstruction(Z80 z)
         z->cycles = 11;
     }
     /* this checks for normal interrupts if there is no NMI, as NMI takes priority */
-    else if ((z->interruptPending = console_checkInterrupt(z->ms)) && (z->iff1) && !z->followingInstruction && z->interruptCounter > 100) {
+    else if ((z->interruptPending = z->interruptLine) && (z->iff1) && !z->followingInstruction && z->interruptCounter > 100) {
         /* decides what to do based on the interupt mode */
         switch (z->intMode) {
             case 0: break; /* we don't use mode 0 on the master system */
@@ -341,6 +2612,7 @@ emuint Z80_executeInstruction(Z80 z)
                 z->halt = 0;
                 z->iff1 = 0;
                 z->iff2 = 0;
+                z->idleLoopClean = false;
 
                 /* store program counter on the stack */
                 decrementStackPointer(z);
@@ -360,11 +2632,16 @@ emuint Z80_executeInstruction(Z80 z)
     else if (z->halt) {
         /* this enable maskable interrupts to run following a HALT */
         z->followingInstruction = false;
+        z->idleLoopClean = false;
 
         /* execute NOPs continually in the HALT state and top up
-           the memory refresh register */
-        NOP(z);
-        incrementRefreshRegister(z);
+           the memory refresh register - all the NOPs that can happen before
+           the end of the current run or the next interrupt are done in one go */
+        emuint nops = countHaltedNops(z);
+        z->cycles = 4 * nops;
+#if !defined(FAST_PROFILE)
+        z->regR = (z->regR & 0x80) | ((z->regR + nops) & 0x7F);
+#endif
     }
     /* fetch/process opcodes as normal */
     else {
@@ -372,10 +2649,47 @@ emuint Z80_executeInstruction(Z80 z)
            instruction (except EI) */
         z->followingInstruction = false;
 
+#if defined(__GNUC__)
+        static const void *const BASELabels[256] = { Z80_BASE_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const CBLabels[256] = { Z80_CB_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const DDLabels[256] = { Z80_DD_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const EDLabels[256] = { Z80_ED_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const FDLabels[256] = { Z80_FD_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const DDCBLabels[256] = { Z80_DDCB_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const FDCBLabels[256] = { Z80_FDCB_OPCODES(Z80_OPCODE_ADDRESS) };
+        static const void *const *const handlerTables[7] = { BASELabels, CBLabels, DDLabels, EDLabels, FDLabels, DDCBLabels, FDCBLabels };
+#else
+        static const opcodeHandler *const handlerTables[7] = { BASEHandlers, CBHandlers, DDHandlers, EDHandlers, FDHandlers, DDCBHandlers, FDCBHandlers };
+#endif
+
+        /* with the block cache enabled, look the instruction up there first - if it has been
+           decoded already, we skip past its prefix and opcode bytes and go straight to the
+           handler, doing the same as the normal fetch would have done on the way, and the
+           handler takes its operands from the decoded copy rather than from memory */
+        if (z->blockCache) {
+            z->operandCount = 0;
+            if (!(z->ddStub || z->fdStub)) {
+                struct DecodedInstruction *decoded = findDecodedInstruction(z);
+                if (decoded != NULL) {
+                    if (decoded->handler == NULL)
+                        decoded->handler = handlerTables[decoded->table][decoded->opcode];
+                    writeProgramCounter(z, readProgramCounter(z) + decoded->length);
+                    incrementRefreshRegister(z);
+                    z->operands = decoded->operands;
+                    z->operandCount = decoded->operandCount;
+#if defined(__GNUC__)
+                    goto *decoded->handler;
+#else
+                    decoded->handler(z);
+                    goto instructionDone;
+#endif
+                }
+            }
+        }
+
         /* load instruction opcode using program counter */
         if (!(z->ddStub || z->fdStub)) {
-            opcode = readFromMemory(z, readProgramCounter(z));
-            incrementProgramCounter(z);
+            opcode = fetchOpcode(z);
         } else if (z->ddStub) {
             z->ddStub = false;
             opcode = 0xDD;
@@ -384,1031 +2698,38 @@ emuint Z80_executeInstruction(Z80 z)
             opcode = 0xFD;
         }
 
-        /* increment refresh register and call relevant instruction function */
+        /* increment refresh register and call relevant instruction function - GCC compatible
+           compilers jump straight to the handler label through a table of label addresses,
+           and everything else calls through a table of function pointers */
         incrementRefreshRegister(z);
-        switch (opcode) {
-            /* this is for the '8-bit load' group of instructions with
-               only one opcode */
-            case 0x7F: LD_8Bit(z, A, A); break;
-            case 0x78: LD_8Bit(z, A, B); break;
-            case 0x79: LD_8Bit(z, A, C); break;
-            case 0x7A: LD_8Bit(z, A, D); break;
-            case 0x7B: LD_8Bit(z, A, E); break;
-            case 0x7C: LD_8Bit(z, A, H); break;
-            case 0x7D: LD_8Bit(z, A, L); break;
-            case 0x47: LD_8Bit(z, B, A); break;
-            case 0x40: LD_8Bit(z, B, B); break;
-            case 0x41: LD_8Bit(z, B, C); break;
-            case 0x42: LD_8Bit(z, B, D); break;
-            case 0x43: LD_8Bit(z, B, E); break;
-            case 0x44: LD_8Bit(z, B, H); break;
-            case 0x45: LD_8Bit(z, B, L); break;
-            case 0x4F: LD_8Bit(z, C, A); break;
-            case 0x48: LD_8Bit(z, C, B); break;
-            case 0x49: LD_8Bit(z, C, C); break;
-            case 0x4A: LD_8Bit(z, C, D); break;
-            case 0x4B: LD_8Bit(z, C, E); break;
-            case 0x4C: LD_8Bit(z, C, H); break;
-            case 0x4D: LD_8Bit(z, C, L); break;
-            case 0x57: LD_8Bit(z, D, A); break;
-            case 0x50: LD_8Bit(z, D, B); break;
-            case 0x51: LD_8Bit(z, D, C); break;
-            case 0x52: LD_8Bit(z, D, D); break;
-            case 0x53: LD_8Bit(z, D, E); break;
-            case 0x54: LD_8Bit(z, D, H); break;
-            case 0x55: LD_8Bit(z, D, L); break;
-            case 0x5F: LD_8Bit(z, E, A); break;
-            case 0x58: LD_8Bit(z, E, B); break;
-            case 0x59: LD_8Bit(z, E, C); break;
-            case 0x5A: LD_8Bit(z, E, D); break;
-            case 0x5B: LD_8Bit(z, E, E); break;
-            case 0x5C: LD_8Bit(z, E, H); break;
-            case 0x5D: LD_8Bit(z, E, L); break;
-            case 0x67: LD_8Bit(z, H, A); break;
-            case 0x60: LD_8Bit(z, H, B); break;
-            case 0x61: LD_8Bit(z, H, C); break;
-            case 0x62: LD_8Bit(z, H, D); break;
-            case 0x63: LD_8Bit(z, H, E); break;
-            case 0x64: LD_8Bit(z, H, H); break;
-            case 0x65: LD_8Bit(z, H, L); break;
-            case 0x6F: LD_8Bit(z, L, A); break;
-            case 0x68: LD_8Bit(z, L, B); break;
-            case 0x69: LD_8Bit(z, L, C); break;
-            case 0x6A: LD_8Bit(z, L, D); break;
-            case 0x6B: LD_8Bit(z, L, E); break;
-            case 0x6C: LD_8Bit(z, L, H); break;
-            case 0x6D: LD_8Bit(z, L, L); break;
-            case 0x3E: LD_8Bit(z, A, n); break;
-            case 0x06: LD_8Bit(z, B, n); break;
-            case 0x0E: LD_8Bit(z, C, n); break;
-            case 0x16: LD_8Bit(z, D, n); break;
-            case 0x1E: LD_8Bit(z, E, n); break;
-            case 0x26: LD_8Bit(z, H, n); break;
-            case 0x2E: LD_8Bit(z, L, n); break;
-            case 0x7E: LD_8Bit(z, A, aHL); break;
-            case 0x46: LD_8Bit(z, B, aHL); break;
-            case 0x4E: LD_8Bit(z, C, aHL); break;
-            case 0x56: LD_8Bit(z, D, aHL); break;
-            case 0x5E: LD_8Bit(z, E, aHL); break;
-            case 0x66: LD_8Bit(z, H, aHL); break;
-            case 0x6E: LD_8Bit(z, L, aHL); break;
-            case 0x77: LD_8Bit(z, aHL, A); break;
-            case 0x70: LD_8Bit(z, aHL, B); break;
-            case 0x71: LD_8Bit(z, aHL, C); break;
-            case 0x72: LD_8Bit(z, aHL, D); break;
-            case 0x73: LD_8Bit(z, aHL, E); break;
-            case 0x74: LD_8Bit(z, aHL, H); break;
-            case 0x75: LD_8Bit(z, aHL, L); break;
-            case 0x36: LD_8Bit(z, aHL, n); break;
-            case 0x0A: LD_8Bit(z, A, aBC); break;
-            case 0x1A: LD_8Bit(z, A, aDE); break;
-            case 0x3A: LD_8Bit(z, A, a_nn); break;
-            case 0x02: LD_8Bit(z, aBC, A); break;
-            case 0x12: LD_8Bit(z, aDE, A); break;
-            case 0x32: LD_8Bit(z, a_nn, A); break;
-
-            /* this is for the '16-bit load' group of instructions with
-               only one opcode */
-            case 0x01: LD_16Bit(z, BC, nn, 0); break;
-            case 0x11: LD_16Bit(z, DE, nn, 0); break;
-            case 0x21: LD_16Bit(z, HL, nn, 0); break;
-            case 0x31: LD_16Bit(z, SP, nn, 0); break;
-            case 0x2A: LD_16Bit(z, HL, a_nn, 0); break;
-            case 0x22: LD_16Bit(z, a_nn, HL, 0); break;
-            case 0xF9: LD_16Bit(z, SP, HL, 0); break;
-            case 0xC5: PUSH(z, BC); break;
-            case 0xD5: PUSH(z, DE); break;
-            case 0xE5: PUSH(z, HL); break;
-            case 0xF5: PUSH(z, AF); break;
-            case 0xC1: POP(z, BC); break;
-            case 0xD1: POP(z, DE); break;
-            case 0xE1: POP(z, HL); break;
-            case 0xF1: POP(z, AF); break;
-
-            /* this is for the 'exchange, block transfer, and search'
-               of instructions with only one opcode */
-            case 0xEB: EX(z, DE, HL); break;
-            case 0x08: EX(z, AF, AFShadow); break;
-            case 0xD9: EXX(z); break;
-            case 0xE3: EX(z, aSP, HL); break;
-
-            /* this is for the '8-bit arithmetic group' of
-               instructions with only one opcode */
-            case 0x87: ADD(z, A, A); break;
-            case 0x80: ADD(z, A, B); break;
-            case 0x81: ADD(z, A, C); break;
-            case 0x82: ADD(z, A, D); break;
-            case 0x83: ADD(z, A, E); break;
-            case 0x84: ADD(z, A, H); break;
-            case 0x85: ADD(z, A, L); break;
-            case 0xC6: ADD(z, A, n); break;
-            case 0x86: ADD(z, A, aHL); break;
-            case 0x88: ADC(z, B); break;
-            case 0x89: ADC(z, C); break;
-            case 0x8A: ADC(z, D); break;
-            case 0x8B: ADC(z, E); break;
-            case 0x8C: ADC(z, H); break;
-            case 0x8D: ADC(z, L); break;
-            case 0x8F: ADC(z, A); break;
-            case 0xCE: ADC(z, n); break;
-            case 0x8E: ADC(z, aHL); break;
-            case 0x90: SUB(z, B); break;
-            case 0x91: SUB(z, C); break;
-            case 0x92: SUB(z, D); break;
-            case 0x93: SUB(z, E); break;
-            case 0x94: SUB(z, H); break;
-            case 0x95: SUB(z, L); break;
-            case 0x97: SUB(z, A); break;
-            case 0xD6: SUB(z, n); break;
-            case 0x96: SUB(z, aHL); break;
-            case 0x98: SBC(z, B); break;
-            case 0x99: SBC(z, C); break;
-            case 0x9A: SBC(z, D); break;
-            case 0x9B: SBC(z, E); break;
-            case 0x9C: SBC(z, H); break;
-            case 0x9D: SBC(z, L); break;
-            case 0x9F: SBC(z, A); break;
-            case 0xDE: SBC(z, n); break;
-            case 0x9E: SBC(z, aHL); break;
-            case 0xA0: AND(z, B); break;
-            case 0xA1: AND(z, C); break;
-            case 0xA2: AND(z, D); break;
-            case 0xA3: AND(z, E); break;
-            case 0xA4: AND(z, H); break;
-            case 0xA5: AND(z, L); break;
-            case 0xA7: AND(z, A); break;
-            case 0xE6: AND(z, n); break;
-            case 0xA6: AND(z, aHL); break;
-            case 0xB0: OR(z, B); break;
-            case 0xB1: OR(z, C); break;
-            case 0xB2: OR(z, D); break;
-            case 0xB3: OR(z, E); break;
-            case 0xB4: OR(z, H); break;
-            case 0xB5: OR(z, L); break;
-            case 0xB7: OR(z, A); break;
-            case 0xF6: OR(z, n); break;
-            case 0xB6: OR(z, aHL); break;
-            case 0xA8: XOR(z, B); break;
-            case 0xA9: XOR(z, C); break;
-            case 0xAA: XOR(z, D); break;
-            case 0xAB: XOR(z, E); break;
-            case 0xAC: XOR(z, H); break;
-            case 0xAD: XOR(z, L); break;
-            case 0xAF: XOR(z, A); break;
-            case 0xEE: XOR(z, n); break;
-            case 0xAE: XOR(z, aHL); break;
-            case 0xB8: CP(z, B); break;
-            case 0xB9: CP(z, C); break;
-            case 0xBA: CP(z, D); break;
-            case 0xBB: CP(z, E); break;
-            case 0xBC: CP(z, H); break;
-            case 0xBD: CP(z, L); break;
-            case 0xBF: CP(z, A); break;
-            case 0xFE: CP(z, n); break;
-            case 0xBE: CP(z, aHL); break;
-            case 0x3C: INC(z, A); break;
-            case 0x04: INC(z, B); break;
-            case 0x0C: INC(z, C); break;
-            case 0x14: INC(z, D); break;
-            case 0x1C: INC(z, E); break;
-            case 0x24: INC(z, H); break;
-            case 0x2C: INC(z, L); break;
-            case 0x34: INC(z, aHL); break;
-            case 0x05: DEC(z, B); break;
-            case 0x0D: DEC(z, C); break;
-            case 0x15: DEC(z, D); break;
-            case 0x1D: DEC(z, E); break;
-            case 0x25: DEC(z, H); break;
-            case 0x2D: DEC(z, L); break;
-            case 0x3D: DEC(z, A); break;
-            case 0x35: DEC(z, aHL); break;
-
-            /* this is for the 'general purpose arithmetic and CPU
-               control group' of instructions with only one opcode */
-            case 0x27: DAA(z); break;
-            case 0x2F: CPL(z); break;
-            case 0x3F: CCF(z); break;
-            case 0x37: SCF(z); break;
-            case 0x00: NOP(z); break;
-            case 0x76: HALT(z); break;
-            case 0xF3: DI(z); break;
-            case 0xFB: EI(z); break;
-
-            /* this is for the '16-bit arithmetic group' of
-               instructions with only one opcode */
-            case 0x09: ADD(z, HL, BC); break;
-            case 0x19: ADD(z, HL, DE); break;
-            case 0x29: ADD(z, HL, HL); break;
-            case 0x39: ADD(z, HL, SP); break;
-            case 0x03: INC(z, BC); break;
-            case 0x13: INC(z, DE); break;
-            case 0x23: INC(z, HL); break;
-            case 0x33: INC(z, SP); break;
-            case 0x0B: DEC(z, BC); break;
-            case 0x1B: DEC(z, DE); break;
-            case 0x2B: DEC(z, HL); break;
-            case 0x3B: DEC(z, SP); break;
-
-            /* this is for the 'rotate and shift group' of instructions
-               with only one opcode */
-            case 0x07: RLCA(z); break;
-            case 0x17: RLA(z); break;
-            case 0x0F: RRCA(z); break;
-            case 0x1F: RRA(z); break;
-
-            /* this is for the 'jump group' of instructions with only
-               one opcode */
-            case 0xC3: JP(z, nn); break;
-            case 0xC2: JP_CONDITIONAL(z, NZ); break;
-            case 0xCA: JP_CONDITIONAL(z, Z); break;
-            case 0xD2: JP_CONDITIONAL(z, NC); break;
-            case 0xDA: JP_CONDITIONAL(z, C); break;
-            case 0xE2: JP_CONDITIONAL(z, PO); break;
-            case 0xEA: JP_CONDITIONAL(z, PE); break;
-            case 0xF2: JP_CONDITIONAL(z, P); break;
-            case 0xFA: JP_CONDITIONAL(z, M); break;
-            case 0x18: JR(z); break;
-            case 0x38: JR_CONDITIONAL(z, C); break;
-            case 0x30: JR_CONDITIONAL(z, NC); break;
-            case 0x28: JR_CONDITIONAL(z, Z); break;
-            case 0x20: JR_CONDITIONAL(z, NZ); break;
-            case 0xE9: JP(z, HL); break;
-            case 0x10: DJNZ(z); break;
-
-            /* this is for the 'call and return group' of instructions
-               with only one opcode */
-            case 0xCD: CALL(z); break;
-            case 0xC4: CALL_CONDITIONAL(z, NZ); break;
-            case 0xCC: CALL_CONDITIONAL(z, Z); break;
-            case 0xD4: CALL_CONDITIONAL(z, NC); break;
-            case 0xDC: CALL_CONDITIONAL(z, C); break;
-            case 0xE4: CALL_CONDITIONAL(z, PO); break;
-            case 0xEC: CALL_CONDITIONAL(z, PE); break;
-            case 0xF4: CALL_CONDITIONAL(z, P); break;
-            case 0xFC: CALL_CONDITIONAL(z, M); break;
-            case 0xC9: RET(z); break;
-            case 0xC0: RET_CONDITIONAL(z, NZ); break;
-            case 0xC8: RET_CONDITIONAL(z, Z); break;
-            case 0xD0: RET_CONDITIONAL(z, NC); break;
-            case 0xD8: RET_CONDITIONAL(z, C); break;
-            case 0xE0: RET_CONDITIONAL(z, PO); break;
-            case 0xE8: RET_CONDITIONAL(z, PE); break;
-            case 0xF0: RET_CONDITIONAL(z, P); break;
-            case 0xF8: RET_CONDITIONAL(z, M); break;
-            case 0xC7: RST(z, 0x00); break;
-            case 0xCF: RST(z, 0x08); break;
-            case 0xD7: RST(z, 0x10); break;
-            case 0xDF: RST(z, 0x18); break;
-            case 0xE7: RST(z, 0x20); break;
-            case 0xEF: RST(z, 0x28); break;
-            case 0xF7: RST(z, 0x30); break;
-            case 0xFF: RST(z, 0x38); break;
-
-            /* this is for the 'input and output group' of instructions with
-               only one opcode */
-            case 0xDB: IN(z, A, a_n); break;
-            case 0xD3: OUT(z, a_n, A); break;
-
-            /* this is for instructions following the CB opcode */
-            case 0xCB:
-            {
-                cbOpcode = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
-                switch (cbOpcode)
-                {
-                    /* this is for the 'rotate and shift group' of instructions
-                       with multi-opcodes */
-                    case 0x00: RLC(z, B); break;
-                    case 0x01: RLC(z, C); break;
-                    case 0x02: RLC(z, D); break;
-                    case 0x03: RLC(z, E); break;
-                    case 0x04: RLC(z, H); break;
-                    case 0x05: RLC(z, L); break;
-                    case 0x07: RLC(z, A); break;
-                    case 0x06: RLC(z, aHL); break;
-                    case 0x10: RL(z, B); break;
-                    case 0x11: RL(z, C); break;
-                    case 0x12: RL(z, D); break;
-                    case 0x13: RL(z, E); break;
-                    case 0x14: RL(z, H); break;
-                    case 0x15: RL(z, L); break;
-                    case 0x17: RL(z, A); break;
-                    case 0x16: RL(z, aHL); break;
-                    case 0x08: RRC(z, B); break;
-                    case 0x09: RRC(z, C); break;
-                    case 0x0A: RRC(z, D); break;
-                    case 0x0B: RRC(z, E); break;
-                    case 0x0C: RRC(z, H); break;
-                    case 0x0D: RRC(z, L); break;
-                    case 0x0F: RRC(z, A); break;
-                    case 0x0E: RRC(z, aHL); break;
-                    case 0x18: RR(z, B); break;
-                    case 0x19: RR(z, C); break;
-                    case 0x1A: RR(z, D); break;
-                    case 0x1B: RR(z, E); break;
-                    case 0x1C: RR(z, H); break;
-                    case 0x1D: RR(z, L); break;
-                    case 0x1F: RR(z, A); break;
-                    case 0x1E: RR(z, aHL); break;
-                    case 0x20: SLA(z, B); break;
-                    case 0x21: SLA(z, C); break;
-                    case 0x22: SLA(z, D); break;
-                    case 0x23: SLA(z, E); break;
-                    case 0x24: SLA(z, H); break;
-                    case 0x25: SLA(z, L); break;
-                    case 0x27: SLA(z, A); break;
-                    case 0x26: SLA(z, aHL); break;
-                    case 0x28: SRA(z, B); break;
-                    case 0x29: SRA(z, C); break;
-                    case 0x2A: SRA(z, D); break;
-                    case 0x2B: SRA(z, E); break;
-                    case 0x2C: SRA(z, H); break;
-                    case 0x2D: SRA(z, L); break;
-                    case 0x2F: SRA(z, A); break;
-                    case 0x2E: SRA(z, aHL); break;
-                    case 0x38: SRL(z, B); break;
-                    case 0x39: SRL(z, C); break;
-                    case 0x3A: SRL(z, D); break;
-                    case 0x3B: SRL(z, E); break;
-                    case 0x3C: SRL(z, H); break;
-                    case 0x3D: SRL(z, L); break;
-                    case 0x3F: SRL(z, A); break;
-                    case 0x3E: SRL(z, aHL); break;
-                    case 0x30: SLL(z, B); break; /* undocumented */
-                    case 0x31: SLL(z, C); break; /* undocumented */
-                    case 0x32: SLL(z, D); break; /* undocumented */
-                    case 0x33: SLL(z, E); break; /* undocumented */
-                    case 0x34: SLL(z, H); break; /* undocumented */
-                    case 0x35: SLL(z, L); break; /* undocumented */
-                    case 0x36: SLL(z, aHL); break; /* undocumented */
-                    case 0x37: SLL(z, A); break; /* undocumented */
-
-                    /* this is for the 'bit set, reset, and test group' of
-                       instructions with multi-opcodes */
-                    case 0x40: BIT(z, 0, B); break;
-                    case 0x41: BIT(z, 0, C); break;
-                    case 0x42: BIT(z, 0, D); break;
-                    case 0x43: BIT(z, 0, E); break;
-                    case 0x44: BIT(z, 0, H); break;
-                    case 0x45: BIT(z, 0, L); break;
-                    case 0x47: BIT(z, 0, A); break;
-                    case 0x48: BIT(z, 1, B); break;
-                    case 0x49: BIT(z, 1, C); break;
-                    case 0x4A: BIT(z, 1, D); break;
-                    case 0x4B: BIT(z, 1, E); break;
-                    case 0x4C: BIT(z, 1, H); break;
-                    case 0x4D: BIT(z, 1, L); break;
-                    case 0x4F: BIT(z, 1, A); break;
-                    case 0x50: BIT(z, 2, B); break;
-                    case 0x51: BIT(z, 2, C); break;
-                    case 0x52: BIT(z, 2, D); break;
-                    case 0x53: BIT(z, 2, E); break;
-                    case 0x54: BIT(z, 2, H); break;
-                    case 0x55: BIT(z, 2, L); break;
-                    case 0x57: BIT(z, 2, A); break;
-                    case 0x58: BIT(z, 3, B); break;
-                    case 0x59: BIT(z, 3, C); break;
-                    case 0x5A: BIT(z, 3, D); break;
-                    case 0x5B: BIT(z, 3, E); break;
-                    case 0x5C: BIT(z, 3, H); break;
-                    case 0x5D: BIT(z, 3, L); break;
-                    case 0x5F: BIT(z, 3, A); break;
-                    case 0x60: BIT(z, 4, B); break;
-                    case 0x61: BIT(z, 4, C); break;
-                    case 0x62: BIT(z, 4, D); break;
-                    case 0x63: BIT(z, 4, E); break;
-                    case 0x64: BIT(z, 4, H); break;
-                    case 0x65: BIT(z, 4, L); break;
-                    case 0x67: BIT(z, 4, A); break;
-                    case 0x68: BIT(z, 5, B); break;
-                    case 0x69: BIT(z, 5, C); break;
-                    case 0x6A: BIT(z, 5, D); break;
-                    case 0x6B: BIT(z, 5, E); break;
-                    case 0x6C: BIT(z, 5, H); break;
-                    case 0x6D: BIT(z, 5, L); break;
-                    case 0x6F: BIT(z, 5, A); break;
-                    case 0x70: BIT(z, 6, B); break;
-                    case 0x71: BIT(z, 6, C); break;
-                    case 0x72: BIT(z, 6, D); break;
-                    case 0x73: BIT(z, 6, E); break;
-                    case 0x74: BIT(z, 6, H); break;
-                    case 0x75: BIT(z, 6, L); break;
-                    case 0x77: BIT(z, 6, A); break;
-                    case 0x78: BIT(z, 7, B); break;
-                    case 0x79: BIT(z, 7, C); break;
-                    case 0x7A: BIT(z, 7, D); break;
-                    case 0x7B: BIT(z, 7, E); break;
-                    case 0x7C: BIT(z, 7, H); break;
-                    case 0x7D: BIT(z, 7, L); break;
-                    case 0x7F: BIT(z, 7, A); break;
-                    case 0x46: BIT(z, 0, aHL); break;
-                    case 0x4E: BIT(z, 1, aHL); break;
-                    case 0x56: BIT(z, 2, aHL); break;
-                    case 0x5E: BIT(z, 3, aHL); break;
-                    case 0x66: BIT(z, 4, aHL); break;
-                    case 0x6E: BIT(z, 5, aHL); break;
-                    case 0x76: BIT(z, 6, aHL); break;
-                    case 0x7E: BIT(z, 7, aHL); break;
-                    case 0xC0: SET(z, 0, B); break;
-                    case 0xC1: SET(z, 0, C); break;
-                    case 0xC2: SET(z, 0, D); break;
-                    case 0xC3: SET(z, 0, E); break;
-                    case 0xC4: SET(z, 0, H); break;
-                    case 0xC5: SET(z, 0, L); break;
-                    case 0xC7: SET(z, 0, A); break;
-                    case 0xC8: SET(z, 1, B); break;
-                    case 0xC9: SET(z, 1, C); break;
-                    case 0xCA: SET(z, 1, D); break;
-                    case 0xCB: SET(z, 1, E); break;
-                    case 0xCC: SET(z, 1, H); break;
-                    case 0xCD: SET(z, 1, L); break;
-                    case 0xCF: SET(z, 1, A); break;
-                    case 0xD0: SET(z, 2, B); break;
-                    case 0xD1: SET(z, 2, C); break;
-                    case 0xD2: SET(z, 2, D); break;
-                    case 0xD3: SET(z, 2, E); break;
-                    case 0xD4: SET(z, 2, H); break;
-                    case 0xD5: SET(z, 2, L); break;
-                    case 0xD7: SET(z, 2, A); break;
-                    case 0xD8: SET(z, 3, B); break;
-                    case 0xD9: SET(z, 3, C); break;
-                    case 0xDA: SET(z, 3, D); break;
-                    case 0xDB: SET(z, 3, E); break;
-                    case 0xDC: SET(z, 3, H); break;
-                    case 0xDD: SET(z, 3, L); break;
-                    case 0xDF: SET(z, 3, A); break;
-                    case 0xE0: SET(z, 4, B); break;
-                    case 0xE1: SET(z, 4, C); break;
-                    case 0xE2: SET(z, 4, D); break;
-                    case 0xE3: SET(z, 4, E); break;
-                    case 0xE4: SET(z, 4, H); break;
-                    case 0xE5: SET(z, 4, L); break;
-                    case 0xE7: SET(z, 4, A); break;
-                    case 0xE8: SET(z, 5, B); break;
-                    case 0xE9: SET(z, 5, C); break;
-                    case 0xEA: SET(z, 5, D); break;
-                    case 0xEB: SET(z, 5, E); break;
-                    case 0xEC: SET(z, 5, H); break;
-                    case 0xED: SET(z, 5, L); break;
-                    case 0xEF: SET(z, 5, A); break;
-                    case 0xF0: SET(z, 6, B); break;
-                    case 0xF1: SET(z, 6, C); break;
-                    case 0xF2: SET(z, 6, D); break;
-                    case 0xF3: SET(z, 6, E); break;
-                    case 0xF4: SET(z, 6, H); break;
-                    case 0xF5: SET(z, 6, L); break;
-                    case 0xF7: SET(z, 6, A); break;
-                    case 0xF8: SET(z, 7, B); break;
-                    case 0xF9: SET(z, 7, C); break;
-                    case 0xFA: SET(z, 7, D); break;
-                    case 0xFB: SET(z, 7, E); break;
-                    case 0xFC: SET(z, 7, H); break;
-                    case 0xFD: SET(z, 7, L); break;
-                    case 0xFF: SET(z, 7, A); break;
-                    case 0xC6: SET(z, 0, aHL); break;
-                    case 0xCE: SET(z, 1, aHL); break;
-                    case 0xD6: SET(z, 2, aHL); break;
-                    case 0xDE: SET(z, 3, aHL); break;
-                    case 0xE6: SET(z, 4, aHL); break;
-                    case 0xEE: SET(z, 5, aHL); break;
-                    case 0xF6: SET(z, 6, aHL); break;
-                    case 0xFE: SET(z, 7, aHL); break;
-                    case 0x80: RES(z, 0, B); break;
-                    case 0x81: RES(z, 0, C); break;
-                    case 0x82: RES(z, 0, D); break;
-                    case 0x83: RES(z, 0, E); break;
-                    case 0x84: RES(z, 0, H); break;
-                    case 0x85: RES(z, 0, L); break;
-                    case 0x87: RES(z, 0, A); break;
-                    case 0x88: RES(z, 1, B); break;
-                    case 0x89: RES(z, 1, C); break;
-                    case 0x8A: RES(z, 1, D); break;
-                    case 0x8B: RES(z, 1, E); break;
-                    case 0x8C: RES(z, 1, H); break;
-                    case 0x8D: RES(z, 1, L); break;
-                    case 0x8F: RES(z, 1, A); break;
-                    case 0x90: RES(z, 2, B); break;
-                    case 0x91: RES(z, 2, C); break;
-                    case 0x92: RES(z, 2, D); break;
-                    case 0x93: RES(z, 2, E); break;
-                    case 0x94: RES(z, 2, H); break;
-                    case 0x95: RES(z, 2, L); break;
-                    case 0x97: RES(z, 2, A); break;
-                    case 0x98: RES(z, 3, B); break;
-                    case 0x99: RES(z, 3, C); break;
-                    case 0x9A: RES(z, 3, D); break;
-                    case 0x9B: RES(z, 3, E); break;
-                    case 0x9C: RES(z, 3, H); break;
-                    case 0x9D: RES(z, 3, L); break;
-                    case 0x9F: RES(z, 3, A); break;
-                    case 0xA0: RES(z, 4, B); break;
-                    case 0xA1: RES(z, 4, C); break;
-                    case 0xA2: RES(z, 4, D); break;
-                    case 0xA3: RES(z, 4, E); break;
-                    case 0xA4: RES(z, 4, H); break;
-                    case 0xA5: RES(z, 4, L); break;
-                    case 0xA7: RES(z, 4, A); break;
-                    case 0xA8: RES(z, 5, B); break;
-                    case 0xA9: RES(z, 5, C); break;
-                    case 0xAA: RES(z, 5, D); break;
-                    case 0xAB: RES(z, 5, E); break;
-                    case 0xAC: RES(z, 5, H); break;
-                    case 0xAD: RES(z, 5, L); break;
-                    case 0xAF: RES(z, 5, A); break;
-                    case 0xB0: RES(z, 6, B); break;
-                    case 0xB1: RES(z, 6, C); break;
-                    case 0xB2: RES(z, 6, D); break;
-                    case 0xB3: RES(z, 6, E); break;
-                    case 0xB4: RES(z, 6, H); break;
-                    case 0xB5: RES(z, 6, L); break;
-                    case 0xB7: RES(z, 6, A); break;
-                    case 0xB8: RES(z, 7, B); break;
-                    case 0xB9: RES(z, 7, C); break;
-                    case 0xBA: RES(z, 7, D); break;
-                    case 0xBB: RES(z, 7, E); break;
-                    case 0xBC: RES(z, 7, H); break;
-                    case 0xBD: RES(z, 7, L); break;
-                    case 0xBF: RES(z, 7, A); break;
-                    case 0x86: RES(z, 0, aHL); break;
-                    case 0x8E: RES(z, 1, aHL); break;
-                    case 0x96: RES(z, 2, aHL); break;
-                    case 0x9E: RES(z, 3, aHL); break;
-                    case 0xA6: RES(z, 4, aHL); break;
-                    case 0xAE: RES(z, 5, aHL); break;
-                    case 0xB6: RES(z, 6, aHL); break;
-                    case 0xBE: RES(z, 7, aHL); break;
-                }
-            } break;
-
-            /* this is for instructions following the DD opcode */
-            case 0xDD:
-            {
-                ddOpcode = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
-                switch (ddOpcode)
-                {
-                    /* this is a stub for handling the appearance of long sequences
-                       of DD or FD */
-                    case 0xDD: z->ddStub = true; break;
-                    case 0xFD: z->fdStub = true; break;
-
-                    /* this is for multi-opcode 8-bit load instructions */
-                    case 0x7E: LD_8Bit(z, A, IXd); break;
-                    case 0x46: LD_8Bit(z, B, IXd); break;
-                    case 0x4E: LD_8Bit(z, C, IXd); break;
-                    case 0x56: LD_8Bit(z, D, IXd); break;
-                    case 0x5E: LD_8Bit(z, E, IXd); break;
-                    case 0x66: LD_8Bit(z, H, IXd); break;
-                    case 0x6E: LD_8Bit(z, L, IXd); break;
-                    case 0x77: LD_8Bit(z, IXd, A); break;
-                    case 0x70: LD_8Bit(z, IXd, B); break;
-                    case 0x71: LD_8Bit(z, IXd, C); break;
-                    case 0x72: LD_8Bit(z, IXd, D); break;
-                    case 0x73: LD_8Bit(z, IXd, E); break;
-                    case 0x74: LD_8Bit(z, IXd, H); break;
-                    case 0x75: LD_8Bit(z, IXd, L); break;
-                    case 0x36: LD_8Bit(z, IXd, n); break;
-                    case 0x26: LD_8Bit(z, IXh, n); break; /* undocumented */
-                    case 0x2E: LD_8Bit(z, IXl, n); break; /* undocumented */
-                    case 0x44: LD_8Bit(z, B, IXh); break; /* undocumented */
-                    case 0x45: LD_8Bit(z, B, IXl); break; /* undocumented */
-                    case 0x4C: LD_8Bit(z, C, IXh); break; /* undocumented */
-                    case 0x4D: LD_8Bit(z, C, IXl); break; /* undocumented */
-                    case 0x54: LD_8Bit(z, D, IXh); break; /* undocumented */
-                    case 0x55: LD_8Bit(z, D, IXl); break; /* undocumented */
-                    case 0x5C: LD_8Bit(z, E, IXh); break; /* undocumented */
-                    case 0x5D: LD_8Bit(z, E, IXl); break; /* undocumented */
-                    case 0x60: LD_8Bit(z, IXh, B); break; /* undocumented */
-                    case 0x61: LD_8Bit(z, IXh, C); break; /* undocumented */
-                    case 0x62: LD_8Bit(z, IXh, D); break; /* undocumented */
-                    case 0x63: LD_8Bit(z, IXh, E); break; /* undocumented */
-                    case 0x64: LD_8Bit(z, IXh, IXh); break; /* undocumented */
-                    case 0x65: LD_8Bit(z, IXh, IXl); break; /* undocumented */
-                    case 0x67: LD_8Bit(z, IXh, A); break; /* undocumented */
-                    case 0x68: LD_8Bit(z, IXl, B); break; /* undocumented */
-                    case 0x69: LD_8Bit(z, IXl, C); break; /* undocumented */
-                    case 0x6A: LD_8Bit(z, IXl, D); break; /* undocumented */
-                    case 0x6B: LD_8Bit(z, IXl, E); break; /* undocumented */
-                    case 0x6C: LD_8Bit(z, IXl, IXh); break; /* undocumented */
-                    case 0x6D: LD_8Bit(z, IXl, IXl); break; /* undocumented */
-                    case 0x6F: LD_8Bit(z, IXl, A); break; /* undocumented */
-                    case 0x7C: LD_8Bit(z, A, IXh); break; /* undocumented */
-                    case 0x7D: LD_8Bit(z, A, IXl); break; /* undocumented */
-                    case 0x7F: LD_8Bit(z, A, A); break; /* undocumented call */
-                    case 0x78: LD_8Bit(z, A, B); break; /* undocumented call */
-                    case 0x79: LD_8Bit(z, A, C); break; /* undocumented call */
-                    case 0x7A: LD_8Bit(z, A, D); break; /* undocumented call */
-                    case 0x7B: LD_8Bit(z, A, E); break; /* undocumented call */
-                    case 0x47: LD_8Bit(z, B, A); break; /* undocumented call */
-                    case 0x40: LD_8Bit(z, B, B); break; /* undocumented call */
-                    case 0x41: LD_8Bit(z, B, C); break; /* undocumented call */
-                    case 0x42: LD_8Bit(z, B, D); break; /* undocumented call */
-                    case 0x43: LD_8Bit(z, B, E); break; /* undocumented call */
-                    case 0x4F: LD_8Bit(z, C, A); break; /* undocumented call */
-                    case 0x48: LD_8Bit(z, C, B); break; /* undocumented call */
-                    case 0x49: LD_8Bit(z, C, C); break; /* undocumented call */
-                    case 0x4A: LD_8Bit(z, C, D); break; /* undocumented call */
-                    case 0x4B: LD_8Bit(z, C, E); break; /* undocumented call */
-                    case 0x57: LD_8Bit(z, D, A); break; /* undocumented call */
-                    case 0x50: LD_8Bit(z, D, B); break; /* undocumented call */
-                    case 0x51: LD_8Bit(z, D, C); break; /* undocumented call */
-                    case 0x52: LD_8Bit(z, D, D); break; /* undocumented call */
-                    case 0x53: LD_8Bit(z, D, E); break; /* undocumented call */
-                    case 0x5F: LD_8Bit(z, E, A); break; /* undocumented call */
-                    case 0x58: LD_8Bit(z, E, B); break; /* undocumented call */
-                    case 0x59: LD_8Bit(z, E, C); break; /* undocumented call */
-                    case 0x5A: LD_8Bit(z, E, D); break; /* undocumented call */
-                    case 0x5B: LD_8Bit(z, E, E); break; /* undocumented call */
-
-                    /* this is for multi-opcode 16-bit load instructions */
-                    case 0x21: LD_16Bit(z, IX, nn, 0); break;
-                    case 0x2A: LD_16Bit(z, IX, a_nn, 0); break;
-                    case 0x22: LD_16Bit(z, a_nn, IX, 0); break;
-                    case 0xF9: LD_16Bit(z, SP, IX, 0); break;
-                    case 0xE5: PUSH(z, IX); break;
-                    case 0xE1: POP(z, IX); break;
-
-                    /* this is for the 'exchange, block transfer, and search'
-                       of instructions with multi-opcodes */
-                    case 0xE3: EX(z, aSP, IX); break;
-
-                    /* this is for the '8-bit arithmetic group' of
-                       instructions with multi-opcodes */
-                    case 0x86: ADD(z, A, IXd); break;
-                    case 0x8E: ADC(z, IXd); break;
-                    case 0x96: SUB(z, IXd); break;
-                    case 0x9E: SBC(z, IXd); break;
-                    case 0xA6: AND(z, IXd); break;
-                    case 0xB6: OR(z, IXd); break;
-                    case 0xAE: XOR(z, IXd); break;
-                    case 0xBE: CP(z, IXd); break;
-                    case 0x34: INC(z, IXd); break;
-                    case 0x35: DEC(z, IXd); break;
-                    case 0x24: INC(z, IXh); break; /* undocumented */
-                    case 0x25: DEC(z, IXh); break; /* undocumented */
-                    case 0x2C: INC(z, IXl); break; /* undocumented */
-                    case 0x2D: DEC(z, IXl); break; /* undocumented */
-                    case 0x84: ADD(z, A, IXh); break; /* undocumented */
-                    case 0x85: ADD(z, A, IXl); break; /* undocumented */
-                    case 0x8C: ADC(z, IXh); break; /* undocumented */
-                    case 0x8D: ADC(z, IXl); break; /* undocumented */
-                    case 0x94: SUB(z, IXh); break; /* undocumented */
-                    case 0x95: SUB(z, IXl); break; /* undocumented */
-                    case 0x9C: SBC(z, IXh); break; /* undocumented */
-                    case 0x9D: SBC(z, IXl); break; /* undocumented */
-                    case 0xA4: AND(z, IXh); break; /* undocumented */
-                    case 0xA5: AND(z, IXl); break; /* undocumented */
-                    case 0xAC: XOR(z, IXh); break; /* undocumented */
-                    case 0xAD: XOR(z, IXl); break; /* undocumented */
-                    case 0xB4: OR(z, IXh); break; /* undocumented */
-                    case 0xB5: OR(z, IXl); break; /* undocumented */
-                    case 0xBC: CP(z, IXh); break; /* undocumented */
-                    case 0xBD: CP(z, IXl); break; /* undocumented */
-
-                    /* this is for the '16-bit arithmetic group' of
-                       instructions with multi-opcodes */
-                    case 0x09: ADD(z, IX, BC); break;
-                    case 0x19: ADD(z, IX, DE); break;
-                    case 0x29: ADD(z, IX, IX); break;
-                    case 0x39: ADD(z, IX, SP); break;
-                    case 0x23: INC(z, IX); break;
-                    case 0x2B: DEC(z, IX); break;
-
-                    /* this is for the 'jump group' of instructions with
-                       multi-opcodes */
-                    case 0xE9: JP(z, IX); break;
-
-                    /* this is for instructions following the DDCB opcode */
-                    case 0xCB:
-                    {
-                        incrementProgramCounter(z);
-                        cbOpcode = readFromMemory(z, readProgramCounter(z));
-                        incrementProgramCounter(z);
-                        switch (cbOpcode)
-                        {
-                            /* this is for the 'rotate and shift group' of instructions
-                               with multi-opcodes */
-                            case 0x06: RLC(z, IXd); break;
-                            case 0x16: RL(z, IXd); break;
-                            case 0x0E: RRC(z, IXd); break;
-                            case 0x1E: RR(z, IXd); break;
-                            case 0x26: SLA(z, IXd); break;
-                            case 0x2E: SRA(z, IXd); break;
-                            case 0x3E: SRL(z, IXd); break;
-                            case 0x36: SLL(z, IXd); break; /* undocumented */
-
-                            /* this is for the 'bit set, reset, and test group' of
-                               instructions with multi-opcodes */
-                            case 0x46: BIT(z, 0, IXd); break;
-                            case 0x4E: BIT(z, 1, IXd); break;
-                            case 0x56: BIT(z, 2, IXd); break;
-                            case 0x5E: BIT(z, 3, IXd); break;
-                            case 0x66: BIT(z, 4, IXd); break;
-                            case 0x6E: BIT(z, 5, IXd); break;
-                            case 0x76: BIT(z, 6, IXd); break;
-                            case 0x7E: BIT(z, 7, IXd); break;
-                            case 0xC6: SET(z, 0, IXd); break;
-                            case 0xCE: SET(z, 1, IXd); break;
-                            case 0xD6: SET(z, 2, IXd); break;
-                            case 0xDE: SET(z, 3, IXd); break;
-                            case 0xE6: SET(z, 4, IXd); break;
-                            case 0xEE: SET(z, 5, IXd); break;
-                            case 0xF6: SET(z, 6, IXd); break;
-                            case 0xFE: SET(z, 7, IXd); break;
-                            case 0x86: RES(z, 0, IXd); break;
-                            case 0x8E: RES(z, 1, IXd); break;
-                            case 0x96: RES(z, 2, IXd); break;
-                            case 0x9E: RES(z, 3, IXd); break;
-                            case 0xA6: RES(z, 4, IXd); break;
-                            case 0xAE: RES(z, 5, IXd); break;
-                            case 0xB6: RES(z, 6, IXd); break;
-                            case 0xBE: RES(z, 7, IXd); break;
-                        }
-                    } break;
-                }
-            } break;
-
-            /* this is for instructions following the ED opcode */
-            case 0xED:
-            {
-                edOpcode = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
-                switch (edOpcode)
-                {
-                    /* this is for multi-opcode 8-bit load instructions */
-                    case 0x57: LD_8Bit(z, A, I); break;
-                    case 0x5F: LD_8Bit(z, A, R); break;
-                    case 0x47: LD_8Bit(z, I, A); break;
-                    case 0x4F: LD_8Bit(z, R, A); break;
-
-                    /* this is for multi-opcode 16-bit load instructions */
-                    case 0x4B: LD_16Bit(z, BC, a_nn, 0); break;
-                    case 0x5B: LD_16Bit(z, DE, a_nn, 0); break;
-                    case 0x6B: LD_16Bit(z, HL, a_nn, 1); break;
-                    case 0x7B: LD_16Bit(z, SP, a_nn, 0); break;
-                    case 0x43: LD_16Bit(z, a_nn, BC, 0); break;
-                    case 0x53: LD_16Bit(z, a_nn, DE, 0); break;
-                    case 0x63: LD_16Bit(z, a_nn, HL, 1); break;
-                    case 0x73: LD_16Bit(z, a_nn, SP, 0); break;
-
-                    /* this is for the 'exchange, block transfer, and search'
-                       of instructions with multi-opcodes */
-                    case 0xA0: LDI(z); break;
-                    case 0xB0: LDIR(z); break;
-                    case 0xA8: LDD(z); break;
-                    case 0xB8: LDDR(z); break;
-                    case 0xA1: CPI(z); break;
-                    case 0xB1: CPIR(z); break;
-                    case 0xA9: CPD(z); break;
-                    case 0xB9: CPDR(z); break;
-
-                    /* this is for multi-opcode Call and Return instructions */
-                    case 0x45: RETN(z); break;
-
-                    /* this is for the 'general purpose arithmetic and CPU
-                       control group' of instructions with multi-opcodes */
-                    case 0x44: NEG(z); break;
-                    case 0x46: IM(z, 0); break;
-                    case 0x56: IM(z, 1); break;
-                    case 0x5E: IM(z, 2); break;
-
-                    /* this is for the '16-bit arithmetic group' of
-                       instructions with multi-opcodes */
-                    case 0x4A: ADC(z, BC); break;
-                    case 0x5A: ADC(z, DE); break;
-                    case 0x6A: ADC(z, HL); break;
-                    case 0x7A: ADC(z, SP); break;
-                    case 0x42: SBC(z, BC); break;
-                    case 0x52: SBC(z, DE); break;
-                    case 0x62: SBC(z, HL); break;
-                    case 0x72: SBC(z, SP); break;
-
-                    /* this is for the 'rotate and shift group' of instructions
-                       with multi-opcodes */
-                    case 0x6F: RLD(z); break;
-                    case 0x67: RRD(z); break;
-
-                    /* this is for the 'call and return group' of instructions
-                       with multi-opcodes */
-                    case 0x4D: RETI(z); break;
-
-                    /* this is for the 'input and output group' of instructions
-                       with multi-opcodes */
-                    case 0x40: IN(z, B, aC); break;
-                    case 0x48: IN(z, C, aC); break;
-                    case 0x50: IN(z, D, aC); break;
-                    case 0x58: IN(z, E, aC); break;
-                    case 0x60: IN(z, H, aC); break;
-                    case 0x68: IN(z, L, aC); break;
-                    case 0x78: IN(z, A, aC); break;
-                    case 0xA2: INI(z); break;
-                    case 0xB2: INIR(z); break;
-                    case 0xAA: IND(z); break;
-                    case 0xBA: INDR(z); break;
-                    case 0x41: OUT(z, aC, B); break;
-                    case 0x49: OUT(z, aC, C); break;
-                    case 0x51: OUT(z, aC, D); break;
-                    case 0x59: OUT(z, aC, E); break;
-                    case 0x61: OUT(z, aC, H); break;
-                    case 0x69: OUT(z, aC, L); break;
-                    case 0x79: OUT(z, aC, A); break;
-                    case 0xA3: OUTI(z); break;
-                    case 0xB3: OTIR(z); break;
-                    case 0xAB: OUTD(z); break;
-                    case 0xBB: OTDR(z); break;
-                }
-            } break;
-
-            /* this is for instructions following the FD opcode */
-            case 0xFD:
-            {
-                fdOpcode = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
-                switch (fdOpcode)
-                {
-                    /* this is a stub for handling the appearance of long sequences
-                       of DD or FD */
-                    case 0xDD: z->ddStub = true; break;
-                    case 0xFD: z->fdStub = true; break;
-
-                    /* this is for multi-opcode 8-bit load instructions */
-                    case 0x7E: LD_8Bit(z, A, IYd); break;
-                    case 0x46: LD_8Bit(z, B, IYd); break;
-                    case 0x4E: LD_8Bit(z, C, IYd); break;
-                    case 0x56: LD_8Bit(z, D, IYd); break;
-                    case 0x5E: LD_8Bit(z, E, IYd); break;
-                    case 0x66: LD_8Bit(z, H, IYd); break;
-                    case 0x6E: LD_8Bit(z, L, IYd); break;
-                    case 0x77: LD_8Bit(z, IYd, A); break;
-                    case 0x70: LD_8Bit(z, IYd, B); break;
-                    case 0x71: LD_8Bit(z, IYd, C); break;
-                    case 0x72: LD_8Bit(z, IYd, D); break;
-                    case 0x73: LD_8Bit(z, IYd, E); break;
-                    case 0x74: LD_8Bit(z, IYd, H); break;
-                    case 0x75: LD_8Bit(z, IYd, L); break;
-                    case 0x36: LD_8Bit(z, IYd, n); break;
-                    case 0x26: LD_8Bit(z, IYh, n); break; /* undocumented */
-                    case 0x2E: LD_8Bit(z, IYl, n); break; /* undocumented */
-                    case 0x44: LD_8Bit(z, B, IYh); break; /* undocumented */
-                    case 0x45: LD_8Bit(z, B, IYl); break; /* undocumented */
-                    case 0x4C: LD_8Bit(z, C, IYh); break; /* undocumented */
-                    case 0x4D: LD_8Bit(z, C, IYl); break; /* undocumented */
-                    case 0x54: LD_8Bit(z, D, IYh); break; /* undocumented */
-                    case 0x55: LD_8Bit(z, D, IYl); break; /* undocumented */
-                    case 0x5C: LD_8Bit(z, E, IYh); break; /* undocumented */
-                    case 0x5D: LD_8Bit(z, E, IYl); break; /* undocumented */
-                    case 0x60: LD_8Bit(z, IYh, B); break; /* undocumented */
-                    case 0x61: LD_8Bit(z, IYh, C); break; /* undocumented */
-                    case 0x62: LD_8Bit(z, IYh, D); break; /* undocumented */
-                    case 0x63: LD_8Bit(z, IYh, E); break; /* undocumented */
-                    case 0x64: LD_8Bit(z, IYh, IYh); break; /* undocumented */
-                    case 0x65: LD_8Bit(z, IYh, IYl); break; /* undocumented */
-                    case 0x67: LD_8Bit(z, IYh, A); break; /* undocumented */
-                    case 0x68: LD_8Bit(z, IYl, B); break; /* undocumented */
-                    case 0x69: LD_8Bit(z, IYl, C); break; /* undocumented */
-                    case 0x6A: LD_8Bit(z, IYl, D); break; /* undocumented */
-                    case 0x6B: LD_8Bit(z, IYl, E); break; /* undocumented */
-                    case 0x6C: LD_8Bit(z, IYl, IYh); break; /* undocumented */
-                    case 0x6D: LD_8Bit(z, IYl, IYl); break; /* undocumented */
-                    case 0x6F: LD_8Bit(z, IYl, A); break; /* undocumented */
-                    case 0x7C: LD_8Bit(z, A, IYh); break; /* undocumented */
-                    case 0x7D: LD_8Bit(z, A, IYl); break; /* undocumented */
-                    case 0x7F: LD_8Bit(z, A, A); break; /* undocumented call */
-                    case 0x78: LD_8Bit(z, A, B); break; /* undocumented call */
-                    case 0x79: LD_8Bit(z, A, C); break; /* undocumented call */
-                    case 0x7A: LD_8Bit(z, A, D); break; /* undocumented call */
-                    case 0x7B: LD_8Bit(z, A, E); break; /* undocumented call */
-                    case 0x47: LD_8Bit(z, B, A); break; /* undocumented call */
-                    case 0x40: LD_8Bit(z, B, B); break; /* undocumented call */
-                    case 0x41: LD_8Bit(z, B, C); break; /* undocumented call */
-                    case 0x42: LD_8Bit(z, B, D); break; /* undocumented call */
-                    case 0x43: LD_8Bit(z, B, E); break; /* undocumented call */
-                    case 0x4F: LD_8Bit(z, C, A); break; /* undocumented call */
-                    case 0x48: LD_8Bit(z, C, B); break; /* undocumented call */
-                    case 0x49: LD_8Bit(z, C, C); break; /* undocumented call */
-                    case 0x4A: LD_8Bit(z, C, D); break; /* undocumented call */
-                    case 0x4B: LD_8Bit(z, C, E); break; /* undocumented call */
-                    case 0x57: LD_8Bit(z, D, A); break; /* undocumented call */
-                    case 0x50: LD_8Bit(z, D, B); break; /* undocumented call */
-                    case 0x51: LD_8Bit(z, D, C); break; /* undocumented call */
-                    case 0x52: LD_8Bit(z, D, D); break; /* undocumented call */
-                    case 0x53: LD_8Bit(z, D, E); break; /* undocumented call */
-                    case 0x5F: LD_8Bit(z, E, A); break; /* undocumented call */
-                    case 0x58: LD_8Bit(z, E, B); break; /* undocumented call */
-                    case 0x59: LD_8Bit(z, E, C); break; /* undocumented call */
-                    case 0x5A: LD_8Bit(z, E, D); break; /* undocumented call */
-                    case 0x5B: LD_8Bit(z, E, E); break; /* undocumented call */
-
-                    /* this is for multi-opcode 16-bit load instructions */
-                    case 0x21: LD_16Bit(z, IY, nn, 0); break;
-                    case 0x2A: LD_16Bit(z, IY, a_nn, 0); break;
-                    case 0x22: LD_16Bit(z, a_nn, IY, 0); break;
-                    case 0xF9: LD_16Bit(z, SP, IY, 0); break;
-                    case 0xE5: PUSH(z, IY); break;
-                    case 0xE1: POP(z, IY); break;
-
-                    /* this is for the 'exchange, block transfer, and search'
-                       of instructions with multi-opcodes */
-                    case 0xE3: EX(z, aSP, IY); break;
-
-                    /* this is for the '8-bit arithmetic group' of
-                       instructions with multi-opcodes */
-                    case 0x86: ADD(z, A, IYd); break;
-                    case 0x8E: ADC(z, IYd); break;
-                    case 0x96: SUB(z, IYd); break;
-                    case 0x9E: SBC(z, IYd); break;
-                    case 0xA6: AND(z, IYd); break;
-                    case 0xB6: OR(z, IYd); break;
-                    case 0xAE: XOR(z, IYd); break;
-                    case 0xBE: CP(z, IYd); break;
-                    case 0x34: INC(z, IYd); break;
-                    case 0x35: DEC(z, IYd); break;
-                    case 0x24: INC(z, IYh); break; /* undocumented */
-                    case 0x25: DEC(z, IYh); break; /* undocumented */
-                    case 0x2C: INC(z, IYl); break; /* undocumented */
-                    case 0x2D: DEC(z, IYl); break; /* undocumented */
-                    case 0x84: ADD(z, A, IYh); break; /* undocumented */
-                    case 0x85: ADD(z, A, IYl); break; /* undocumented */
-                    case 0x8C: ADC(z, IYh); break; /* undocumented */
-                    case 0x8D: ADC(z, IYl); break; /* undocumented */
-                    case 0x94: SUB(z, IYh); break; /* undocumented */
-                    case 0x95: SUB(z, IYl); break; /* undocumented */
-                    case 0x9C: SBC(z, IYh); break; /* undocumented */
-                    case 0x9D: SBC(z, IYl); break; /* undocumented */
-                    case 0xA4: AND(z, IYh); break; /* undocumented */
-                    case 0xA5: AND(z, IYl); break; /* undocumented */
-                    case 0xAC: XOR(z, IYh); break; /* undocumented */
-                    case 0xAD: XOR(z, IYl); break; /* undocumented */
-                    case 0xB4: OR(z, IYh); break; /* undocumented */
-                    case 0xB5: OR(z, IYl); break; /* undocumented */
-                    case 0xBC: CP(z, IYh); break; /* undocumented */
-                    case 0xBD: CP(z, IYl); break; /* undocumented */
-
-                    /* this is for the '16-bit arithmetic group' of
-                       instructions with multi-opcodes */
-                    case 0x09: ADD(z, IY, BC); break;
-                    case 0x19: ADD(z, IY, DE); break;
-                    case 0x29: ADD(z, IY, IY); break;
-                    case 0x39: ADD(z, IY, SP); break;
-                    case 0x23: INC(z, IY); break;
-                    case 0x2B: DEC(z, IY); break;
-
-                    /* this is for the 'jump group' of instructions with
-                       multi-opcodes */
-                    case 0xE9: JP(z, IY); break;
-
-                    /* this is for instructions following the FDCB opcode */
-                    case 0xCB:
-                    {
-                        incrementProgramCounter(z);
-                        cbOpcode = readFromMemory(z, readProgramCounter(z));
-                        incrementProgramCounter(z);
-                        switch (cbOpcode)
-                        {
-                            /* this is for the 'rotate and shift group' of instructions
-                               with multi-opcodes */
-                            case 0x06: RLC(z, IYd); break;
-                            case 0x16: RL(z, IYd); break;
-                            case 0x0E: RRC(z, IYd); break;
-                            case 0x1E: RR(z, IYd); break;
-                            case 0x26: SLA(z, IYd); break;
-                            case 0x2E: SRA(z, IYd); break;
-                            case 0x3E: SRL(z, IYd); break;
-                            case 0x36: SLL(z, IXd); break; /* undocumented */
-                                
-                            /* this is for the 'bit set, reset, and test group' of
-                               instructions with multi-opcodes */
-                            case 0x46: BIT(z, 0, IYd); break;
-                            case 0x4E: BIT(z, 1, IYd); break;
-                            case 0x56: BIT(z, 2, IYd); break;
-                            case 0x5E: BIT(z, 3, IYd); break;
-                            case 0x66: BIT(z, 4, IYd); break;
-                            case 0x6E: BIT(z, 5, IYd); break;
-                            case 0x76: BIT(z, 6, IYd); break;
-                            case 0x7E: BIT(z, 7, IYd); break;
-                            case 0xC6: SET(z, 0, IYd); break;
-                            case 0xCE: SET(z, 1, IYd); break;
-                            case 0xD6: SET(z, 2, IYd); break;
-                            case 0xDE: SET(z, 3, IYd); break;
-                            case 0xE6: SET(z, 4, IYd); break;
-                            case 0xEE: SET(z, 5, IYd); break;
-                            case 0xF6: SET(z, 6, IYd); break;
-                            case 0xFE: SET(z, 7, IYd); break;
-                            case 0x86: RES(z, 0, IYd); break;
-                            case 0x8E: RES(z, 1, IYd); break;
-                            case 0x96: RES(z, 2, IYd); break;
-                            case 0x9E: RES(z, 3, IYd); break;
-                            case 0xA6: RES(z, 4, IYd); break;
-                            case 0xAE: RES(z, 5, IYd); break;
-                            case 0xB6: RES(z, 6, IYd); break;
-                            case 0xBE: RES(z, 7, IYd); break;
-                        }
-                    } break;
-                }
-            } break;
-
+#if defined(__GNUC__)
+        {
+            goto *BASELabels[opcode];
+
+            Z80_BASE_OPCODES(Z80_OPCODE_LABEL)
+            Z80_CB_OPCODES(Z80_OPCODE_LABEL)
+            Z80_DD_OPCODES(Z80_OPCODE_LABEL)
+            Z80_ED_OPCODES(Z80_OPCODE_LABEL)
+            Z80_FD_OPCODES(Z80_OPCODE_LABEL)
+            Z80_DDCB_OPCODES(Z80_OPCODE_LABEL)
+            Z80_FDCB_OPCODES(Z80_OPCODE_LABEL)
         }
+opcodeDone:
+        ;
+#else
+        BASEHandlers[opcode](z);
+#endif
     }
+#if !defined(__GNUC__)
+instructionDone:
+#endif
+#if defined(Z80_PROFILER)
+    recordOpcodeProfile(z);
+#endif
+#if defined(Z80_TRACE)
+    if (z->traceOpen)
+        endTraceEntry(z);
+#endif
 
     if (z->interruptPending)
         z->interruptCounter += z->cycles;
@@ -1420,20 +2741,37 @@ emuint Z80_executeInstruction(Z80 z)
    with this function and the implementation within will do the rest */
 static void writeToMemory(Z80 z, emuint address, emubyte data)
 {
-    console_memWrite(z->ms, address, 0xFF & data);
+    /* write straight to the mapped page if there is one, else let the console handle it -
+       direct writes to pages holding cached code must throw that code away first */
+    emuint pageNumber = (address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1);
+    emubyte *page = z->writePages[pageNumber];
+    z->idleLoopClean = false;
+    if (page != NULL) {
+        if (z->ramCodePages & z->pageAliases[pageNumber])
+            invalidateRamCode(z, z->pageAliases[pageNumber]);
+        page[address & (CONSOLE_PAGE_SIZE - 1)] = 0xFF & data;
+    } else {
+        console_memWrite(z->ms, address, 0xFF & data);
+    }
 }
 
 /* this function hides the details, meaning the Z80 internals can just read from memory addresses
  with this function and the implementation within will do the rest */
 static emubyte readFromMemory(Z80 z, emuint address)
 {
-    return 0xFF & console_memRead(z->ms, address);
+    /* read straight from the mapped page if there is one, else let the console handle it */
+    emubyte *page = z->readPages[(address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)];
+    if (page != NULL)
+        return page[address & (CONSOLE_PAGE_SIZE - 1)];
+    else
+        return 0xFF & console_memRead(z->ms, address);
 }
 
 /* this function hides the details, meaning the Z80 internals can just write to I/O addresses
    with this function and the implementation within will do the rest */
 static void writeToIO(Z80 z, emuint address, emubyte data)
 {
+    z->idleLoopClean = false;
     console_ioWrite(z->ms, address, 0xFF & data);
 }
 
@@ -1441,61 +2779,16 @@ static void writeToIO(Z80 z, emuint address, emubyte data)
    with this function and the implementation within will do the rest */
 static emubyte readFromIO(Z80 z, emuint address)
 {
-    return 0xFF & console_ioRead(z->ms, address);
-}
-
-/* this function sets or resets the S flag */
-static void setSFlag(Z80 z, emubool value)
-{
-    if (value)
-        z->regF = 0xFF & (z->regF | 0x80);
-    else
-        z->regF = z->regF & 0x7F;
-}
-
-/* this function sets or resets the Z flag */
-static void setZFlag(Z80 z, emubool value)
-{
-    if (value)
-        z->regF = 0xFF & (z->regF | 0x40);
-    else
-        z->regF = z->regF & 0xBF;
-}
-
-/* this function sets or resets the H flag */
-static void setHFlag(Z80 z, emubool value)
-{
-    if (value)
-        z->regF = 0xFF & (z->regF | 0x10);
-    else
-        z->regF = z->regF & 0xEF;
-}
-
-/* this function sets or resets the P/V flag */
-static void setPVFlag(Z80 z, emubool value)
-{
-    if (value)
-        z->regF = 0xFF & (z->regF | 0x04);
-    else
-        z->regF = z->regF & 0xFB;
-}
+    /* define variables */
+    emubyte data = 0xFF & console_ioRead(z->ms, address);
 
-/* this function sets or resets the N flag */
-static void setNFlag(Z80 z, emubool value)
-{
-    if (value)
-        z->regF = 0xFF & (z->regF | 0x02);
+    /* note down reads from ports an idle loop can poll, anything else spoils the pass */
+    if (console_isIdlePollPort(z->ms, address) && z->thisPass.pollCount < Z80_IDLE_POLL_COUNT)
+        z->thisPass.polls[z->thisPass.pollCount++] = ((address & 0xFF) << 8) | data;
     else
-        z->regF = z->regF & 0xFD;
-}
+        z->idleLoopClean = false;
 
-/* this function sets or resets the C flag */
-static void setCFlag(Z80 z, emubool value)
-{
-    if (value)
-        z->regF = 0xFF & (z->regF | 0x01);
-    else
-        z->regF = z->regF & 0xFE;
+    return data;
 }
 
 /* this function writes a new value to the program counter */
@@ -1526,182 +2819,537 @@ static void decrementProgramCounter(Z80 z)
     z->regPC = 0xFFFF & tempPC;
 }
 
+/* this function reads the opcode byte at the program counter and moves past it */
+static emubyte fetchOpcode(Z80 z)
+{
+    emubyte opcode = readFromMemory(z, readProgramCounter(z));
+    incrementProgramCounter(z);
+    return opcode;
+}
+
+/* this function reads the operand byte at the program counter and moves past it - an
+   instruction from the block cache already has its operands decoded, so they are taken
+   from there, and anything beyond them is read from memory as normal */
+static inline emubyte fetchOperand(Z80 z)
+{
+    /* define variables */
+    emubyte operand;
+
+    if (z->operandCount != 0) {
+        operand = *z->operands++;
+        --z->operandCount;
+    } else {
+        operand = readFromMemory(z, readProgramCounter(z));
+    }
+    incrementProgramCounter(z);
+
+    return operand;
+}
+
+/* this function reads the displacement of a DDCB or FDCB instruction, which comes before
+   its opcode - the block cache decodes it as the only operand of such instructions */
+static emubyte readIndexedCbDisplacement(Z80 z)
+{
+    if (z->operandCount != 0)
+        return z->operands[0];
+    else
+        return readFromMemory(z, readProgramCounter(z) - 2);
+}
+
 /* this increments the low seven bits of the refresh register */
 static void incrementRefreshRegister(Z80 z)
 {
+#if defined(FAST_PROFILE)
+    (void)z;
+#else
     emubyte temp = 0x7F & z->regR;
     ++temp;
     if (temp > 127)
         temp = 0;
     z->regR = (z->regR & 0x80) | (temp & 0x7F);
+#endif
 }
 
-/* this function writes a new value to the stack pointer */
-static void writeStackPointer(Z80 z, emuint address)
+/* this returns the value of the refresh register - in the fast profile the low seven bits
+   advance once per four cycles run, which is roughly one per opcode fetch */
+static emubyte readRefreshRegister(Z80 z)
 {
-    z->regSP = 0xFFFF & address;
+#if defined(FAST_PROFILE)
+    emuint elapsed = (z->refreshCycles + z->runCycles + z->cycles) >> 2;
+    return (z->regR & 0x80) | ((z->regR + elapsed) & 0x7F);
+#else
+    return z->regR;
+#endif
 }
 
-/* this function reads the stack pointer */
-static emuint readStackPointer(Z80 z)
+/* this sets the value of the refresh register, as it will be read back straight away */
+static void writeRefreshRegister(Z80 z, emubyte value)
 {
-    return 0xFFFF & z->regSP;
+#if defined(FAST_PROFILE)
+    emuint elapsed = (z->refreshCycles + z->runCycles + z->cycles) >> 2;
+    z->regR = (value & 0x80) | ((value - elapsed) & 0x7F);
+#else
+    z->regR = value;
+#endif
 }
 
-/* this function increments the stack pointer by one */
-static void incrementStackPointer(Z80 z)
+/* this function returns whether the specified address can be read without going through the console */
+static emubool isDirectRead(Z80 z, emuint address)
 {
-    z->regSP = 0xFFFF & (z->regSP + 1);
+    return z->readPages[(address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)] != NULL;
 }
 
-/* this function decrements the stack pointer by one */
-static void decrementStackPointer(Z80 z)
+/* this function returns whether the specified address can be written without going through the console */
+static emubool isDirectWrite(Z80 z, emuint address)
 {
-    z->regSP = 0xFFFF & (z->regSP - 1);
+    return z->writePages[(address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)] != NULL;
 }
 
-/* this function calculates the parity of the result passed in and
-sets the P/V flag accordingly */
-static void calculatePVFlag(Z80 z, emubyte temp)
+/* this function is called by the repeating block instructions once an iteration has finished
+   and rewound the program counter, and decides whether the next iteration can be run straight
+   away - it does the work that Z80_run and Z80_executeInstruction would have done in between,
+   so cycle counts, the refresh register and interrupt timing come out exactly the same, and
+   returns false (leaving the next iteration to the normal fetch) if the cycle budget for this
+   run is used up, an interrupt needs servicing or the instruction is no longer in memory */
+static emubool repeatBlockInstruction(Z80 z, emubyte opcode)
 {
-    emubyte parityCheck = 0xFF & temp;
-    emubyte parityCount = 0;
-    emubyte i;
-    for (i = 0; i < 8; ++i) {
-        parityCount = parityCount + (parityCheck & 0x01);
-        parityCheck = parityCheck >> 1;
+    /* define variables */
+    emuint address = readProgramCounter(z);
+    emuint runCycles = z->runCycles + z->cycles;
+    emubyte *firstPage = z->readPages[(address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)];
+    emubyte *secondPage = z->readPages[(((address + 1) & 0xFFFF) >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)];
+
+    /* the next iteration must fit in the current run */
+    if (runCycles >= z->runTarget)
+        return false;
+
+    /* the instruction must still be there to fetch again, which could have changed
+       if the last iteration wrote over it */
+    if (firstPage == NULL || secondPage == NULL ||
+        firstPage[address & (CONSOLE_PAGE_SIZE - 1)] != 0xED ||
+        secondPage[(address + 1) & (CONSOLE_PAGE_SIZE - 1)] != opcode)
+        return false;
+
+    /* finish the last iteration off as a separate instruction */
+#if defined(Z80_PROFILER)
+    recordOpcodeProfile(z);
+#endif
+#if defined(Z80_TRACE)
+    if (z->traceOpen)
+        endTraceEntry(z);
+#endif
+    if (z->interruptPending)
+        z->interruptCounter += z->cycles;
+    z->runCycles = runCycles;
+    z->cycles = 0;
+
+    /* check for interrupts as at the start of any instruction - if one needs servicing
+       we return with no cycles used, and the next call to Z80_executeInstruction takes it */
+    if (z->nmi)
+        return false;
+    if ((z->interruptPending = z->interruptLine) && (z->iff1) && z->interruptCounter > 100)
+        return false;
+
+    /* fetch the instruction again */
+#if defined(Z80_TRACE)
+    if (z->traceEnabled)
+        beginTraceEntry(z);
+#endif
+    writeProgramCounter(z, address + 2);
+    incrementRefreshRegister(z);
+
+    return true;
+}
+
+/* this function finds the pre-decoded version of the instruction at the program counter,
+   decoding it into the block cache if needed - it carries on through the current block
+   while the instructions run in the order they were decoded (or extends the block if it
+   has reached the end of it), and otherwise starts a block at the program counter - NULL
+   is returned if the instruction can't come from the cache, and must be fetched as normal */
+static struct DecodedInstruction *findDecodedInstruction(Z80 z)
+{
+    /* define variables */
+    emuint address = readProgramCounter(z);
+    emubyte *page = z->readPages[(address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)];
+    emuint offset = address & (CONSOLE_PAGE_SIZE - 1);
+    struct DecodedBlock *block = z->currentBlock;
+    struct DecodedInstruction *decoded = NULL;
+    uintptr_t key;
+
+    /* code in pages that need special handling always goes through the normal fetch */
+    if (page == NULL)
+        return NULL;
+
+    /* carry on through the current block if possible */
+    if (block != NULL && block->page == page && isBlockValid(z, block)) {
+        if (z->blockPosition < block->count) {
+            decoded = &block->instructions[z->blockPosition];
+            if (decoded->offset == offset) {
+                ++z->blockPosition;
+                return decoded;
+            }
+        } else if (z->blockPosition < Z80_BLOCK_LENGTH) {
+            decoded = &block->instructions[z->blockPosition];
+            if (decodeInstruction(page, offset, decoded)) {
+                ++block->count;
+                ++z->blockPosition;
+                return decoded;
+            }
+        }
     }
-    if (parityCount % 2 == 0)
-        setPVFlag(z, true);
-    else
-        setPVFlag(z, false);
+
+    /* otherwise look for a block starting here, and decode one if there isn't */
+    key = (uintptr_t)(page + offset);
+    block = &z->blocks[(key ^ (key >> 10)) & (Z80_BLOCK_COUNT - 1)];
+    if (block->page != page || block->count == 0 || block->instructions[0].offset != offset || !isBlockValid(z, block)) {
+        block->page = page;
+        block->count = 0;
+        if (!decodeInstruction(page, offset, &block->instructions[0])) {
+            block->page = NULL;
+            z->currentBlock = NULL;
+            return NULL;
+        }
+        block->count = 1;
+
+        /* ROM can also be found in the upper half of the address space, but we treat all
+           code from there as if it came from RAM, along with code from any page the Z80
+           can write to directly - updateCodePages works out which pages these are */
+        block->pageNumber = (address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1);
+        block->isRam = (z->ramPages >> block->pageNumber) & 1;
+        block->generation = z->pageGenerations[block->pageNumber];
+        if (block->isRam)
+            z->ramCodePages |= (uint64_t)1 << block->pageNumber;
+    }
+    z->currentBlock = block;
+    z->blockPosition = 1;
+
+    return &block->instructions[0];
 }
 
-/* this function checks if result passed in is zero and sets the Z flag accordingly */
-static void calculateZFlag(Z80 z, emubyte temp)
+/* this function decodes the instruction at the specified offset of a page, returning false
+   if its prefix and opcode bytes run off the end of the page */
+static emubool decodeInstruction(emubyte *page, emuint offset, struct DecodedInstruction *decoded)
 {
-    if ((temp & 0xFF) == 0)
-        setZFlag(z, true);
-    else
-        setZFlag(z, false);
+    /* define variables */
+    emubyte *code = page + offset;
+    emuint room = CONSOLE_PAGE_SIZE - offset;
+    emuint i;
+
+    /* work out which table the handler lives in, mirroring the prefix handling of
+       the opcode tables - DDCB and FDCB instructions have the displacement byte
+       before the opcode */
+    decoded->handler = NULL;
+    decoded->offset = offset;
+    switch (code[0]) {
+        case 0xCB: decoded->table = CB_TABLE; decoded->length = 2; break;
+        case 0xED: decoded->table = ED_TABLE; decoded->length = 2; break;
+        case 0xDD:
+            if (room >= 2 && code[1] == 0xCB) {
+                decoded->table = DDCB_TABLE;
+                decoded->length = 4;
+            } else {
+                decoded->table = DD_TABLE;
+                decoded->length = 2;
+            }
+            break;
+        case 0xFD:
+            if (room >= 2 && code[1] == 0xCB) {
+                decoded->table = FDCB_TABLE;
+                decoded->length = 4;
+            } else {
+                decoded->table = FD_TABLE;
+                decoded->length = 2;
+            }
+            break;
+        default: decoded->table = BASE_TABLE; decoded->length = 1; break;
+    }
+    if (decoded->length > room)
+        return false;
+    decoded->opcode = code[decoded->length - 1];
+
+    /* copy out the operand bytes that are in the same page - any that aren't are left to
+       be read from memory when the handler fetches them */
+    switch (decoded->table) {
+        case BASE_TABLE: decoded->operandCount = baseOperandCounts[decoded->opcode]; break;
+        case ED_TABLE: decoded->operandCount = edOperandCounts[decoded->opcode]; break;
+        case DD_TABLE:
+        case FD_TABLE: decoded->operandCount = indexOperandCounts[decoded->opcode]; break;
+        case DDCB_TABLE:
+        case FDCB_TABLE:
+            decoded->operandCount = 1;
+            decoded->operands[0] = code[2];
+            return true;
+        default: decoded->operandCount = 0; break;
+    }
+    if (decoded->operandCount > room - decoded->length)
+        decoded->operandCount = room - decoded->length;
+    for (i = 0; i < decoded->operandCount; ++i)
+        decoded->operands[i] = code[decoded->length + i];
+
+    return true;
 }
 
-/* this function checks if result passed in is negative and sets S flag accordingly */
-static void calculateSFlag(Z80 z, emubyte temp)
+/* this function checks that a block hasn't been thrown away */
+static emubool isBlockValid(Z80 z, struct DecodedBlock *block)
 {
-    if ((temp & 0x80) == 128)
-        setSFlag(z, true);
-    else
-        setSFlag(z, false);
+    return !block->isRam || block->generation == z->pageGenerations[block->pageNumber];
 }
 
-/* this function checks if a borrow has occurred from bit 4 (during subtraction) or
-   a carry from bit 3 (during addition) and sets the H flag accordingly */
-static void calculateHFlag(Z80 z, emubyte operand1, emubyte operand2, emuint result)
+/* this function throws away every RAM block decoded from the specified pages */
+static void invalidateRamCode(Z80 z, uint64_t pages)
 {
-    if ((((operand1 ^ operand2) ^ result) & 0x10) == 16)
-        setHFlag(z, true);
-    else
-        setHFlag(z, false);
+    /* define variables */
+    emuint i;
+
+    for (i = 0; i < CONSOLE_PAGE_COUNT; ++i) {
+        if ((pages >> i) & 1)
+            ++z->pageGenerations[i];
+    }
+    z->ramCodePages &= ~pages;
 }
 
-/* this function checks if a borrow has occurred from bit 8 (during subtraction) or
-   a carry from bit 7 (during addition) and sets the C flag accordingly */
-static void calculateCFlag(Z80 z, emubyte operand, emuint result)
+/* this function works out which pages hold code that counts as RAM, and which pages each
+   page shares its memory with - it compares every page with every other, so it only runs
+   when the memory map changes, and only with the block cache on */
+static void updateCodePages(Z80 z)
 {
-    if ((((z->regA ^ operand) ^ result) & 0x100) == 256)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* define variables */
+    emuint i, j;
+
+    z->ramPages = 0;
+    for (i = 0; i < CONSOLE_PAGE_COUNT; ++i) {
+        z->pageAliases[i] = (uint64_t)1 << i;
+        if (i >= CONSOLE_PAGE_COUNT / 2)
+            z->ramPages |= (uint64_t)1 << i;
+        for (j = 0; j < CONSOLE_PAGE_COUNT; ++j) {
+            if (z->readPages[j] != NULL && (z->readPages[j] == z->readPages[i] || z->readPages[j] == z->writePages[i]))
+                z->pageAliases[i] |= (uint64_t)1 << j;
+            if (z->writePages[j] != NULL && z->writePages[j] == z->readPages[i])
+                z->ramPages |= (uint64_t)1 << i;
+        }
+    }
 }
 
-/* this functions checks for overflow and sets the P/V flag if so, else resets it */
-static void calculatePVOverflow(Z80 z, emubyte operand, emuint result, calcType type)
+/* this function must be called whenever memory is written without going through the Z80,
+   so that any code cached from there is thrown away */
+void Z80_memoryWritten(Z80 z, emuint address)
 {
-    if (((z->regA ^ operand) & 0x80) == type) {
-        if (((z->regA ^ result) & 0x80) == 128)
-            setPVFlag(z, true);
-        else
-            setPVFlag(z, false);
-    } else {
-        setPVFlag(z, false);
+    /* define variables */
+    emuint pageNumber = (address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1);
+
+    if (z->ramCodePages & z->pageAliases[pageNumber])
+        invalidateRamCode(z, z->pageAliases[pageNumber]);
+}
+
+/* this function must be called whenever the memory map changes, as cached code from RAM
+   could now be somewhere else or have been replaced */
+void Z80_memoryMapChanged(Z80 z)
+{
+    invalidateRamCode(z, ~(uint64_t)0);
+    if (z->blockCache)
+        updateCodePages(z);
+}
+
+/* this function works out how many NOPs the Z80 would run in the HALT state, one per call
+   to Z80_executeInstruction, before either the current call to Z80_run ends or a maskable
+   interrupt is taken - interrupts can only be raised by the other devices when they catch up
+   between runs, so whether one is pending can't change in the meantime, and the only thing
+   that can end the HALT early is the interrupt counter passing its threshold */
+static emuint countHaltedNops(Z80 z)
+{
+    /* define variables */
+    emuint nops = 1, limit = 1;
+
+    /* fill the rest of the run if we're in one */
+    if (z->runCycles < z->runTarget)
+        nops = (z->runTarget - z->runCycles + 3) / 4;
+
+    /* stop at the NOP after which the pending interrupt would be taken */
+    if (z->interruptPending && z->iff1) {
+        if (z->interruptCounter <= 100)
+            limit = (100 - z->interruptCounter) / 4 + 1;
+        if (nops > limit)
+            nops = limit;
     }
+
+    return nops;
 }
 
-/* this function checks if the 16-bit result passed in is zero and sets the Z flag accordingly */
-static void calculateZFlag16(Z80 z, emuint temp)
+/* this function copies the registers into an idle loop pass record, along with the interrupt
+   state that decides whether the next pass could be interrupted */
+static void captureIdleLoopPass(Z80 z, struct IdleLoopPass *pass)
 {
-    if ((temp & 0xFFFF) == 0)
-        setZFlag(z, true);
-    else
-        setZFlag(z, false);
+    pass->registers[0] = (z->regA << 8) | z->regF;
+    pass->registers[1] = z->regBC;
+    pass->registers[2] = z->regDE;
+    pass->registers[3] = z->regHL;
+    pass->registers[4] = (z->regAShadow << 8) | z->regFShadow;
+    pass->registers[5] = z->regBCShadow;
+    pass->registers[6] = z->regDEShadow;
+    pass->registers[7] = z->regHLShadow;
+    pass->registers[8] = z->regIX;
+    pass->registers[9] = z->regIY;
+    pass->registers[10] = z->regSP;
+    pass->registers[11] = (z->regI << 8) | (z->regR & 0x80);
+    pass->registers[12] = (z->iff1 << 8) | (z->iff2 << 4) | z->intMode;
+    pass->registers[13] = (z->interruptPending << 8) | (z->followingInstruction << 4) | z->halt;
 }
 
-/* this function checks if the 16-bit result passed in is negative and sets S flag accordingly */
-static void calculateSFlag16(Z80 z, emuint temp)
+/* this function returns whether two idle loop passes ended with the same registers and
+   read the same values from the same ports in the same order */
+static emubool isSameIdleLoopPass(struct IdleLoopPass *first, struct IdleLoopPass *second)
 {
-    if ((temp & 0x8000) == 32768)
-        setSFlag(z, true);
-    else
-        setSFlag(z, false);
+    if (first->pollCount != second->pollCount)
+        return false;
+    if (memcmp((void *)first->registers, (void *)second->registers, sizeof(first->registers)) != 0)
+        return false;
+    return memcmp((void *)first->polls, (void *)second->polls, first->pollCount * sizeof(emuint)) == 0;
 }
 
-/* this function checks if a borrow has occurred from bit 12 (during subtraction) or
-   a carry from bit 11 (during addition) and sets the H flag accordingly */
-static void calculateHFlag16(Z80 z, emuint tempHL, emuint operand, emuint result)
+/* this function is called by jumps that go backwards, and skips through idle loops - those
+   that do nothing but poll the VDP V counter or status port while waiting for a new line or
+   frame - both of those can only change when the VDP processes a line, which only happens
+   between runs (a status read clears the status, but reading it again straight away returns
+   the same cleared value every time), so once a pass round a loop has written nothing, ended
+   with the registers as they were at the end of the pass before, and read the same values as
+   that pass did, every other pass this run will be the same too - all the whole passes that
+   fit in the rest of the run are then done in one go by adding up their cycles and refresh
+   register increments, and the loop runs out the remainder of the run as normal */
+static void checkIdleLoop(Z80 z, emuint target)
 {
-    if ((((tempHL ^ operand) ^ result) & 0x1000) == 4096)
-        setHFlag(z, true);
+    /* define variables */
+    emuint now = z->runCycles + z->cycles;
+    emuint passCycles = 0, passRefresh = 0, passes = 0;
+
+    /* loops can only be skipped through inside a run */
+    if (now >= z->runTarget) {
+        z->idleLoopTarget = Z80_NO_IDLE_LOOP;
+        return;
+    }
+
+    /* count passes round the same loop - the first one in a run may have started in the last run */
+    if (target == z->idleLoopTarget)
+        ++z->idleLoopPasses;
     else
-        setHFlag(z, false);
+        z->idleLoopPasses = 0;
+    captureIdleLoopPass(z, &z->thisPass);
+
+    /* skip the rest of the run if this pass matches the one before, as long as an
+       interrupt isn't waiting to end the loop early */
+    if (z->idleLoopPasses >= 2 && z->idleLoopClean && !z->nmi && !(z->interruptPending && z->iff1) &&
+        isSameIdleLoopPass(&z->thisPass, &z->lastPass)) {
+        passCycles = now - z->idleLoopCycles;
+        passRefresh = (z->regR - z->idleLoopRefresh) & 0x7F;
+        passes = (z->runTarget - now) / passCycles;
+        z->cycles += passes * passCycles;
+        z->regR = (z->regR & 0x80) | ((z->regR + passes * passRefresh) & 0x7F);
+        now += passes * passCycles;
+    }
+
+    /* start the next pass */
+    z->idleLoopTarget = target;
+    z->idleLoopCycles = now;
+    z->idleLoopRefresh = z->regR;
+    z->idleLoopClean = true;
+    z->lastPass = z->thisPass;
+    z->thisPass.pollCount = 0;
 }
 
-/* this function checks if a borrow has occurred from bit 16 (during subtraction) or
-   a carry from bit 15 (during addition) and sets the C flag accordingly */
-static void calculateCFlag16(Z80 z, emuint tempHL, emuint operand, emuint result)
+/* this function writes a new value to the stack pointer */
+static void writeStackPointer(Z80 z, emuint address)
 {
-    if ((((tempHL ^ operand) ^ result) & 0x10000) == 65536)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    z->regSP = 0xFFFF & address;
 }
 
-/* this functions checks for 16-bit overflow and sets the P/V flag if so, else resets it */
-static void calculatePVOverflow16(Z80 z, emuint tempHL, emuint operand, emuint result, calcType type)
+/* this function reads the stack pointer */
+static emuint readStackPointer(Z80 z)
 {
-    if (((tempHL ^ operand) & 0x8000) == type) {
-        if (((tempHL ^ result) & 0x8000) == 32768)
-            setPVFlag(z, true);
-        else
-            setPVFlag(z, false);
-    } else {
-        setPVFlag(z, false);
-    }
+    return 0xFFFF & z->regSP;
 }
 
+/* this function increments the stack pointer by one */
+static void incrementStackPointer(Z80 z)
+{
+    z->regSP = 0xFFFF & (z->regSP + 1);
+}
 
-/* this function emulates the NOP instruction */
-static void NOP(Z80 z)
+/* this function decrements the stack pointer by one */
+static void decrementStackPointer(Z80 z)
 {
-    z->cycles = 4;
+    z->regSP = 0xFFFF & (z->regSP - 1);
 }
 
-/* this function emulates the DAA instruction - it was written using Sean Young's
-   reverse engineered information, which is largely undocumented by Zilog */
-static void DAA(Z80 z)
+
+/* this function fills in the flag lookup tables used by the ALU instructions - the
+   tables are shared between Z80 objects, so the work is only done the first time */
+static void initialiseFlagTables(void)
 {
-    /* import relevant flags */
-    emubool cFlag = false, nFlag = false, hFlag = false;
-    if ((z->regF & 0x01) == 1)
-        cFlag = true;
-    if ((z->regF & 0x02) == 2)
-        nFlag = true;
-    if ((z->regF & 0x10) == 16)
-        hFlag = true;
+    /* define variables */
+    emuint a, b, carry, result, i;
+    emubyte parityCount;
+
+    /* only fill the tables once */
+    if (flagTablesReady)
+        return;
+
+    /* deal with the tables indexed by a single byte value */
+    for (a = 0; a < 256; ++a) {
+        /* S and Z come straight from the value, and P/V is set for even parity */
+        parityCount = 0;
+        for (i = 0; i < 8; ++i)
+            parityCount += (a >> i) & 0x01;
+        szpFlags[a] = (a & 0x80) | (a == 0 ? 0x40 : 0) | (parityCount % 2 == 0 ? 0x04 : 0);
+
+        /* INC sets P/V when incrementing 0x7F, DEC sets it when decrementing 0x80,
+           and both work out H from the carry or borrow into bit 4 */
+        result = 0xFF & (a + 1);
+        incFlags[a] = (result & 0x80) | (result == 0 ? 0x40 : 0) |
+                      ((a ^ 0x01 ^ result) & 0x10) | (a == 0x7F ? 0x04 : 0);
+        result = 0xFF & (a - 1);
+        decFlags[a] = (result & 0x80) | (result == 0 ? 0x40 : 0) |
+                      ((a ^ 0x01 ^ result) & 0x10) | (a == 0x80 ? 0x04 : 0) | 0x02;
+
+        /* BIT always sets H, sets Z and P/V if the tested bit is clear, and sets S if
+           the tested bit is bit 7 and it is set (the P/V and S behaviour is undocumented) */
+        bitFlags[a] = 0x10 | (a == 0 ? 0x44 : 0) | (a == 0x80 ? 0x80 : 0);
+    }
+
+    /* deal with 8-bit addition and subtraction, with and without carry - H is set on
+       a carry or borrow into bit 4, C on a carry or borrow into bit 8, and P/V on overflow */
+    for (carry = 0; carry < 2; ++carry) {
+        for (a = 0; a < 256; ++a) {
+            for (b = 0; b < 256; ++b) {
+                result = a + b + carry;
+                addFlags[carry][a][b] = (result & 0x80) | ((result & 0xFF) == 0 ? 0x40 : 0) |
+                                        ((a ^ b ^ result) & 0x10) |
+                                        ((~(a ^ b) & (a ^ result) & 0x80) ? 0x04 : 0) |
+                                        (((a ^ b ^ result) & 0x100) ? 0x01 : 0);
+                result = a - b - carry;
+                subFlags[carry][a][b] = (result & 0x80) | ((result & 0xFF) == 0 ? 0x40 : 0) |
+                                        ((a ^ b ^ result) & 0x10) |
+                                        (((a ^ b) & (a ^ result) & 0x80) ? 0x04 : 0) | 0x02 |
+                                        (((a ^ b ^ result) & 0x100) ? 0x01 : 0);
+            }
+        }
+    }
 
+    /* deal with DAA for every combination of accumulator, C, H and N */
+    for (i = 0; i < 2048; ++i)
+        daaValues[i] = calculateDAA(i & 0xFF, (i & 0x100) != 0, (i & 0x200) != 0, (i & 0x400) != 0);
+
+    flagTablesReady = true;
+}
+
+/* this function works out the result of the DAA instruction for the supplied accumulator
+   and flags, returning the new accumulator in the high byte and new reg F in the low byte -
+   it was written using Sean Young's reverse engineered information, which is largely
+   undocumented by Zilog */
+static emuint calculateDAA(emubyte a, emubool cFlag, emubool hFlag, emubool nFlag)
+{
     /* import high and low nibbles from accumulator */
-    emubyte highNibble = 0x0F & (z->regA >> 4);
-    emubyte lowNibble = 0x0F & z->regA;
+    emubyte highNibble = 0x0F & (a >> 4);
+    emubyte lowNibble = 0x0F & a;
+    emubyte flags = 0;
 
     /* test flag and accumulator and make necessary adjustment */
     emubyte modification = 0;
@@ -1780,25 +3428,38 @@ static void DAA(Z80 z)
 
     /* perform calculation */
     if (nFlag)
-        z->regA = 0xFF & (z->regA - modification);
+        a = 0xFF & (a - modification);
     else
-        z->regA = 0xFF & (z->regA + modification);
-
-    /* set C and H flags accordingly */
-    setCFlag(z, newCFlag);
-    setHFlag(z, newHFlag);
-
-    /* calculate S flag */
-    calculateSFlag(z, z->regA);
+        a = 0xFF & (a + modification);
+
+    /* set S, Z and P/V flags from the result, copy its bits 5 and 3 to their respective
+       places in reg F, then add C and H flags and leave N as it was */
+    flags = szpFlags[a] | (Z80_KEEP_FLAGS(0x28) & a);
+    if (newCFlag)
+        flags |= 0x01;
+    if (newHFlag)
+        flags |= 0x10;
+    if (nFlag)
+        flags |= 0x02;
 
-    /* copy bits 5 and 3 to their respective places in reg F */
-    z->regF = (0xD7 & z->regF) | (0x28 & z->regA);
+    return (a << 8) | flags;
+}
 
-    /* set Z flag accordingly */
-    calculateZFlag(z, z->regA);
+/* this function emulates the NOP instruction */
+static void NOP(Z80 z)
+{
+    z->cycles = 4;
+}
 
-    /* calculate parity of result and set P/V flag accordingly */
-    calculatePVFlag(z, z->regA);
+/* this function emulates the DAA instruction, using a lookup table indexed by
+   the N, H and C flags and the accumulator */
+static void DAA(Z80 z)
+{
+    /* look up the adjusted accumulator and the new flags */
+    emuint result = daaValues[((z->regF & 0x02) << 9) | ((z->regF & 0x10) << 5) |
+                              ((z->regF & 0x01) << 8) | z->regA];
+    z->regA = 0xFF & (result >> 8);
+    z->regF = 0xFF & result;
 
     /* set number of cycles */
     z->cycles = 4;
@@ -1840,7 +3501,7 @@ static void HALT(Z80 z)
 }
 
 /* this function emulates instructions IM0, IM1 and IM2 */
-static void IM(Z80 z, emubyte mode)
+Z80_SPECIALISED void IM(Z80 z, emubyte mode)
 {
     /* set interrupt mode */
     z->intMode = mode;
@@ -1850,7 +3511,7 @@ static void IM(Z80 z, emubyte mode)
 }
 
 /* this function emulates all of the XOR instructions */
-static void XOR(Z80 z, cpuVal value)
+Z80_SPECIALISED void XOR(Z80 z, cpuVal value)
 {
     /* obtain relevant value and set cycle count */
     emubyte temp = 0, result = 0;
@@ -1867,17 +3528,14 @@ static void XOR(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
         default: break;
@@ -1886,22 +3544,15 @@ static void XOR(Z80 z, cpuVal value)
     /* do logical XOR between values */
     result = z->regA ^ temp;
 
-    /* calculate S, Z and P/V flags */
-    calculateSFlag(z, result);
-    calculateZFlag(z, result);
-    calculatePVFlag(z, result);
-
-    /* reset H, N and C flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    setCFlag(z, false);
+    /* calculate S, Z and P/V flags, and reset H, N and C flags */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[result];
 
     /* store result back to accumulator */
     z->regA = 0xFF & result;
 }
 
 /* this function emulates all of the BIT instructions */
-static void BIT(Z80 z, emubyte bit, cpuVal value)
+Z80_SPECIALISED void BIT(Z80 z, emubyte bit, cpuVal value)
 {
     /* get relevant value and set cycle count */
     emubyte temp = 0;
@@ -1915,32 +3566,25 @@ static void BIT(Z80 z, emubyte bit, cpuVal value)
         case E: temp = z->regE; z->cycles = 8; break;
         case H: temp = z->regH; z->cycles = 8; break;
         case L: temp = z->regL; z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 12; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 20; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 20; break;
         default: break;
     }
     
-    /* check relevant bit and set Z flag if unset, else reset it */
-    temp &= bitToTest;
-    calculateZFlag(z, temp);
-    if (temp == 0)
-        setPVFlag(z, true); /* this is undocumented */
-    else if (bit == 7)
-        setSFlag(z, true); /* this is undocumented */
-
-    /* deal with other flags */
-    setHFlag(z, true);
-    setNFlag(z, false);
+    /* check relevant bit and set Z flag if unset, else reset it - P/V is also set if
+       the bit is unset, and S is set if the bit is bit 7 and set (both undocumented),
+       while H is set and N is reset */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xAD)) | bitFlags[temp & bitToTest];
 }
 
 /* this function emulates all of the RST instructions */
-static void RST(Z80 z, emubyte vector)
+Z80_SPECIALISED void RST(Z80 z, emubyte vector)
 {
     /* push PC value onto stack */
     emubyte low = readProgramCounter(z) & 0xFF;
@@ -1960,35 +3604,26 @@ static void RST(Z80 z, emubyte vector)
 /* this function emulates the EXX instruction */
 static void EXX(Z80 z)
 {
-    /* define temporary variables */
-    emubyte tempHigh, tempLow;
-    
-    /* use temporary variables to swap registers and shadow registers around */
-    tempHigh = z->regB;
-    tempLow = z->regC;
-    z->regB = z->regBShadow;
-    z->regC = z->regCShadow;
-    z->regBShadow = tempHigh;
-    z->regCShadow = tempLow;
-    tempHigh = z->regD;
-    tempLow = z->regE;
-    z->regD = z->regDShadow;
-    z->regE = z->regEShadow;
-    z->regDShadow = tempHigh;
-    z->regEShadow = tempLow;
-    tempHigh = z->regH;
-    tempLow = z->regL;
-    z->regH = z->regHShadow;
-    z->regL = z->regLShadow;
-    z->regHShadow = tempHigh;
-    z->regLShadow = tempLow;
+    /* define temporary variable */
+    emuint temp;
+    
+    /* use temporary variable to swap register pairs and shadow register pairs around */
+    temp = z->regBC;
+    z->regBC = z->regBCShadow;
+    z->regBCShadow = temp;
+    temp = z->regDE;
+    z->regDE = z->regDEShadow;
+    z->regDEShadow = temp;
+    temp = z->regHL;
+    z->regHL = z->regHLShadow;
+    z->regHLShadow = temp;
     
     /* set number of cycles */
     z->cycles = 4;
 }
 
 /* this function emulates all of the SET instructions */
-static void SET(Z80 z, emubyte bit, cpuVal value)
+Z80_SPECIALISED void SET(Z80 z, emubyte bit, cpuVal value)
 {
     /* get relevant value and set cycle count */
     emubyte temp = 0;
@@ -2002,12 +3637,12 @@ static void SET(Z80 z, emubyte bit, cpuVal value)
         case E: temp = z->regE; z->cycles = 8; break;
         case H: temp = z->regH; z->cycles = 8; break;
         case L: temp = z->regL; z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
@@ -2025,7 +3660,7 @@ static void SET(Z80 z, emubyte bit, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -2034,7 +3669,7 @@ static void SET(Z80 z, emubyte bit, cpuVal value)
 }
 
 /* this function emulates all of the RES instructions */
-static void RES(Z80 z, emubyte bit, cpuVal value)
+Z80_SPECIALISED void RES(Z80 z, emubyte bit, cpuVal value)
 {
     /* get relevant value and set cycle count */
     emubyte temp = 0;
@@ -2048,12 +3683,12 @@ static void RES(Z80 z, emubyte bit, cpuVal value)
         case E: temp = z->regE; z->cycles = 8; break;
         case H: temp = z->regH; z->cycles = 8; break;
         case L: temp = z->regL; z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
@@ -2072,7 +3707,7 @@ static void RES(Z80 z, emubyte bit, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -2081,7 +3716,7 @@ static void RES(Z80 z, emubyte bit, cpuVal value)
 }
 
 /* this function emulates all of the 8-bit LD instructions */
-static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
+Z80_SPECIALISED void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
 {
     /* define variables */
     emubyte temp = 0, low = 0, high = 0;
@@ -2090,8 +3725,7 @@ static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
     /* gather 'd' now if needed, as it is easier */
     if (destination == IXd || destination == IYd ||
         source == IXd || source == IYd) {
-        d = readFromMemory(z, readProgramCounter(z));
-        incrementProgramCounter(z);
+        d = fetchOperand(z);
     }
 
     /* retrieve value */
@@ -2104,25 +3738,22 @@ static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
         case H: temp = z->regH; break;
         case L: temp = z->regL; break;
         case I: temp = z->regI; break;
-        case R: temp = z->regR; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                       incrementProgramCounter(z); break;
+        case R: temp = readRefreshRegister(z); break;
+        case n: temp = fetchOperand(z); break;
         case IXh: temp = 0xFF & (z->regIX >> 8); break;
         case IXl: temp = 0xFF & z->regIX; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); break;
         case IYl: temp = 0xFF & z->regIY; break;
-        case aBC: temp = readFromMemory(z, 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF)));
+        case aBC: temp = readFromMemory(z, z->regBC);
                  break;
-        case aDE: temp = readFromMemory(z, 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF)));
+        case aDE: temp = readFromMemory(z, z->regDE);
                  break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                  break;
         case IXd: temp = readFromMemory(z, 0xFFFF & (z->regIX + d)); break;
         case IYd: temp = readFromMemory(z, 0xFFFF & (z->regIY + d)); break;
-        case a_nn: low = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
-                   high = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
+        case a_nn: low = fetchOperand(z);
+                   high = fetchOperand(z);
                    temp = readFromMemory(z, 0xFFFF & ((high << 8) | (low & 0xFF)));
                    break;
         default: break;
@@ -2130,16 +3761,11 @@ static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
 
     /* test for case of reg I or R, and deal with flags if so */
     if (source == I || source == R) {
-        calculateSFlag(z, temp);
-        calculateZFlag(z, temp);
-        setHFlag(z, false);
+        z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | (szpFlags[temp] & 0xC0);
         if (z->iff2 == 1)
-            setPVFlag(z, true);
-        else
-            setPVFlag(z, false);
-        setNFlag(z, false);
-        if (console_checkInterrupt(z->ms) || z->nmi == 1)
-            setPVFlag(z, false);
+            z->regF |= 0x04;
+        if (z->interruptLine || z->nmi == 1)
+            z->regF &= 0xFB;
     }
 
     /* store value */
@@ -2152,23 +3778,21 @@ static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
         case I: z->regI = temp; break;
-        case R: z->regR = temp; break;
+        case R: writeRefreshRegister(z, temp); break;
         case IXh: z->regIX = 0xFFFF & ((temp << 8) | (z->regIX & 0xFF)); break;
         case IXl: z->regIX = 0xFFFF & ((z->regIX & 0xFF00) | (temp & 0xFF)); break;
         case IYh: z->regIY = 0xFFFF & ((temp << 8) | (z->regIY & 0xFF)); break;
         case IYl: z->regIY = 0xFFFF & ((z->regIY & 0xFF00) | (temp & 0xFF)); break;
-        case aBC: writeToMemory(z, 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF)), temp);
+        case aBC: writeToMemory(z, z->regBC, temp);
                   break;
-        case aDE: writeToMemory(z, 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF)), temp);
+        case aDE: writeToMemory(z, z->regDE, temp);
                   break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
-        case a_nn: low = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
-                   high = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
+        case a_nn: low = fetchOperand(z);
+                   high = fetchOperand(z);
                    writeToMemory(z, 0xFFFF & ((high << 8) | (low & 0xFF)), temp);
                    break;
         default: break;
@@ -2197,7 +3821,7 @@ static void LD_8Bit(Z80 z, cpuVal destination, cpuVal source)
 }
 
 /* this function emulates all of the 16-bit LD instructions */
-static void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer)
+Z80_SPECIALISED void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer)
 {
     /* define variables */
     emubyte low = 0, high = 0;
@@ -2205,21 +3829,17 @@ static void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer)
 
     /* retrieve value */
     switch (source) {
-        case BC: temp = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF)); break;
-        case DE: temp = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF)); break;
-        case HL: temp = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)); break;
+        case BC: temp = z->regBC; break;
+        case DE: temp = z->regDE; break;
+        case HL: temp = z->regHL; break;
         case IX: temp = z->regIX; break;
         case IY: temp = z->regIY; break;
         case SP: temp = z->regSP; break;
-        case nn: low = readFromMemory(z, readProgramCounter(z));
-                 incrementProgramCounter(z);
-                 high = readFromMemory(z, readProgramCounter(z));
-                 incrementProgramCounter(z);
+        case nn: low = fetchOperand(z);
+                 high = fetchOperand(z);
                  temp = 0xFFFF & ((high << 8) | (low & 0xFF)); break;
-        case a_nn: low = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
-                   high = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
+        case a_nn: low = fetchOperand(z);
+                   high = fetchOperand(z);
                    address = 0xFFFF & ((high << 8) | (low & 0xFF));
                    temp = readFromMemory(z, address);
                    address = 0xFFFF & (address + 1);
@@ -2230,19 +3850,14 @@ static void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer)
 
     /* store value */
     switch (destination) {
-        case BC: z->regB = 0xFF & (temp >> 8);
-                 z->regC = 0xFF & temp; break;
-        case DE: z->regD = 0xFF & (temp >> 8);
-                 z->regE = 0xFF & temp; break;
-        case HL: z->regH = 0xFF & (temp >> 8);
-                 z->regL = 0xFF & temp; break;
+        case BC: z->regBC = 0xFFFF & temp; break;
+        case DE: z->regDE = 0xFFFF & temp; break;
+        case HL: z->regHL = 0xFFFF & temp; break;
         case IX: z->regIX = temp; break;
         case IY: z->regIY = temp; break;
         case SP: z->regSP = temp; break;
-        case a_nn: low = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
-                   high = readFromMemory(z, readProgramCounter(z));
-                   incrementProgramCounter(z);
+        case a_nn: low = fetchOperand(z);
+                   high = fetchOperand(z);
                    address = 0xFFFF & ((high << 8) | (low & 0xFF));
                    writeToMemory(z, address, temp & 0xFF);
                    address = 0xFFFF & (address + 1);
@@ -2308,7 +3923,7 @@ static void LD_16Bit(Z80 z, cpuVal destination, cpuVal source, emubyte longer)
 }
 
 /* this function emulates all of the OR instructions */
-static void OR(Z80 z, cpuVal value)
+Z80_SPECIALISED void OR(Z80 z, cpuVal value)
 {
     /* define variables */
     emubyte temp = 0;
@@ -2327,17 +3942,14 @@ static void OR(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
         default: break;
@@ -2347,16 +3959,11 @@ static void OR(Z80 z, cpuVal value)
     z->regA |= temp;
 
     /* deal with flags */
-    calculateSFlag(z, z->regA);
-    calculateZFlag(z, z->regA);
-    setHFlag(z, false);
-    calculatePVFlag(z, z->regA);
-    setNFlag(z, false);
-    setCFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[z->regA];
 }
 
 /* this function emulates all of the SUB instructions */
-static void SUB(Z80 z, cpuVal value)
+Z80_SPECIALISED void SUB(Z80 z, cpuVal value)
 {
     /* define variables, including one to hold result (must be larger than
        one byte, to allow for checking of borrow from bit 8) */
@@ -2377,17 +3984,14 @@ static void SUB(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
         default: break;
@@ -2397,19 +4001,14 @@ static void SUB(Z80 z, cpuVal value)
     result = z->regA - temp;
     
     /* deal with flags */
-    calculateSFlag(z, result);
-    calculateZFlag(z, result);
-    calculateHFlag(z, z->regA, temp, result);
-    calculatePVOverflow(z, temp, result, subtraction);
-    setNFlag(z, true);
-    calculateCFlag(z, temp, result);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | subFlags[0][z->regA][temp];
     
     /* store result in accumulator */
     z->regA = 0xFF & result;
 }
 
 /* this function emulates all of the SBC instructions (including the 16-bit ones) */
-static void SBC(Z80 z, cpuVal value)
+Z80_SPECIALISED void SBC(Z80 z, cpuVal value)
 {
     /* define variables, including one to hold result (must be larger than
        two bytes, to allow for checking of borrow from bit 16 for 16-bit operations) */
@@ -2431,28 +4030,25 @@ static void SBC(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
-        case BC: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-                 temp = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+        case BC: tempHL = z->regHL;
+                 temp = z->regBC;
                  z->cycles = 15; break;
-        case DE: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-                 temp = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
+        case DE: tempHL = z->regHL;
+                 temp = z->regDE;
                  z->cycles = 15; break;
-        case HL: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case HL: tempHL = z->regHL;
                  temp = tempHL; z->cycles = 15; break;
-        case SP: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case SP: tempHL = z->regHL;
                  temp = readStackPointer(z); z->cycles = 15; break;
         default: break;
     }
@@ -2465,33 +4061,26 @@ static void SBC(Z80 z, cpuVal value)
     
     /* deal with flags */
     switch (value) {
-        case BC: case DE: case HL: case SP: calculateSFlag16(z, result);
-                                            calculateZFlag16(z, result);
-                                            calculateHFlag16(z, tempHL, temp, result);
-                                            calculatePVOverflow16(z, tempHL, temp, result, subtraction16);
-                                            setNFlag(z, true);
-                                            calculateCFlag16(z, tempHL, temp, result);
+        case BC: case DE: case HL: case SP: z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | ((result >> 8) & 0x80) |
+                                                      ((result & 0xFFFF) == 0 ? 0x40 : 0) |
+                                                      (((tempHL ^ temp ^ result) >> 8) & 0x10) |
+                                                      ((((tempHL ^ temp) & (tempHL ^ result)) >> 13) & 0x04) |
+                                                      0x02 | (((tempHL ^ temp ^ result) >> 16) & 0x01);
                                             break;
-        default: calculateSFlag(z, result);
-                 calculateZFlag(z, result);
-                 calculateHFlag(z, z->regA, temp, result);
-                 calculatePVOverflow(z, temp, result, subtraction);
-                 setNFlag(z, true);
-                 calculateCFlag(z, temp, result);
+        default: z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | subFlags[z->regF & 0x01][z->regA][temp];
                  break;
     }
     
     /* store result accordingly */
     switch (value) {
-        case BC: case DE: case HL: case SP: z->regH = 0xFF & (result >> 8);
-                                            z->regL = 0xFF & result;
+        case BC: case DE: case HL: case SP: z->regHL = 0xFFFF & result;
                                             break;
         default: z->regA = 0xFF & result; break;
     }
 }
 
 /* this function emulates all of the PUSH instructions */
-static void PUSH(Z80 z, cpuVal value)
+Z80_SPECIALISED void PUSH(Z80 z, cpuVal value)
 {
     /* decrement stack pointer */
     decrementStackPointer(z);
@@ -2523,7 +4112,7 @@ static void PUSH(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the POP instructions */
-static void POP(Z80 z, cpuVal value)
+Z80_SPECIALISED void POP(Z80 z, cpuVal value)
 {
     /* read lower byte from stack */
     switch (value) {
@@ -2557,7 +4146,7 @@ static void POP(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the conditional RET instructions */
-static void RET_CONDITIONAL(Z80 z, cpuVal value)
+Z80_SPECIALISED void RET_CONDITIONAL(Z80 z, cpuVal value)
 {
     /* define variables to hold correct bitmask and expected result */
     emubyte bitmask = 0, expected_result = 0;
@@ -2601,7 +4190,7 @@ static void RET(Z80 z)
 }
 
 /* this function emulates all of the ADC instructions (including the 16-bit ones) */
-static void ADC(Z80 z, cpuVal value)
+Z80_SPECIALISED void ADC(Z80 z, cpuVal value)
 {
     /* define variables, including one to hold result (must be larger than
        two bytes, to allow for checking of borrow from bit 16 (for 16-bit operations) */
@@ -2623,28 +4212,25 @@ static void ADC(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
-        case BC: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-                 temp = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+        case BC: tempHL = z->regHL;
+                 temp = z->regBC;
                  z->cycles = 15; break;
-        case DE: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-                 temp = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
+        case DE: tempHL = z->regHL;
+                 temp = z->regDE;
                  z->cycles = 15; break;
-        case HL: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case HL: tempHL = z->regHL;
                  temp = tempHL; z->cycles = 15; break;
-        case SP: tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case SP: tempHL = z->regHL;
                  temp = readStackPointer(z); z->cycles = 15; break;
         default: break;
     }
@@ -2657,33 +4243,26 @@ static void ADC(Z80 z, cpuVal value)
     
     /* deal with flags */
     switch (value) {
-        case BC: case DE: case HL: case SP: calculateSFlag16(z, result);
-                                            calculateZFlag16(z, result);
-                                            calculateHFlag16(z, tempHL, temp, result);
-                                            calculatePVOverflow16(z, tempHL, temp, result, addition16);
-                                            setNFlag(z, false);
-                                            calculateCFlag16(z, tempHL, temp, result);
+        case BC: case DE: case HL: case SP: z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | ((result >> 8) & 0x80) |
+                                                      ((result & 0xFFFF) == 0 ? 0x40 : 0) |
+                                                      (((tempHL ^ temp ^ result) >> 8) & 0x10) |
+                                                      (((~(tempHL ^ temp) & (tempHL ^ result)) >> 13) & 0x04) |
+                                                      (((tempHL ^ temp ^ result) >> 16) & 0x01);
                                             break;
-        default: calculateSFlag(z, result);
-                 calculateZFlag(z, result);
-                 calculateHFlag(z, z->regA, temp, result);
-                 calculatePVOverflow(z, temp, result, addition);
-                 setNFlag(z, false);
-                 calculateCFlag(z, temp, result);
+        default: z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | addFlags[z->regF & 0x01][z->regA][temp];
                  break;
     }
     
     /* store result accordingly */
     switch (value) {
-        case BC: case DE: case HL: case SP: z->regH = 0xFF & (result >> 8);
-                                            z->regL = 0xFF & result;
+        case BC: case DE: case HL: case SP: z->regHL = 0xFFFF & result;
                                             break;
         default: z->regA = 0xFF & result; break;
     }
 }
 
 /* this function emulates all of the ADD instructions (including the 16-bit ones) */
-static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
+Z80_SPECIALISED void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
 {
     /* define variables, including one to hold result (variables must be larger than
        one byte, to allow for 16-bit addition) */
@@ -2706,28 +4285,25 @@ static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
                     case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
                     case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
                     case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-                    case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+                    case aHL: temp = readFromMemory(z, z->regHL);
                               z->cycles = 7; break;
-                    case n: temp = readFromMemory(z, readProgramCounter(z));
-                            incrementProgramCounter(z);
+                    case n: temp = fetchOperand(z);
                             z->cycles = 7; break;
-                    case IXd: d = readFromMemory(z, readProgramCounter(z));
-                              incrementProgramCounter(z);
+                    case IXd: d = fetchOperand(z);
                               temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                               z->cycles = 19; break;
-                    case IYd: d = readFromMemory(z, readProgramCounter(z));
-                              incrementProgramCounter(z);
+                    case IYd: d = fetchOperand(z);
                               temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                               z->cycles = 19; break;
                     default: break;
                 } break;
-        case HL: temp16source = 0xFFFF & ((z->regH << 8) | (0xFF & z->regL));
+        case HL: temp16source = z->regHL;
                  switch (valuetwo) {
-                     case BC: temp = 0xFFFF & ((z->regB << 8) | (0xFF & z->regC));
+                     case BC: temp = z->regBC;
                               z->cycles = 11; break;
-                     case DE: temp = 0xFFFF & ((z->regD << 8) | (0xFF & z->regE));
+                     case DE: temp = z->regDE;
                               z->cycles = 11; break;
-                     case HL: temp = 0xFFFF & ((z->regH << 8) | (0xFF & z->regL));
+                     case HL: temp = z->regHL;
                               z->cycles = 11; break;
                      case SP: temp = readStackPointer(z);
                               z->cycles = 11; break;
@@ -2735,9 +4311,9 @@ static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
                  } break;
         case IX: temp16source = z->regIX;
                  switch (valuetwo) {
-                     case BC: temp = 0xFFFF & ((z->regB << 8) | (0xFF & z->regC));
+                     case BC: temp = z->regBC;
                               z->cycles = 15; break;
-                     case DE: temp = 0xFFFF & ((z->regD << 8) | (0xFF & z->regE));
+                     case DE: temp = z->regDE;
                               z->cycles = 15; break;
                      case IX: temp = z->regIX;
                               z->cycles = 15; break;
@@ -2747,9 +4323,9 @@ static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
                  } break;
         case IY: temp16source = z->regIY;
                  switch (valuetwo) {
-                     case BC: temp = 0xFFFF & ((z->regB << 8) | (0xFF & z->regC));
+                     case BC: temp = z->regBC;
                               z->cycles = 15; break;
-                     case DE: temp = 0xFFFF & ((z->regD << 8) | (0xFF & z->regE));
+                     case DE: temp = z->regDE;
                               z->cycles = 15; break;
                      case IY: temp = z->regIY;
                               z->cycles = 15; break;
@@ -2768,23 +4344,17 @@ static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
     
     /* deal with flags */
     switch (valueone) {
-        case HL: case IX: case IY: calculateHFlag16(z, temp16source, temp, result);
-                                   setNFlag(z, false);
-                                   calculateCFlag16(z, temp16source, temp, result);
+        case HL: case IX: case IY: z->regF = (z->regF & Z80_KEEP_FLAGS(0xEC)) |
+                                             (((temp16source ^ temp ^ result) >> 8) & 0x10) |
+                                             (((temp16source ^ temp ^ result) >> 16) & 0x01);
                                    break;
-        default: calculateSFlag(z, result);
-                 calculateZFlag(z, result);
-                 calculateHFlag(z, z->regA, temp, result);
-                 calculatePVOverflow(z, temp, result, addition);
-                 setNFlag(z, false);
-                 calculateCFlag(z, temp, result);
+        default: z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | addFlags[0][z->regA][temp];
                  break;
     }
 
     /* store result in relevant location */
     switch (valueone) {
-        case HL: z->regH = 0xFF & (result >> 8);
-                 z->regL = 0xFF & result;
+        case HL: z->regHL = 0xFFFF & result;
                  break;
         case IX: z->regIX = 0xFFFF & result;
                  break;
@@ -2796,7 +4366,7 @@ static void ADD(Z80 z, cpuVal valueone, cpuVal valuetwo)
 }
 
 /* this function emulates all of the AND instructions */
-static void AND(Z80 z, cpuVal value)
+Z80_SPECIALISED void AND(Z80 z, cpuVal value)
 {
     /* define variables */
     emubyte temp = 0;
@@ -2816,17 +4386,14 @@ static void AND(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
         default: break;
@@ -2836,19 +4403,14 @@ static void AND(Z80 z, cpuVal value)
     result = z->regA & temp;
     
     /* deal with flags */
-    calculateSFlag(z, result);
-    calculateZFlag(z, result);
-    setHFlag(z, true);
-    calculatePVFlag(z, result);
-    setNFlag(z, false);
-    setCFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[result] | 0x10;
     
     /* store result back to accumulator */
     z->regA = result;
 }
 
 /* this function emulates all of the conditional CALL instructions */
-static void CALL_CONDITIONAL(Z80 z, cpuVal value)
+Z80_SPECIALISED void CALL_CONDITIONAL(Z80 z, cpuVal value)
 {
     /* define variables to hold correct bitmask and expected result,
        as well as the new address */
@@ -2869,10 +4431,8 @@ static void CALL_CONDITIONAL(Z80 z, cpuVal value)
     }
     
     /* get new address from memory */
-    newAddress = readFromMemory(z, readProgramCounter(z));
-    incrementProgramCounter(z);
-    newAddress = 0xFFFF & ((readFromMemory(z, readProgramCounter(z)) << 8) | (0xFF & newAddress));
-    incrementProgramCounter(z);
+    newAddress = fetchOperand(z);
+    newAddress = 0xFFFF & ((fetchOperand(z) << 8) | (0xFF & newAddress));
     
     /* run test and act accordingly */
     if ((z->regF & bitmask) == expected_result) {
@@ -2895,10 +4455,8 @@ static void CALL(Z80 z)
     emuint newAddress = 0;
     
     /* get new address from memory */
-    newAddress = readFromMemory(z, readProgramCounter(z));
-    incrementProgramCounter(z);
-    newAddress = 0xFFFF & ((readFromMemory(z, readProgramCounter(z)) << 8) | (0xFF & newAddress));
-    incrementProgramCounter(z);
+    newAddress = fetchOperand(z);
+    newAddress = 0xFFFF & ((fetchOperand(z) << 8) | (0xFF & newAddress));
     
     /* push old program counter value to stack */
     decrementStackPointer(z);
@@ -2916,32 +4474,18 @@ static void CALL(Z80 z)
 /* this emulates the CCF instruction */
 static void CCF(Z80 z)
 {
-    /* define variables */
-    emubyte tempH = 0, tempC = 0;
-    
-    /* copy previous carry flag to the H flag */
-    tempH = 0x1F & (z->regF << 4);
-    z->regF = (0xEF & z->regF) | tempH;
-    
-    /* reset the N flag */
-    setNFlag(z, false);
-    
-    /* invert the C flag */
-    tempC = 0x01 & z->regF;
-    tempC = ~tempC & 0x01;
-    z->regF = (0xFE & z->regF) | tempC;
+    /* copy previous carry flag to the H flag, reset the N flag and invert the C flag */
+    z->regF = ((0xED & z->regF) | ((z->regF & 0x01) << 4)) ^ 0x01;
     
     /* set cycle count */
     z->cycles = 4;
 }
 
 /* this function emulates all of the CP instructions */
-static void CP(Z80 z, cpuVal value)
+Z80_SPECIALISED void CP(Z80 z, cpuVal value)
 {
-    /* define variables (the result must be larger than a byte to check for
-       various flag conditions */
+    /* define variables */
     emubyte temp = 0;
-    emuint result = 0;
     signed_emubyte d = 0;
 
     /* retrieve correct value, and set cycle count */
@@ -2957,65 +4501,42 @@ static void CP(Z80 z, cpuVal value)
         case IXl: temp = 0xFF & z->regIX; z->cycles = 4; break;
         case IYh: temp = 0xFF & (z->regIY >> 8); z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY; z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 7; break;
-        case n: temp = readFromMemory(z, readProgramCounter(z));
-                incrementProgramCounter(z);
+        case n: temp = fetchOperand(z);
                 z->cycles = 7; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 19; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 19; break;
         default: break;
     }
 
-    /* perform calculation */
-    result = z->regA - temp;
-
-    /* deal with flags */
-    calculateSFlag(z, result);
-    calculateZFlag(z, result);
-    calculateHFlag(z, z->regA, temp, result);
-    calculatePVOverflow(z, temp, result, subtraction);
-    setNFlag(z, true);
-    calculateCFlag(z, temp, result);
+    /* deal with flags, which are those of subtracting the value from the accumulator */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | subFlags[0][z->regA][temp];
 }
 
 /* this function emulates the CPD instruction */
 static void CPD(Z80 z)
 {
     /* define variables */
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte calculation = 0xFF & (z->regA - readFromMemory(z, tempHL));
-    
-    /* calculate S, Z and H flags */
-    calculateSFlag(z, calculation);
-    calculateZFlag(z, calculation);
-    calculateHFlag(z, z->regA, readFromMemory(z, tempHL), calculation);
+    emuint tempBC = z->regBC;
+    emuint tempHL = z->regHL;
+    emubyte temp = readFromMemory(z, tempHL);
     
-    /* decrement BC then check if it isn't zero - set P/V flag if so, else reset it */
+    /* decrement BC, then calculate S, Z and H flags from the comparison, set N flag,
+       and set P/V flag if BC isn't zero, else reset it */
     tempBC = 0xFFFF & (tempBC - 1);
-    if (!(tempBC == 0))
-        setPVFlag(z, true);
-    else
-        setPVFlag(z, false);
-    
-    /* set N flag */
-    setNFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | (subFlags[0][z->regA][temp] & 0xD0) | (tempBC != 0 ? 0x06 : 0x02);
     
     /* decrement HL */
     tempHL = 0xFFFF & (tempHL - 1);
     
     /* store BC and HL back into consituent 8-bit registers */
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
+    z->regBC = 0xFFFF & tempBC;
+    z->regHL = 0xFFFF & tempHL;
     
     /* set cycle count */
     z->cycles = 16;
@@ -3024,76 +4545,57 @@ static void CPD(Z80 z)
 /* this function emulates the CPDR instruction */
 static void CPDR(Z80 z)
 {
-    /* define variables */
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte calculation = 0xFF & (z->regA - readFromMemory(z, tempHL));
-    
-    /* calculate S, Z and H flags */
-    calculateSFlag(z, calculation);
-    calculateZFlag(z, calculation);
-    calculateHFlag(z, z->regA, readFromMemory(z, tempHL), calculation);
-    
-    /* decrement BC then check if it isn't zero - set P/V flag if so, else reset it */
-    tempBC = 0xFFFF & (tempBC - 1);
-    if (!(tempBC == 0))
-        setPVFlag(z, true);
-    else
-        setPVFlag(z, false);
-    
-    /* set N flag */
-    setNFlag(z, true);
-    
-    /* decrement HL */
-    tempHL = 0xFFFF & (tempHL - 1);
-    
-    /* store BC and HL back into consituent 8-bit registers */
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    
-    /* set cycle count depending on outcome, and repeat instruction if necessary */
-    if ((calculation == 0) || (tempBC == 0)) {
-        z->cycles = 16;
-    } else {
-        z->cycles = 21;
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define variables */
+        emuint tempBC = z->regBC;
+        emuint tempHL = z->regHL;
+        emubyte temp = readFromMemory(z, tempHL);
+        emubyte calculation = 0xFF & (z->regA - temp);
+
+        /* decrement BC, then calculate S, Z and H flags from the comparison, set N flag,
+           and set P/V flag if BC isn't zero, else reset it */
+        tempBC = 0xFFFF & (tempBC - 1);
+        z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | (subFlags[0][z->regA][temp] & 0xD0) | (tempBC != 0 ? 0x06 : 0x02);
+
+        /* decrement HL */
+        tempHL = 0xFFFF & (tempHL - 1);
+
+        /* store BC and HL back into consituent 8-bit registers */
+        z->regBC = 0xFFFF & tempBC;
+        z->regHL = 0xFFFF & tempHL;
+
+        /* set cycle count depending on outcome, and repeat instruction if necessary */
+        if ((calculation == 0) || (tempBC == 0)) {
+            z->cycles = 16;
+        } else {
+            z->cycles = 21;
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+        }
+    } while ((z->cycles == 21) && isDirectRead(z, z->regHL) && repeatBlockInstruction(z, 0xB9));
 }
 
 /* this function emulates the CPI instruction */
 static void CPI(Z80 z)
 {
     /* define variables */
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte calculation = 0xFF & (z->regA - readFromMemory(z, tempHL));
-    
-    /* calculate S, Z and H flags */
-    calculateSFlag(z, calculation);
-    calculateZFlag(z, calculation);
-    calculateHFlag(z, z->regA, readFromMemory(z, tempHL), calculation);
+    emuint tempBC = z->regBC;
+    emuint tempHL = z->regHL;
+    emubyte temp = readFromMemory(z, tempHL);
     
-    /* decrement BC then check if it isn't zero - set P/V flag if so, else reset it */
+    /* decrement BC, then calculate S, Z and H flags from the comparison, set N flag,
+       and set P/V flag if BC isn't zero, else reset it */
     tempBC = 0xFFFF & (tempBC - 1);
-    if (!(tempBC == 0))
-        setPVFlag(z, true);
-    else
-        setPVFlag(z, false);
-    
-    /* set N flag */
-    setNFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | (subFlags[0][z->regA][temp] & 0xD0) | (tempBC != 0 ? 0x06 : 0x02);
     
     /* increment HL */
     tempHL = 0xFFFF & (tempHL + 1);
     
     /* store BC and HL back into consituent 8-bit registers */
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
+    z->regBC = 0xFFFF & tempBC;
+    z->regHL = 0xFFFF & tempHL;
     
     /* set cycle count */
     z->cycles = 16;
@@ -3102,43 +4604,36 @@ static void CPI(Z80 z)
 /* this function emulates the CPIR instruction */
 static void CPIR(Z80 z)
 {
-    /* define variables */
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte calculation = 0xFF & (z->regA - readFromMemory(z, tempHL));
-    
-    /* calculate S, Z and H flags */
-    calculateSFlag(z, calculation);
-    calculateZFlag(z, calculation);
-    calculateHFlag(z, z->regA, readFromMemory(z, tempHL), calculation);
-    
-    /* decrement BC then check if it isn't zero - set P/V flag if so, else reset it */
-    tempBC = 0xFFFF & (tempBC - 1);
-    if (!(tempBC == 0))
-        setPVFlag(z, true);
-    else
-        setPVFlag(z, false);
-    
-    /* set N flag */
-    setNFlag(z, true);
-    
-    /* increment HL */
-    tempHL = 0xFFFF & (tempHL + 1);
-    
-    /* store BC and HL back into consituent 8-bit registers */
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    
-    /* set cycle count depending on outcome, and repeat instruction if necessary */
-    if ((calculation == 0) || (tempBC == 0)) {
-        z->cycles = 16;
-    } else {
-        z->cycles = 21;
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define variables */
+        emuint tempBC = z->regBC;
+        emuint tempHL = z->regHL;
+        emubyte temp = readFromMemory(z, tempHL);
+        emubyte calculation = 0xFF & (z->regA - temp);
+
+        /* decrement BC, then calculate S, Z and H flags from the comparison, set N flag,
+           and set P/V flag if BC isn't zero, else reset it */
+        tempBC = 0xFFFF & (tempBC - 1);
+        z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | (subFlags[0][z->regA][temp] & 0xD0) | (tempBC != 0 ? 0x06 : 0x02);
+
+        /* increment HL */
+        tempHL = 0xFFFF & (tempHL + 1);
+
+        /* store BC and HL back into consituent 8-bit registers */
+        z->regBC = 0xFFFF & tempBC;
+        z->regHL = 0xFFFF & tempHL;
+
+        /* set cycle count depending on outcome, and repeat instruction if necessary */
+        if ((calculation == 0) || (tempBC == 0)) {
+            z->cycles = 16;
+        } else {
+            z->cycles = 21;
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+        }
+    } while ((z->cycles == 21) && isDirectRead(z, z->regHL) && repeatBlockInstruction(z, 0xB1));
 }
 
 /* this function emulates the CPL instruction */
@@ -3148,8 +4643,7 @@ static void CPL(Z80 z)
     z->regA = 0xFF & ~z->regA;
     
     /* set H and N flags */
-    setHFlag(z, true);
-    setNFlag(z, true);
+    z->regF |= 0x12;
     
     /* set cycle count */
     z->cycles = 4;
@@ -3161,32 +4655,9 @@ static void NEG(Z80 z)
     /* subtract accumulator from zero */
     emubyte result = 0xFF & (0 - z->regA);
     
-    /* calculate S and Z flags */
-    calculateSFlag(z, result);
-    calculateZFlag(z, result);
-    
-    /* check for borrow from bit 4 and set H flag if so, else reset it */
-    if ((((0 ^ z->regA) ^ result) & 0x10) == 16)
-        setHFlag(z, true);
-    else
-        setHFlag(z, false);
-    
-    /* check if accumulator was 0x80 before calculation and set P/V flag
-       if so, else reset it */
-    if ((z->regA & 0xFF) == 0x80)
-        setPVFlag(z, true);
-    else
-        setPVFlag(z, false);
-    
-    /* set N flag */
-    setNFlag(z, true);
-    
-    /* set C flag if accumulator was not equal to 0 before instruction,
-       reset otherwise */
-    if ((z->regA & 0xFF) != 0)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* deal with flags, which are those of subtracting the accumulator from zero - this
+       means P/V is set if the accumulator was 0x80, and C is set if it wasn't 0 */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | subFlags[0][0][z->regA];
     
     /* store result back into accumulator */
     z->regA = result;
@@ -3199,9 +4670,9 @@ static void NEG(Z80 z)
 static void LDD(Z80 z)
 {
     /* define temporary variables to store 16-bit register values */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emuint tempDE = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+    emuint tempHL = z->regHL;
+    emuint tempDE = z->regDE;
+    emuint tempBC = z->regBC;
     
     /* write from memory location (tempHL) to memory location (tempDE) */
     writeToMemory(z, tempDE, readFromMemory(z, tempHL));
@@ -3212,22 +4683,12 @@ static void LDD(Z80 z)
     tempBC = 0xFFFF & (tempBC - 1);
     
     /* store register values back to their constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    z->regD = 0xFF & (tempDE >> 8);
-    z->regE = 0xFF & tempDE;
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    
-    /* reset H and N flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    
-    /* reset P/V flag if BC is 0, else set it */
-    if (tempBC == 0)
-        setPVFlag(z, false);
-    else
-        setPVFlag(z, true);
+    z->regHL = 0xFFFF & tempHL;
+    z->regDE = 0xFFFF & tempDE;
+    z->regBC = 0xFFFF & tempBC;
+    
+    /* reset H and N flags, and reset P/V flag if BC is 0, else set it */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xE9)) | (tempBC != 0 ? 0x04 : 0);
     
     /* set cycle count */
     z->cycles = 16;
@@ -3237,9 +4698,9 @@ static void LDD(Z80 z)
 static void LDI(Z80 z)
 {
     /* define temporary variables to store 16-bit register values */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emuint tempDE = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+    emuint tempHL = z->regHL;
+    emuint tempDE = z->regDE;
+    emuint tempBC = z->regBC;
     
     /* write from memory location (tempHL) to memory location (tempDE) */
     writeToMemory(z, tempDE, readFromMemory(z, tempHL));
@@ -3250,22 +4711,12 @@ static void LDI(Z80 z)
     tempBC = 0xFFFF & (tempBC - 1);
     
     /* store register values back to their constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    z->regD = 0xFF & (tempDE >> 8);
-    z->regE = 0xFF & tempDE;
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    
-    /* reset H and N flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    
-    /* reset P/V flag if BC is 0, else set it */
-    if (tempBC == 0)
-        setPVFlag(z, false);
-    else
-        setPVFlag(z, true);
+    z->regHL = 0xFFFF & tempHL;
+    z->regDE = 0xFFFF & tempDE;
+    z->regBC = 0xFFFF & tempBC;
+    
+    /* reset H and N flags, and reset P/V flag if BC is 0, else set it */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xE9)) | (tempBC != 0 ? 0x04 : 0);
     
     /* set cycle count */
     z->cycles = 16;
@@ -3275,81 +4726,79 @@ static void LDI(Z80 z)
 /* this function emulates the LDDR instruction */
 static void LDDR(Z80 z)
 {
-    /* define temporary variables to store 16-bit register values */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emuint tempDE = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    
-    /* write from memory location (tempHL) to memory location (tempDE) */
-    writeToMemory(z, tempDE, readFromMemory(z, tempHL));
-    
-    /* decrement all three register pairs */
-    tempHL = 0xFFFF & (tempHL - 1);
-    tempDE = 0xFFFF & (tempDE - 1);
-    tempBC = 0xFFFF & (tempBC - 1);
-    
-    /* store register values back to their constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    z->regD = 0xFF & (tempDE >> 8);
-    z->regE = 0xFF & tempDE;
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    
-    /* reset H, N and P/V flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    setPVFlag(z, false);
-    
-    /* check if BC is now zero and set cycle count accordingly,
-       repeating instruction if necessary */
-    if (tempBC == 0) {
-        z->cycles = 16;
-    } else {
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-        z->cycles = 21;
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define temporary variables to store 16-bit register values */
+        emuint tempHL = z->regHL;
+        emuint tempDE = z->regDE;
+        emuint tempBC = z->regBC;
+
+        /* write from memory location (tempHL) to memory location (tempDE) */
+        writeToMemory(z, tempDE, readFromMemory(z, tempHL));
+
+        /* decrement all three register pairs */
+        tempHL = 0xFFFF & (tempHL - 1);
+        tempDE = 0xFFFF & (tempDE - 1);
+        tempBC = 0xFFFF & (tempBC - 1);
+
+        /* store register values back to their constituent registers */
+        z->regHL = 0xFFFF & tempHL;
+        z->regDE = 0xFFFF & tempDE;
+        z->regBC = 0xFFFF & tempBC;
+
+        /* reset H, N and P/V flags */
+        z->regF &= Z80_KEEP_FLAGS(0xE9);
+
+        /* check if BC is now zero and set cycle count accordingly,
+           repeating instruction if necessary */
+        if (tempBC == 0) {
+            z->cycles = 16;
+        } else {
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+            z->cycles = 21;
+        }
+    } while ((z->cycles == 21) && isDirectRead(z, z->regHL) && isDirectWrite(z, z->regDE) && repeatBlockInstruction(z, 0xB8));
 }
 
 /* this function emulates the LDIR instruction */
 static void LDIR(Z80 z)
 {
-    /* define temporary variables to store 16-bit register values */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emuint tempDE = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
-    emuint tempBC = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    
-    /* write from memory location (tempHL) to memory location (tempDE) */
-    writeToMemory(z, tempDE, readFromMemory(z, tempHL));
-    
-    /* increment HL and DE, and decrement BC */
-    tempHL = 0xFFFF & (tempHL + 1);
-    tempDE = 0xFFFF & (tempDE + 1);
-    tempBC = 0xFFFF & (tempBC - 1);
-    
-    /* store register values back to their constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    z->regD = 0xFF & (tempDE >> 8);
-    z->regE = 0xFF & tempDE;
-    z->regB = 0xFF & (tempBC >> 8);
-    z->regC = 0xFF & tempBC;
-    
-    /* reset H, N and P/V flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    setPVFlag(z, false);
-    
-    /* check if BC is now zero and set cycle count accordingly,
-       repeating instruction if necessary */
-    if (tempBC == 0) {
-        z->cycles = 16;
-    } else {
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-        z->cycles = 21;
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define temporary variables to store 16-bit register values */
+        emuint tempHL = z->regHL;
+        emuint tempDE = z->regDE;
+        emuint tempBC = z->regBC;
+
+        /* write from memory location (tempHL) to memory location (tempDE) */
+        writeToMemory(z, tempDE, readFromMemory(z, tempHL));
+
+        /* increment HL and DE, and decrement BC */
+        tempHL = 0xFFFF & (tempHL + 1);
+        tempDE = 0xFFFF & (tempDE + 1);
+        tempBC = 0xFFFF & (tempBC - 1);
+
+        /* store register values back to their constituent registers */
+        z->regHL = 0xFFFF & tempHL;
+        z->regDE = 0xFFFF & tempDE;
+        z->regBC = 0xFFFF & tempBC;
+
+        /* reset H, N and P/V flags */
+        z->regF &= Z80_KEEP_FLAGS(0xE9);
+
+        /* check if BC is now zero and set cycle count accordingly,
+           repeating instruction if necessary */
+        if (tempBC == 0) {
+            z->cycles = 16;
+        } else {
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+            z->cycles = 21;
+        }
+    } while ((z->cycles == 21) && isDirectRead(z, z->regHL) && isDirectWrite(z, z->regDE) && repeatBlockInstruction(z, 0xB0));
 }
 
 /* this function emulates the DJNZ,e instruction */
@@ -3363,8 +4812,7 @@ static void DJNZ(Z80 z)
     z->regB = 0xFF & (z->regB - 1);
     
     /* read in adjustment value */
-    adjustment = readFromMemory(z, readProgramCounter(z));
-    incrementProgramCounter(z);
+    adjustment = fetchOperand(z);
     
     /* create temporary program counter value */
     tempPC = 0xFFFF & (readProgramCounter(z) + adjustment);
@@ -3379,10 +4827,11 @@ static void DJNZ(Z80 z)
 }
 
 /* this function emulates all of the EX instructions */
-static void EX(Z80 z, cpuVal valueone, cpuVal valuetwo)
+Z80_SPECIALISED void EX(Z80 z, cpuVal valueone, cpuVal valuetwo)
 {
     /* define variables */
     emubyte high = 0, low = 0;
+    emuint temp = 0;
     
     /* perform the relevant swap */
     switch (valueone) {
@@ -3393,12 +4842,9 @@ static void EX(Z80 z, cpuVal valueone, cpuVal valuetwo)
                  z->regAShadow = high;
                  z->regFShadow = low;
                  z->cycles = 4; break;
-        case DE: high = z->regD;
-                 low = z->regE;
-                 z->regD = z->regH;
-                 z->regE = z->regL;
-                 z->regH = high;
-                 z->regL = low;
+        case DE: temp = z->regDE;
+                 z->regDE = z->regHL;
+                 z->regHL = temp;
                  z->cycles = 4; break;
         case aSP: low = readFromMemory(z, readStackPointer(z));
                   high = readFromMemory(z, readStackPointer(z) + 1);
@@ -3423,7 +4869,7 @@ static void EX(Z80 z, cpuVal valueone, cpuVal valuetwo)
 }
 
 /* this function emulates all of the DEC instructions */
-static void DEC(Z80 z, cpuVal value)
+Z80_SPECIALISED void DEC(Z80 z, cpuVal value)
 {
     /* define variables */
     signed_emubyte d = 0;
@@ -3454,21 +4900,19 @@ static void DEC(Z80 z, cpuVal value)
                   z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY;
                   z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 11; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
-        case BC: temp = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+        case BC: temp = z->regBC;
                  z->cycles = 6; break;
-        case DE: temp = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
+        case DE: temp = z->regDE;
                  z->cycles = 6; break;
-        case HL: temp = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case HL: temp = z->regHL;
                  z->cycles = 6; break;
         case SP: temp = readStackPointer(z);
                  z->cycles = 6; break;
@@ -3490,14 +4934,7 @@ static void DEC(Z80 z, cpuVal value)
     switch (value) {
         case BC: case DE: case HL:
         case SP: case IX: case IY: break;
-        default: calculateSFlag(z, result);
-                 calculateZFlag(z, result);
-                 calculateHFlag(z, temp, 0x01, result);
-                 if ((temp & 0xFF) == 0x80)
-                     setPVFlag(z, true);
-                 else
-                     setPVFlag(z, false);
-                 setNFlag(z, true);
+        default: z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | decFlags[temp];
                  break;
     }
     
@@ -3514,15 +4951,12 @@ static void DEC(Z80 z, cpuVal value)
         case IXl: z->regIX = 0xFFFF & ((z->regIX & 0xFF00) | (result)); break;
         case IYh: z->regIY = 0xFFFF & ((result << 8) | (z->regIY & 0xFF)); break;
         case IYl: z->regIY = 0xFFFF & ((z->regIY & 0xFF00) | (result)); break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), result); break;
+        case aHL: writeToMemory(z, z->regHL, result); break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), result); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), result); break;
-        case BC: z->regB = 0xFF & (result >> 8);
-                 z->regC = 0xFF & result; break;
-        case DE: z->regD = 0xFF & (result >> 8);
-                 z->regE = 0xFF & result; break;
-        case HL: z->regH = 0xFF & (result >> 8);
-                 z->regL = 0xFF & result; break;
+        case BC: z->regBC = 0xFFFF & result; break;
+        case DE: z->regDE = 0xFFFF & result; break;
+        case HL: z->regHL = 0xFFFF & result; break;
         case SP: writeStackPointer(z, result); break;
         case IX: z->regIX = result; break;
         case IY: z->regIY = result; break;
@@ -3531,7 +4965,7 @@ static void DEC(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the INC instructions */
-static void INC(Z80 z, cpuVal value)
+Z80_SPECIALISED void INC(Z80 z, cpuVal value)
 {
     /* define variables */
     signed_emubyte d = 0;
@@ -3562,21 +4996,19 @@ static void INC(Z80 z, cpuVal value)
                   z->cycles = 4; break;
         case IYl: temp = 0xFF & z->regIY;
                   z->cycles = 4; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 11; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IXd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case IYd: d = fetchOperand(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
-        case BC: temp = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+        case BC: temp = z->regBC;
                  z->cycles = 6; break;
-        case DE: temp = 0xFFFF & ((z->regD << 8) | (z->regE & 0xFF));
+        case DE: temp = z->regDE;
                  z->cycles = 6; break;
-        case HL: temp = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case HL: temp = z->regHL;
                  z->cycles = 6; break;
         case SP: temp = readStackPointer(z);
                  z->cycles = 6; break;
@@ -3598,14 +5030,7 @@ static void INC(Z80 z, cpuVal value)
     switch (value) {
         case BC: case DE: case HL:
         case SP: case IX: case IY: break;
-        default: calculateSFlag(z, result);
-                 calculateZFlag(z, result);
-                 calculateHFlag(z, temp, 0x01, result);
-                 if ((temp & 0xFF) == 0x7F)
-                     setPVFlag(z, true);
-                 else
-                     setPVFlag(z, false);
-                 setNFlag(z, false);
+        default: z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | incFlags[temp];
                  break;
     }
     
@@ -3622,15 +5047,12 @@ static void INC(Z80 z, cpuVal value)
         case IXl: z->regIX = 0xFFFF & ((z->regIX & 0xFF00) | (result)); break;
         case IYh: z->regIY = 0xFFFF & ((result << 8) | (z->regIY & 0xFF)); break;
         case IYl: z->regIY = 0xFFFF & ((z->regIY & 0xFF00) | (result)); break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), result); break;
+        case aHL: writeToMemory(z, z->regHL, result); break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), result); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), result); break;
-        case BC: z->regB = 0xFF & (result >> 8);
-                 z->regC = 0xFF & result; break;
-        case DE: z->regD = 0xFF & (result >> 8);
-                 z->regE = 0xFF & result; break;
-        case HL: z->regH = 0xFF & (result >> 8);
-                 z->regL = 0xFF & result; break;
+        case BC: z->regBC = 0xFFFF & result; break;
+        case DE: z->regDE = 0xFFFF & result; break;
+        case HL: z->regHL = 0xFFFF & result; break;
         case SP: writeStackPointer(z, result); break;
         case IX: z->regIX = result; break;
         case IY: z->regIY = result; break;
@@ -3639,7 +5061,7 @@ static void INC(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the IN instructions */
-static void IN(Z80 z, cpuVal destination, cpuVal source)
+Z80_SPECIALISED void IN(Z80 z, cpuVal destination, cpuVal source)
 {
     /* define variables */
     emuint address = 0;
@@ -3647,11 +5069,9 @@ static void IN(Z80 z, cpuVal destination, cpuVal source)
     
     /* formulate address and obtain byte from it */
     switch (source) {
-        case aC: address = z->regC;
-                 address = 0xFFFF & ((z->regB << 8) | (address & 0xFF));
+        case aC: address = z->regBC;
                  temp = readFromIO(z, address); break;
-        case a_n: address = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case a_n: address = fetchOperand(z);
                   address = 0xFFFF & ((z->regA << 8) | (address & 0xFF));
                   temp = readFromIO(z, address);
                   break;
@@ -3662,11 +5082,7 @@ static void IN(Z80 z, cpuVal destination, cpuVal source)
     switch (source) {
         case a_n: z->cycles = 11; break;
         default: z->cycles = 12;
-                 calculateSFlag(z, temp);
-                 calculateZFlag(z, temp);
-                 setHFlag(z, false);
-                 calculatePVFlag(z, temp);
-                 setNFlag(z, false);
+                 z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | szpFlags[temp];
                  break;
     }
     
@@ -3684,18 +5100,16 @@ static void IN(Z80 z, cpuVal destination, cpuVal source)
 }
 
 /* this function emulates all of the OUT instructions */
-static void OUT(Z80 z, cpuVal destination, cpuVal source)
+Z80_SPECIALISED void OUT(Z80 z, cpuVal destination, cpuVal source)
 {
     /* define variables */
     emuint address = 0;
     
     /* formulate address and obtain byte from it */
     switch (destination) {
-        case aC: address = z->regC;
-                 address = 0xFFFF & ((z->regB << 8) | (address & 0xFF));
+        case aC: address = z->regBC;
                  break;
-        case a_n: address = readFromMemory(z, readProgramCounter(z));
-                  incrementProgramCounter(z);
+        case a_n: address = fetchOperand(z);
                   address = 0xFFFF & ((z->regA << 8) | (address & 0xFF));
                   break;
         default: break;
@@ -3724,8 +5138,8 @@ static void OUT(Z80 z, cpuVal destination, cpuVal source)
 static void IND(Z80 z)
 {
     /* define variables */
-    emuint address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+    emuint address = z->regBC;
+    emuint tempHL = z->regHL;
     emubyte temp = readFromIO(z, address);
     
     /* write byte to (HL) */
@@ -3736,12 +5150,10 @@ static void IND(Z80 z)
     tempHL = 0xFFFF & (tempHL - 1);
 
     /* store HL back into constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
+    z->regHL = 0xFFFF & tempHL;
     
     /* deal with flags */
-    calculateZFlag(z, z->regB);
-    setNFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xBD)) | (z->regB == 0 ? 0x42 : 0x02);
     
     /* set cycle count */
     z->cycles = 16;
@@ -3750,43 +5162,45 @@ static void IND(Z80 z)
 /* this function emulates the INDR instruction */
 static void INDR(Z80 z)
 {
-    /* define variables */
-    emuint address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte temp = readFromIO(z, address);
-    
-    /* write byte to (HL) */
-    writeToMemory(z, tempHL, temp);
-    
-    /* decrement B register and HL */
-    z->regB = 0xFF & (z->regB - 1);
-    tempHL = 0xFFFF & (tempHL - 1);
-
-    /* store HL back into constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    
-    /* deal with flags */
-    setZFlag(z, true);
-    setNFlag(z, true);
-    
-    /* check value of reg B and act accordingly, repeating
-       instruction if necessary */
-    if ((z->regB & 0xFF) == 0) {
-        z->cycles = 16;
-    } else {
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-        z->cycles = 21;
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define variables */
+        emuint address = z->regBC;
+        emuint tempHL = z->regHL;
+        emubyte temp = readFromIO(z, address);
+
+        /* write byte to (HL) */
+        writeToMemory(z, tempHL, temp);
+
+        /* decrement B register and HL */
+        z->regB = 0xFF & (z->regB - 1);
+        tempHL = 0xFFFF & (tempHL - 1);
+
+        /* store HL back into constituent registers */
+        z->regHL = 0xFFFF & tempHL;
+
+        /* deal with flags */
+        z->regF |= 0x42;
+
+        /* check value of reg B and act accordingly, repeating
+           instruction if necessary */
+        if ((z->regB & 0xFF) == 0) {
+            z->cycles = 16;
+        } else {
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+            z->cycles = 21;
+        }
+    } while ((z->cycles == 21) && console_isBlockIOPort(z->ms, z->regBC) && isDirectWrite(z, z->regHL) && repeatBlockInstruction(z, 0xBA));
 }
 
 /* this function emulates the INI instruction */
 static void INI(Z80 z)
 {
     /* define variables */
-    emuint address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+    emuint address = z->regBC;
+    emuint tempHL = z->regHL;
     emubyte temp = readFromIO(z, address);
     
     /* write byte to (HL) */
@@ -3797,12 +5211,10 @@ static void INI(Z80 z)
     tempHL = 0xFFFF & (tempHL + 1);
 
     /* store HL back into constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
+    z->regHL = 0xFFFF & tempHL;
     
     /* deal with flags */
-    calculateZFlag(z, z->regB);
-    setNFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xBD)) | (z->regB == 0 ? 0x42 : 0x02);
     
     /* set cycle count */
     z->cycles = 16;
@@ -3811,42 +5223,44 @@ static void INI(Z80 z)
 /* this function emulates the INIR instruction */
 static void INIR(Z80 z)
 {
-    /* define variables */
-    emuint address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte temp = readFromIO(z, address);
-    
-    /* write byte to (HL) */
-    writeToMemory(z, tempHL, temp);
-    
-    /* decrement B register and increment HL */
-    z->regB = 0xFF & (z->regB - 1);
-    tempHL = 0xFFFF & (tempHL + 1);
-
-    /* store HL back into constituent registers */
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    
-    /* deal with flags */
-    setZFlag(z, true);
-    setNFlag(z, true);
-    
-    /* check value of reg B and act accordingly, repeating
-       instruction if necessary */
-    if ((z->regB & 0xFF) == 0) {
-        z->cycles = 16;
-    } else {
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-        z->cycles = 21;
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define variables */
+        emuint address = z->regBC;
+        emuint tempHL = z->regHL;
+        emubyte temp = readFromIO(z, address);
+
+        /* write byte to (HL) */
+        writeToMemory(z, tempHL, temp);
+
+        /* decrement B register and increment HL */
+        z->regB = 0xFF & (z->regB - 1);
+        tempHL = 0xFFFF & (tempHL + 1);
+
+        /* store HL back into constituent registers */
+        z->regHL = 0xFFFF & tempHL;
+
+        /* deal with flags */
+        z->regF |= 0x42;
+
+        /* check value of reg B and act accordingly, repeating
+           instruction if necessary */
+        if ((z->regB & 0xFF) == 0) {
+            z->cycles = 16;
+        } else {
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+            z->cycles = 21;
+        }
+    } while ((z->cycles == 21) && console_isBlockIOPort(z->ms, z->regBC) && isDirectWrite(z, z->regHL) && repeatBlockInstruction(z, 0xB2));
 }
 
 /* this function emulates the OUTD instruction */
 static void OUTD(Z80 z)
 {
     /* define variables */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+    emuint tempHL = z->regHL;
     emubyte temp = readFromMemory(z, tempHL);
     emuint address = 0;
     
@@ -3854,17 +5268,15 @@ static void OUTD(Z80 z)
     z->regB = 0xFF & (z->regB - 1);
     
     /* formulate address and write byte to it */
-    address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+    address = z->regBC;
     writeToIO(z, address, temp);
     
     /* decrement HL then write it back to its constituent registers */
     tempHL = 0xFFFF & (tempHL - 1);
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
+    z->regHL = 0xFFFF & tempHL;
     
     /* deal with flags */
-    calculateZFlag(z, z->regB);
-    setNFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xBD)) | (z->regB == 0 ? 0x42 : 0x02);
     
     /* set cycle count */
     z->cycles = 16;
@@ -3873,43 +5285,45 @@ static void OUTD(Z80 z)
 /* this function emulates the OTDR instruction */
 static void OTDR(Z80 z)
 {
-    /* define variables */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte temp = readFromMemory(z, tempHL);
-    emuint address = 0;
-    
-    /* decrement reg B */
-    z->regB = 0xFF & (z->regB - 1);
-    
-    /* formulate address and write byte to it */
-    address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    writeToIO(z, address, temp);
-    
-    /* decrement HL then write it back to its constituent registers */
-    tempHL = 0xFFFF & (tempHL - 1);
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    
-    /* deal with flags */
-    setZFlag(z, true);
-    setNFlag(z, true);
-    
-    /* check value of reg B and act accordingly, repeating
-       instruction if necessary */
-    if ((z->regB & 0xFF) == 0) {
-        z->cycles = 16;
-    } else {
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-        z->cycles = 21;
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define variables */
+        emuint tempHL = z->regHL;
+        emubyte temp = readFromMemory(z, tempHL);
+        emuint address = 0;
+
+        /* decrement reg B */
+        z->regB = 0xFF & (z->regB - 1);
+
+        /* formulate address and write byte to it */
+        address = z->regBC;
+        writeToIO(z, address, temp);
+
+        /* decrement HL then write it back to its constituent registers */
+        tempHL = 0xFFFF & (tempHL - 1);
+        z->regHL = 0xFFFF & tempHL;
+
+        /* deal with flags */
+        z->regF |= 0x42;
+
+        /* check value of reg B and act accordingly, repeating
+           instruction if necessary */
+        if ((z->regB & 0xFF) == 0) {
+            z->cycles = 16;
+        } else {
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+            z->cycles = 21;
+        }
+    } while ((z->cycles == 21) && isDirectRead(z, z->regHL) && console_isBlockIOPort(z->ms, z->regBC) && repeatBlockInstruction(z, 0xBB));
 }
 
 /* this function emulates the OUTI instruction */
 static void OUTI(Z80 z)
 {
     /* define variables */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+    emuint tempHL = z->regHL;
     emubyte temp = readFromMemory(z, tempHL);
     emuint address = 0;
     
@@ -3917,17 +5331,15 @@ static void OUTI(Z80 z)
     z->regB = 0xFF & (z->regB - 1);
     
     /* formulate address and write byte to it */
-    address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
+    address = z->regBC;
     writeToIO(z, address, temp);
     
     /* increment HL then write it back to its constituent registers */
     tempHL = 0xFFFF & (tempHL + 1);
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
+    z->regHL = 0xFFFF & tempHL;
     
     /* deal with flags */
-    calculateZFlag(z, z->regB);
-    setNFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xBD)) | (z->regB == 0 ? 0x42 : 0x02);
     
     /* set cycle count */
     z->cycles = 16;
@@ -3936,40 +5348,42 @@ static void OUTI(Z80 z)
 /* this function emulates the OTIR instruction */
 static void OTIR(Z80 z)
 {
-    /* define variables */
-    emuint tempHL = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
-    emubyte temp = readFromMemory(z, tempHL);
-    emuint address = 0;
-    
-    /* decrement reg B */
-    z->regB = 0xFF & (z->regB - 1);
-    
-    /* formulate address and write byte to it */
-    address = 0xFFFF & ((z->regB << 8) | (z->regC & 0xFF));
-    writeToIO(z, address, temp);
-    
-    /* decrement HL then write it back to its constituent registers */
-    tempHL = 0xFFFF & (tempHL + 1);
-    z->regH = 0xFF & (tempHL >> 8);
-    z->regL = 0xFF & tempHL;
-    
-    /* deal with flags */
-    setZFlag(z, true);
-    setNFlag(z, true);
-    
-    /* check value of reg B and act accordingly, repeating
-       instruction if necessary */
-    if ((z->regB & 0xFF) == 0) {
-        z->cycles = 16;
-    } else {
-        decrementProgramCounter(z);
-        decrementProgramCounter(z);
-        z->cycles = 21;
-    }
+    /* each pass of this loop is one iteration of the instruction - further iterations
+       are run straight away while the memory and ports involved are plain ones */
+    do {
+        /* define variables */
+        emuint tempHL = z->regHL;
+        emubyte temp = readFromMemory(z, tempHL);
+        emuint address = 0;
+
+        /* decrement reg B */
+        z->regB = 0xFF & (z->regB - 1);
+
+        /* formulate address and write byte to it */
+        address = z->regBC;
+        writeToIO(z, address, temp);
+
+        /* decrement HL then write it back to its constituent registers */
+        tempHL = 0xFFFF & (tempHL + 1);
+        z->regHL = 0xFFFF & tempHL;
+
+        /* deal with flags */
+        z->regF |= 0x42;
+
+        /* check value of reg B and act accordingly, repeating
+           instruction if necessary */
+        if ((z->regB & 0xFF) == 0) {
+            z->cycles = 16;
+        } else {
+            decrementProgramCounter(z);
+            decrementProgramCounter(z);
+            z->cycles = 21;
+        }
+    } while ((z->cycles == 21) && isDirectRead(z, z->regHL) && console_isBlockIOPort(z->ms, z->regBC) && repeatBlockInstruction(z, 0xB3));
 }
 
 /* this function emulates all of the conditional JP instructions */
-static void JP_CONDITIONAL(Z80 z, cpuVal value)
+Z80_SPECIALISED void JP_CONDITIONAL(Z80 z, cpuVal value)
 {
     /* define variables to hold correct bitmask and expected result,
        as well as the new address */
@@ -3990,47 +5404,51 @@ static void JP_CONDITIONAL(Z80 z, cpuVal value)
     }
     
     /* read in new program counter address */
-    newAddress = readFromMemory(z, readProgramCounter(z));
-    incrementProgramCounter(z);
-    newAddress = 0xFFFF & ((readFromMemory(z, readProgramCounter(z)) << 8) | (newAddress & 0xFF));
-    incrementProgramCounter(z);
-    
-    /* run conditional test and act accordingly */
-    if ((z->regF & bitmask) == expected_result)
-        writeProgramCounter(z, newAddress);
+    newAddress = fetchOperand(z);
+    newAddress = 0xFFFF & ((fetchOperand(z) << 8) | (newAddress & 0xFF));
     
     /* set cycle count */
     z->cycles = 10;
+
+    /* run conditional test and act accordingly - a backward jump could be the end of an idle loop */
+    if ((z->regF & bitmask) == expected_result) {
+        if (newAddress < readProgramCounter(z))
+            checkIdleLoop(z, newAddress);
+        writeProgramCounter(z, newAddress);
+    }
 }
 
 /* this function emulates all of the non-conditional JP instructions */
-static void JP(Z80 z, cpuVal value)
+Z80_SPECIALISED void JP(Z80 z, cpuVal value)
 {
     /* define variables */
     emuint newAddress = 0;
     
     /* formulate address correctly and set cycle count */
     switch (value) {
-        case HL: newAddress = 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF));
+        case HL: newAddress = z->regHL;
                  z->cycles = 4; break;
         case IX: newAddress = z->regIX;
                  z->cycles = 8; break;
         case IY: newAddress = z->regIY;
                  z->cycles = 8; break;
-        case nn: newAddress = readFromMemory(z, readProgramCounter(z));
-                 incrementProgramCounter(z);
-                 newAddress = 0xFFFF & ((readFromMemory(z, readProgramCounter(z)) << 8)
+        case nn: newAddress = fetchOperand(z);
+                 newAddress = 0xFFFF & ((fetchOperand(z) << 8)
                                        | (newAddress & 0xFF));
                  z->cycles = 10; break;
         default: break;
     }
     
+    /* a backward jump to a fixed address could be the end of an idle loop */
+    if (value == nn && newAddress < readProgramCounter(z))
+        checkIdleLoop(z, newAddress);
+
     /* store new address to program counter */
     writeProgramCounter(z, newAddress);
 }
 
 /* this function emulates all the conditional JR e instructions */
-static void JR_CONDITIONAL(Z80 z, cpuVal value)
+Z80_SPECIALISED void JR_CONDITIONAL(Z80 z, cpuVal value)
 {
     /* define variables to hold correct bitmask and expected result,
        as well as the new address and adjustment value */
@@ -4048,14 +5466,15 @@ static void JR_CONDITIONAL(Z80 z, cpuVal value)
     }
     
     /* read in adjustment value and create new program counter address */
-    adjustment = readFromMemory(z, readProgramCounter(z));
-    incrementProgramCounter(z);
+    adjustment = fetchOperand(z);
     tempPC = 0xFFFF & (readProgramCounter(z) + adjustment);
     
     /* run conditional test and branch accordingly */
     if ((z->regF & bitmask) == expected_result) {
         writeProgramCounter(z, tempPC);
         z->cycles = 12;
+        if (adjustment < 0)
+            checkIdleLoop(z, tempPC);
     } else {
         z->cycles = 7;
     }
@@ -4068,12 +5487,15 @@ static void JR(Z80 z)
     signed_emubyte adjustment = 0;
     
     /* read in adjustment value and update program counter */
-    adjustment = readFromMemory(z, readProgramCounter(z));
-    incrementProgramCounter(z);
+    adjustment = fetchOperand(z);
     writeProgramCounter(z, 0xFFFF & (readProgramCounter(z) + adjustment));
     
     /* set cycle count */
     z->cycles = 12;
+
+    /* a backward jump could be the end of an idle loop */
+    if (adjustment < 0)
+        checkIdleLoop(z, readProgramCounter(z));
 }
 
 /* this function emulates the RETI instruction */
@@ -4114,10 +5536,10 @@ static void RETN(Z80 z)
 }
 
 /* this function emulates all of the RL instructions */
-static void RL(Z80 z, cpuVal value)
+Z80_SPECIALISED void RL(Z80 z, cpuVal value)
 {
     /* define variables */
-    emubyte temp = 0, tempCarry = 0;
+    emubyte temp = 0, tempCarry = 0, newCarry = 0;
     signed_emubyte d = 0;
     
     /* determine which value to retrieve, and set cycle count */
@@ -4136,12 +5558,12 @@ static void RL(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
@@ -4150,22 +5572,15 @@ static void RL(Z80 z, cpuVal value)
     /* store previous carry flag */
     tempCarry = 0x01 & z->regF;
     
-    /* store bit 7 of retrieved value into carry flag */
-    if ((temp & 0x80) == 128)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* store bit 7 of retrieved value as the new carry flag */
+    newCarry = temp >> 7;
     
     /* rotate value left 1 bit and merge in previous carry bit */
     temp = temp << 1;
     temp = (temp & 0xFE) | tempCarry;
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[temp] | newCarry;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4176,7 +5591,7 @@ static void RL(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4200,15 +5615,10 @@ static void RLA(Z80 z)
     /* rotate temp A left 1 bit, and copy previous bit 7 to carry flag, as
        well as previous carry to bit 0 */
     tempA = tempA << 1;
-    if ((tempA & 0x100) == 256)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
-    tempA = (tempA & 0xFE) | tempCarry;
+    tempA = (tempA & 0x1FE) | tempCarry;
     
-    /* deal with flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
+    /* deal with flags, taking the new carry flag from bit 8 */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xEC)) | (tempA >> 8);
     
     /* store value back to reg A */
     z->regA = 0xFF & tempA;
@@ -4218,7 +5628,7 @@ static void RLA(Z80 z)
 }
 
 /* this function emulates all of the RLC instructions */
-static void RLC(Z80 z, cpuVal value)
+Z80_SPECIALISED void RLC(Z80 z, cpuVal value)
 {
     /* define variables */
     emubyte temp = 0, tempBit = 0;
@@ -4240,24 +5650,18 @@ static void RLC(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
     }
     
-    /* store bit 7 of retrieved value into carry flag */
-    if ((temp & 0x80) == 128)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
-    
-    /* copy bit 7 to tempBit */
+    /* copy bit 7 to tempBit, which also becomes the new carry flag */
     tempBit = 0x80 & temp;
     tempBit = tempBit >> 7;
     
@@ -4266,11 +5670,7 @@ static void RLC(Z80 z, cpuVal value)
     temp = (temp & 0xFE) | tempBit;
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[temp] | tempBit;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4281,7 +5681,7 @@ static void RLC(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4301,16 +5701,11 @@ static void RLCA(Z80 z)
     
     /* rotate left 1 bit, and copy previous bit 7 to carry flag and bit 0 */
     tempA = tempA << 1;
-    if ((tempA & 0x100) == 256)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
     tempBit = 0x01 & (tempA >> 8);
     tempA = (tempA & 0xFE) | tempBit;
     
     /* deal with flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xEC)) | tempBit;
     
     /* store value back to reg A */
     z->regA = 0xFF & tempA;
@@ -4323,7 +5718,7 @@ static void RLCA(Z80 z)
 static void RLD(Z80 z)
 {
     /* define variables */
-    emuint tempMem = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+    emuint tempMem = readFromMemory(z, z->regHL);
     emubyte tempA = z->regA;
     emuint tempHigh = 0;
     
@@ -4341,25 +5736,21 @@ static void RLD(Z80 z)
     tempA = (tempA & 0xF0) | tempHigh;
     
     /* deal with flags */
-    calculateSFlag(z, tempA);
-    calculateZFlag(z, tempA);
-    setHFlag(z, false);
-    calculatePVFlag(z, tempA);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | szpFlags[0xFF & tempA];
     
     /* store values back to reg A and (HL) */
     z->regA = 0xFF & tempA;
-    writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), 0xFF & tempMem);
+    writeToMemory(z, z->regHL, 0xFF & tempMem);
     
     /* set cycle count */
     z->cycles = 18;
 }
 
 /* this function emulates the RR instructions */
-static void RR(Z80 z, cpuVal value)
+Z80_SPECIALISED void RR(Z80 z, cpuVal value)
 {
     /* define variables */
-    emubyte temp = 0, tempCarry = 0;
+    emubyte temp = 0, tempCarry = 0, newCarry = 0;
     signed_emubyte d = 0;
     
     /* determine which value to retrieve, and set cycle count */
@@ -4378,12 +5769,12 @@ static void RR(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
@@ -4393,22 +5784,15 @@ static void RR(Z80 z, cpuVal value)
     tempCarry = 0x01 & z->regF;
     tempCarry = tempCarry << 7;
     
-    /* store bit 0 of retrieved value into carry flag */
-    if ((temp & 0x01) == 1)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* store bit 0 of retrieved value as the new carry flag */
+    newCarry = temp & 0x01;
     
     /* rotate value right 1 bit and merge in previous carry */
     temp = temp >> 1;
     temp = tempCarry | (temp & 0x7F);
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[temp] | newCarry;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4419,7 +5803,7 @@ static void RR(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4434,20 +5818,13 @@ static void RRA(Z80 z)
     emubyte tempA = z->regA, tempCarry = 0x01 & z->regF;
     tempCarry = tempCarry << 7;
 
-    /* copy bit 0 to cary flag before rotation */
-    if ((tempA & 0x01) == 1)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* copy bit 0 to carry flag before rotation, and reset H and N flags */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xEC)) | (tempA & 0x01);
     
     /* rotate 1 bit to the right, and merge previous carry value */
     tempA = tempA >> 1;
     tempA = tempCarry | (tempA & 0x7F);
     
-    /* deal with flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    
     /* store value back into reg A */
     z->regA = 0xFF & tempA;
 
@@ -4456,7 +5833,7 @@ static void RRA(Z80 z)
 }
 
 /* this function emulates all of the RRC instructions */
-static void RRC(Z80 z, cpuVal value)
+Z80_SPECIALISED void RRC(Z80 z, cpuVal value)
 {
     /* define variables */
     emubyte temp = 0, tempBit = 0;
@@ -4478,24 +5855,19 @@ static void RRC(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
     }
     
-    /* copy bit 0 to carry flag and temporary variable, adjusting temporary variable
-       for merging */
+    /* copy bit 0 to temporary variable, adjusting temporary variable for merging */
     tempBit = 0x01 & temp;
-    if (tempBit == 1)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
     tempBit = tempBit << 7;
     
     /* rotate value right 1 bit and merge in previous bit 0 into bit 7 */
@@ -4503,11 +5875,7 @@ static void RRC(Z80 z, cpuVal value)
     temp = tempBit | (temp & 0x7F);
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[temp] | (tempBit >> 7);
     
     /* store value back to relevant location */
     switch (value) {
@@ -4518,7 +5886,7 @@ static void RRC(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4532,21 +5900,15 @@ static void RRCA(Z80 z)
     /* retrieve reg A and copy its bit 0 to a temporary variable */
     emubyte tempA = z->regA, tempBit = z->regA & 0x01;
     
-    /* copy bit 0 to carry flag and adjust it in preparation for replacing bit 7 */
-    if (tempBit == 1)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* copy bit 0 to carry flag and adjust it in preparation for replacing bit 7,
+       resetting H and N flags too */
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xEC)) | tempBit;
     tempBit = tempBit << 7;
     
     /* rotate temp A right 1 bit, and copy previous bit 0 to bit 7 */
     tempA = tempA >> 1;
     tempA = tempBit | (0x7F & tempA);
     
-    /* deal with flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    
     /* store value back into reg A */
     z->regA = 0xFF & tempA;
     
@@ -4559,7 +5921,7 @@ static void RRD(Z80 z)
 {
     /* retrieve reg A and (HL) */
     emubyte tempA = z->regA;
-    emubyte tempMem = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+    emubyte tempMem = readFromMemory(z, z->regHL);
     
     /* copy lower four bits of accumulator to temporary variable and adjust them */
     emubyte tempNibble = 0x0F & tempA;
@@ -4573,25 +5935,21 @@ static void RRD(Z80 z)
     tempMem = (tempNibble & 0xF0) | tempMem;
     
     /* deal with flags */
-    calculateSFlag(z, tempA);
-    calculateZFlag(z, tempA);
-    setHFlag(z, false);
-    calculatePVFlag(z, tempA);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x29)) | szpFlags[0xFF & tempA];
     
     /* store values back to accumulator and (HL) */
     z->regA = tempA;
-    writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), tempMem);
+    writeToMemory(z, z->regHL, tempMem);
     
     /* set cycle count */
     z->cycles = 18;
 }
 
 /* this function emulates all of the SLA instructions */
-static void SLA(Z80 z, cpuVal value)
+Z80_SPECIALISED void SLA(Z80 z, cpuVal value)
 {
     /* define variables */
-    emubyte temp = 0;
+    emubyte temp = 0, newCarry = 0;
     signed_emubyte d = 0;
     
     /* determine which value to retrieve, and set cycle count */
@@ -4610,32 +5968,25 @@ static void SLA(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
     }
     
-    /* copy bit 7 to carry flag */
-    if ((temp & 0x80) == 128)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* copy bit 7 to the new carry flag */
+    newCarry = temp >> 7;
     
     /* move value left 1 bit */
     temp = temp << 1;
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[temp] | newCarry;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4646,7 +5997,7 @@ static void SLA(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4655,10 +6006,10 @@ static void SLA(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the SLL instructions */
-static void SLL(Z80 z, cpuVal value)
+Z80_SPECIALISED void SLL(Z80 z, cpuVal value)
 {
     /* define variables */
-    emubyte temp = 0;
+    emubyte temp = 0, newCarry = 0;
     signed_emubyte d = 0;
     
     /* determine which value to retrieve, and set cycle count */
@@ -4677,22 +6028,19 @@ static void SLL(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
     }
     
-    /* copy bit 7 to carry flag */
-    if ((temp & 0x80) == 128)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* copy bit 7 to the new carry flag */
+    newCarry = temp >> 7;
     
     /* move value left 1 bit */
     temp = temp << 1;
@@ -4701,11 +6049,7 @@ static void SLL(Z80 z, cpuVal value)
     temp = temp | 0x01;
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    setZFlag(z, false);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | (szpFlags[temp] & 0xBF) | newCarry;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4716,7 +6060,7 @@ static void SLL(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4725,10 +6069,10 @@ static void SLL(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the SRA instructions */
-static void SRA(Z80 z, cpuVal value)
+Z80_SPECIALISED void SRA(Z80 z, cpuVal value)
 {
     /* define variables */
-    emubyte temp = 0, tempBit = 0;
+    emubyte temp = 0, tempBit = 0, newCarry = 0;
     signed_emubyte d = 0;
     
     /* determine which value to retrieve, and set cycle count */
@@ -4747,22 +6091,19 @@ static void SRA(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
     }
     
-    /* copy bit 0 to carry flag, and bit 7 to tempBit variable */
-    if ((temp & 0x01) == 1)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* copy bit 0 to the new carry flag, and bit 7 to tempBit variable */
+    newCarry = temp & 0x01;
     tempBit = 0x80 & temp;
     
     /* shift value right 1 bit, and merge in previous value of bit 7 */
@@ -4770,11 +6111,7 @@ static void SRA(Z80 z, cpuVal value)
     temp = tempBit | (temp & 0x7F);
     
     /* deal with flags */
-    calculateSFlag(z, temp);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | szpFlags[temp] | newCarry;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4785,7 +6122,7 @@ static void SRA(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4794,10 +6131,10 @@ static void SRA(Z80 z, cpuVal value)
 }
 
 /* this function emulates all of the SRL instructions */
-static void SRL(Z80 z, cpuVal value)
+Z80_SPECIALISED void SRL(Z80 z, cpuVal value)
 {
     /* define variables */
-    emubyte temp = 0;
+    emubyte temp = 0, newCarry = 0;
     signed_emubyte d = 0;
     
     /* determine which value to retrieve, and set cycle count */
@@ -4816,32 +6153,25 @@ static void SRL(Z80 z, cpuVal value)
                 z->cycles = 8; break;
         case L: temp = z->regL;
                 z->cycles = 8; break;
-        case aHL: temp = readFromMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)));
+        case aHL: temp = readFromMemory(z, z->regHL);
                   z->cycles = 15; break;
-        case IXd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IXd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIX + d));
                   z->cycles = 23; break;
-        case IYd: d = readFromMemory(z, readProgramCounter(z) - 2);
+        case IYd: d = readIndexedCbDisplacement(z);
                   temp = readFromMemory(z, 0xFFFF & (z->regIY + d));
                   z->cycles = 23; break;
         default: break;
     }
     
-    /* copy bit 0 to carry flag */
-    if ((temp & 0x01) == 1)
-        setCFlag(z, true);
-    else
-        setCFlag(z, false);
+    /* copy bit 0 to the new carry flag */
+    newCarry = temp & 0x01;
     
     /* shift value right 1 bit */
     temp = temp >> 1;
     
     /* deal with flags */
-    setSFlag(z, false);
-    calculateZFlag(z, temp);
-    setHFlag(z, false);
-    calculatePVFlag(z, temp);
-    setNFlag(z, false);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0x28)) | (szpFlags[temp] & 0x7F) | newCarry;
     
     /* store value back to relevant location */
     switch (value) {
@@ -4852,7 +6182,7 @@ static void SRL(Z80 z, cpuVal value)
         case E: z->regE = temp; break;
         case H: z->regH = temp; break;
         case L: z->regL = temp; break;
-        case aHL: writeToMemory(z, 0xFFFF & ((z->regH << 8) | (z->regL & 0xFF)), temp);
+        case aHL: writeToMemory(z, z->regHL, temp);
                   break;
         case IXd: writeToMemory(z, 0xFFFF & (z->regIX + d), temp); break;
         case IYd: writeToMemory(z, 0xFFFF & (z->regIY + d), temp); break;
@@ -4864,9 +6194,7 @@ static void SRL(Z80 z, cpuVal value)
 static void SCF(Z80 z)
 {
     /* deal with flags */
-    setHFlag(z, false);
-    setNFlag(z, false);
-    setCFlag(z, true);
+    z->regF = (z->regF & Z80_KEEP_FLAGS(0xEC)) | 0x01;
     
     /* set cycle count */
     z->cycles = 4;
@@ -4934,7 +6262,7 @@ emubyte *Z80_saveState(Z80 z)
     z80State[marker++] = z->regSP & 0xFF;
     z80State[marker++] = (z->regSP >> 8) & 0xFF;
     z80State[marker++] = z->regI;
-    z80State[marker++] = z->regR;
+    z80State[marker++] = readRefreshRegister(z);
     z80State[marker++] = z->regPC & 0xFF;
     z80State[marker++] = (z->regPC >> 8) & 0xFF;
 
@@ -4952,8 +6280,451 @@ emubyte *Z80_saveState(Z80 z)
     return z80State;
 }
 
+/* this function runs instructions in a tight loop until at least the specified number
+   of cycles have been executed, returning the number of cycles actually executed - other
+   devices are left to catch up afterwards, or via Z80_collectPendingCycles during the run */
+emuint Z80_run(Z80 z, emuint cycles)
+{
+    /* start a new run - loops seen in the last run can't be carried over, as the values
+       they poll may have changed in between */
+    z->runCycles = 0;
+    z->runTarget = cycles;
+    z->syncedCycles = 0;
+    z->idleLoopTarget = Z80_NO_IDLE_LOOP;
+
+    /* execute instructions until the cycle budget is used up */
+    while (z->runCycles < cycles)
+        z->runCycles += Z80_executeInstruction(z);
+
+    /* stop block instructions repeating outside of a run */
+    z->runTarget = 0;
+#if defined(FAST_PROFILE)
+    z->refreshCycles += z->runCycles;
+#endif
+
+    return z->runCycles;
+}
+
+/* this function returns the current value of the program counter */
+emuint Z80_getProgramCounter(Z80 z)
+{
+    return readProgramCounter(z);
+}
+
+/* this function is called by the console's scheduler to pass on a change in the state of the
+   maskable interrupt line, which the Z80 then sees from the start of its next instruction */
+void Z80_setInterruptLine(Z80 z, emubool asserted)
+{
+    z->interruptLine = asserted;
+}
+
+/* this function is called by the console's scheduler to trigger a non-maskable interrupt,
+   which the Z80 takes at the start of its next instruction */
+void Z80_raiseNmi(Z80 z)
+{
+    z->nmi = 1;
+}
+
+/* this function returns the number of cycles executed by the current (or most recent) run
+   that have not yet been passed on to other devices, and marks them as passed on */
+emuint Z80_collectPendingCycles(Z80 z)
+{
+    emuint pending = z->runCycles - z->syncedCycles;
+    z->syncedCycles = z->runCycles;
+    return pending;
+}
+
+#if defined(Z80_PROFILER)
+/* this struct is one line of the opcode profiler's report */
+struct ProfileEntry {
+    emubyte table;
+    emubyte opcode;
+    emulong count;
+    emulong cycles;
+};
+
+/* this function adds the instruction that has just finished to the opcode profiler - the cycles
+   of interrupts and the HALT state aren't counted, and idle loop passes skipped through count
+   towards the jump at the end of the loop */
+static void recordOpcodeProfile(Z80 z)
+{
+    if (z->profileTable == OPCODE_TABLE_COUNT)
+        return;
+
+    ++z->profileCounts[z->profileTable][z->profileOpcode];
+    z->profileCycles[z->profileTable][z->profileOpcode] += z->cycles;
+}
+
+/* this function orders profile entries by total cycles, highest first */
+static int compareProfileEntries(const void *first, const void *second)
+{
+    const struct ProfileEntry *a = (const struct ProfileEntry *)first;
+    const struct ProfileEntry *b = (const struct ProfileEntry *)second;
+
+    if (a->cycles != b->cycles)
+        return a->cycles > b->cycles ? -1 : 1;
+    if (a->count != b->count)
+        return a->count > b->count ? -1 : 1;
+    return 0;
+}
+
+/* this function clears the counts held by the opcode profiler */
+void Z80_resetProfile(Z80 z)
+{
+    z->profileTable = OPCODE_TABLE_COUNT;
+    z->profileOpcode = 0;
+    memset((void *)z->profileCounts, 0, sizeof(z->profileCounts));
+    memset((void *)z->profileCycles, 0, sizeof(z->profileCycles));
+}
+
+/* this function writes the opcode profiler's counts to the log, sorted so that the opcodes
+   taking the most cycles in total come first */
+void Z80_reportProfile(Z80 z)
+{
+    /* define variables */
+    static const char *const prefixes[OPCODE_TABLE_COUNT] = { "", "CB ", "DD ", "ED ", "FD ", "DD CB ", "FD CB " };
+    emuint entryCount = 0;
+    emulong totalCycles = 0;
+
+    /* allocate space for the report */
+    struct ProfileEntry *entries = malloc(sizeof(struct ProfileEntry) * OPCODE_TABLE_COUNT * 256);
+    if (entries == NULL) {
+        __android_log_print(ANDROID_LOG_ERROR, "z80.c", "Couldn't allocate memory for opcode profile report...\n");
+        return;
+    }
+
+    /* gather up every opcode that has been executed */
+    for (emuint table = 0; table < OPCODE_TABLE_COUNT; ++table) {
+        for (emuint opcode = 0; opcode < 256; ++opcode) {
+            if (z->profileCounts[table][opcode] == 0)
+                continue;
+            entries[entryCount].table = table;
+            entries[entryCount].opcode = opcode;
+            entries[entryCount].count = z->profileCounts[table][opcode];
+            entries[entryCount].cycles = z->profileCycles[table][opcode];
+            totalCycles += entries[entryCount].cycles;
+            ++entryCount;
+        }
+    }
+
+    /* sort and log the report */
+    qsort((void *)entries, entryCount, sizeof(struct ProfileEntry), compareProfileEntries);
+    __android_log_print(ANDROID_LOG_INFO, "z80.c", "Opcode profile: %u opcodes, %llu cycles\n",
+                        entryCount, (unsigned long long)totalCycles);
+    for (emuint i = 0; i < entryCount; ++i) {
+        __android_log_print(ANDROID_LOG_INFO, "z80.c", "%s%02X: %llu executions, %llu cycles (%.2f%%)\n",
+                            prefixes[entries[i].table], entries[i].opcode,
+                            (unsigned long long)entries[i].count, (unsigned long long)entries[i].cycles,
+                            totalCycles == 0 ? 0.0 : 100.0 * (double)entries[i].cycles / (double)totalCycles);
+    }
+
+    /* free report memory */
+    free((void *)entries);
+}
+#endif
+
+#if defined(Z80_TRACE)
+/* this function fills in the trace entry at the head with the state the Z80 is in as it
+   starts an instruction, dumping the trace first if the trigger address has been reached */
+static void beginTraceEntry(Z80 z)
+{
+    /* define variables */
+    emuint address = readProgramCounter(z);
+    struct TraceEntry *entry = &z->trace[z->traceHead & (Z80_TRACE_LENGTH - 1)];
+    emubyte *page;
+
+    /* store the registers and interrupt state */
+    entry->pc = address;
+    entry->af = (z->regA << 8) | z->regF;
+    entry->bc = z->regBC;
+    entry->de = z->regDE;
+    entry->hl = z->regHL;
+    entry->ix = z->regIX;
+    entry->iy = z->regIY;
+    entry->sp = z->regSP;
+    entry->i = z->regI;
+    entry->r = readRefreshRegister(z);
+    entry->flags = (z->nmi ? Z80_TRACE_NMI : 0) | (z->interruptLine ? Z80_TRACE_INTERRUPT_LINE : 0) |
+                   (z->iff1 ? Z80_TRACE_IFF1 : 0) | (z->halt ? Z80_TRACE_HALT : 0);
+    entry->bankState = console_getBankState(z->ms);
+    entry->runCycles = z->runCycles;
+    entry->cycles = 0;
+
+    /* store the opcode bytes that can be read directly - reading through the console
+       could change its bus state, so we stop at the first page that needs that */
+    entry->opcodeCount = 0;
+    while (entry->opcodeCount < 4) {
+        page = z->readPages[(address >> CONSOLE_PAGE_SHIFT) & (CONSOLE_PAGE_COUNT - 1)];
+        if (page == NULL)
+            break;
+        entry->opcodes[entry->opcodeCount++] = page[address & (CONSOLE_PAGE_SIZE - 1)];
+        address = (address + 1) & 0xFFFF;
+    }
+    z->traceOpen = true;
+
+    /* dump the trace, with this instruction last, if it is at the trigger address */
+    if (entry->pc == z->traceTrigger) {
+        z->traceTrigger = Z80_NO_TRACE_TRIGGER;
+        __android_log_print(ANDROID_LOG_INFO, "z80.c", "Reached trace trigger at %04X...\n", entry->pc);
+        Z80_dumpTrace(z);
+    }
+}
+
+/* this function finishes off the trace entry at the head with the cycles the instruction
+   took, and moves the head past it - skipped idle loop passes count towards the jump at the
+   end of the loop, as with the opcode profiler */
+static void endTraceEntry(Z80 z)
+{
+    z->trace[z->traceHead & (Z80_TRACE_LENGTH - 1)].cycles = z->cycles;
+    z->traceOpen = false;
+    if ((z->traceHead & (Z80_TRACE_LENGTH - 1)) == Z80_TRACE_LENGTH - 1)
+        z->traceFull = true;
+    Z80_TRACE_PUBLISH(z, z->traceHead + 1);
+}
+
+/* this function copies text onto the end of a trace line, returning the new end - like the
+   other trace formatting functions it calls nothing that isn't safe inside a signal handler */
+static char *appendTraceText(char *out, const char *text)
+{
+    while (*text != '\0')
+        *out++ = *text++;
+    return out;
+}
+
+/* this function writes a value onto the end of a trace line as the specified number of hex
+   digits, returning the new end */
+static char *appendTraceHex(char *out, emuint value, emuint digits)
+{
+    static const char hexDigits[] = "0123456789ABCDEF";
+    for (emuint i = digits; i > 0; --i)
+        *out++ = hexDigits[(value >> ((i - 1) * 4)) & 0x0F];
+    return out;
+}
+
+/* this function writes a value onto the end of a trace line in decimal, right aligned with
+   spaces to at least the specified width, returning the new end */
+static char *appendTraceDecimal(char *out, emuint value, emuint width)
+{
+    /* define variables */
+    char digits[10];
+    emuint count = 0;
+
+    /* collect the digits lowest first, then write them out the other way round */
+    do {
+        digits[count++] = '0' + (value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (width-- > count)
+        *out++ = ' ';
+    while (count > 0)
+        *out++ = digits[--count];
+    return out;
+}
+
+/* this function formats one trace entry as a line of text, returning its length */
+static emuint formatTraceEntry(struct TraceEntry *entry, emuint number, emubool inProgress, char *line)
+{
+    /* define variables */
+    char *out = line;
+    emuint i;
+
+    out = appendTraceDecimal(out, number, 5);
+    out = appendTraceText(out, ": PC=");
+    out = appendTraceHex(out, entry->pc, 4);
+
+    /* write the opcode bytes, with dashes for any that couldn't be read */
+    out = appendTraceText(out, " [");
+    for (i = 0; i < 4; ++i) {
+        if (i > 0)
+            *out++ = ' ';
+        if (i < entry->opcodeCount)
+            out = appendTraceHex(out, entry->opcodes[i], 2);
+        else
+            out = appendTraceText(out, "--");
+    }
+
+    out = appendTraceText(out, "] AF=");
+    out = appendTraceHex(out, entry->af, 4);
+    out = appendTraceText(out, " BC=");
+    out = appendTraceHex(out, entry->bc, 4);
+    out = appendTraceText(out, " DE=");
+    out = appendTraceHex(out, entry->de, 4);
+    out = appendTraceText(out, " HL=");
+    out = appendTraceHex(out, entry->hl, 4);
+    out = appendTraceText(out, " IX=");
+    out = appendTraceHex(out, entry->ix, 4);
+    out = appendTraceText(out, " IY=");
+    out = appendTraceHex(out, entry->iy, 4);
+    out = appendTraceText(out, " SP=");
+    out = appendTraceHex(out, entry->sp, 4);
+    out = appendTraceText(out, " I=");
+    out = appendTraceHex(out, entry->i, 2);
+    out = appendTraceText(out, " R=");
+    out = appendTraceHex(out, entry->r, 2);
+    *out++ = ' ';
+    if (entry->flags & Z80_TRACE_NMI)
+        out = appendTraceText(out, "nmi ");
+    if (entry->flags & Z80_TRACE_INTERRUPT_LINE)
+        out = appendTraceText(out, "int ");
+    if (entry->flags & Z80_TRACE_IFF1)
+        out = appendTraceText(out, "iff1 ");
+    if (entry->flags & Z80_TRACE_HALT)
+        out = appendTraceText(out, "halt ");
+    out = appendTraceText(out, "banks=");
+    for (i = 0; i < 4; ++i) {
+        if (i > 0)
+            *out++ = '/';
+        out = appendTraceHex(out, entry->bankState >> ((3 - i) * 8), 2);
+    }
+    out = appendTraceText(out, " run=");
+    out = appendTraceDecimal(out, entry->runCycles, 0);
+    out = appendTraceText(out, " cycles=");
+    if (inProgress)
+        out = appendTraceText(out, "in progress");
+    else
+        out = appendTraceDecimal(out, entry->cycles, 0);
+    *out++ = '\n';
+    *out = '\0';
+
+    return out - line;
+}
+
+/* this function writes a formatted line of the trace to the specified file descriptor, or
+   to the log if that is negative - writing to a file descriptor is safe inside a signal
+   handler, whereas logging is not */
+static void writeTraceLine(int fd, const char *line, emuint length)
+{
+    if (fd < 0)
+        __android_log_write(ANDROID_LOG_INFO, "z80.c", line);
+    else if (write(fd, line, length) < 0)
+        return; /* there is nowhere left to report a failure to */
+}
+
+/* this function writes the trace, oldest instruction first, formatting each line into the
+   buffer provided - an instruction still in progress (as when dumping from a crash or the
+   trigger) is written last */
+static void writeTrace(Z80 z, int fd, char *line)
+{
+    /* define variables */
+    emuint head = Z80_TRACE_HEAD(z);
+    emuint count;
+    emuint i;
+    char *out;
+
+    /* the entry at the head is always either in progress or about to be, so a full ring
+       holds one less finished instruction than it has entries */
+    if (z->traceFull)
+        count = Z80_TRACE_LENGTH - 1;
+    else
+        count = head & (Z80_TRACE_LENGTH - 1);
+
+    out = appendTraceText(line, "Instruction trace: ");
+    out = appendTraceDecimal(out, count, 0);
+    out = appendTraceText(out, " instructions\n");
+    *out = '\0';
+    writeTraceLine(fd, line, out - line);
+    for (i = 0; i < count; ++i)
+        writeTraceLine(fd, line, formatTraceEntry(&z->trace[(head - count + i) & (Z80_TRACE_LENGTH - 1)], i, false, line));
+    if (z->traceOpen)
+        writeTraceLine(fd, line, formatTraceEntry(&z->trace[head & (Z80_TRACE_LENGTH - 1)], count, true, line));
+}
+
+/* this function is installed as the handler for crash signals - it writes the trace to the
+   crash trace file opened when the handlers were installed, using only calls that are safe
+   inside a signal handler, then puts back whichever handlers were there before and raises
+   the signal again for them */
+static void dumpTraceOnCrash(int signalNumber)
+{
+    /* define variables */
+    Z80 z = crashTraceZ80;
+    char *out;
+
+    if (z != NULL && crashTraceFd >= 0) {
+        out = appendTraceText(crashTraceLine, "Caught signal ");
+        out = appendTraceDecimal(out, signalNumber, 0);
+        out = appendTraceText(out, ", dumping instruction trace...\n");
+        *out = '\0';
+        writeTraceLine(crashTraceFd, crashTraceLine, out - crashTraceLine);
+        writeTrace(z, crashTraceFd, crashTraceLine);
+        fsync(crashTraceFd);
+    }
+
+    for (emuint i = 0; i < Z80_CRASH_SIGNAL_COUNT; ++i)
+        sigaction(crashSignals[i], &previousCrashActions[i], NULL);
+    crashHandlersInstalled = false;
+    raise(signalNumber);
+}
+
+/* this function turns tracing on or off - entries already in the trace are kept */
+void Z80_setTraceEnabled(Z80 z, emubool enabled)
+{
+    z->traceEnabled = enabled;
+}
+
+/* this function sets the address whose next execution dumps the trace, or turns the
+   trigger off if given Z80_NO_TRACE_TRIGGER */
+void Z80_setTraceTrigger(Z80 z, emuint address)
+{
+    z->traceTrigger = address;
+}
+
+/* this function writes the trace to the log, oldest instruction first - an instruction still
+   in progress (as when dumping from the trigger) is written last */
+void Z80_dumpTrace(Z80 z)
+{
+    /* define variables */
+    char line[Z80_TRACE_LINE_SIZE];
+
+    writeTrace(z, -1, line);
+}
+#endif
+
 /* this function returns the number of bytes required by a Z80 object */
 emuint Z80_getMemoryUsage(void)
 {
     return sizeof(struct Z80) * sizeof(emubyte);
-}
\ No newline at end of file
+}
+
+/* this function fills in the public functions of the profile this file is being built as */
+static void fillProfile(Z80Profile *p)
+{
+    p->create = createZ80;
+    p->destroy = destroyZ80;
+    p->run = Z80_run;
+    p->collectPendingCycles = Z80_collectPendingCycles;
+    p->memoryWritten = Z80_memoryWritten;
+    p->memoryMapChanged = Z80_memoryMapChanged;
+    p->setInterruptLine = Z80_setInterruptLine;
+    p->raiseNmi = Z80_raiseNmi;
+    p->getProgramCounter = Z80_getProgramCounter;
+    p->saveState = Z80_saveState;
+    p->getMemoryUsage = Z80_getMemoryUsage;
+}
+
+#if defined(FAST_PROFILE)
+/* this function hands the fast profile's functions to Z80_selectProfile in the accurate build */
+void Z80Fast_fillProfile(Z80Profile *p)
+{
+    fillProfile(p);
+}
+#else
+/* this function fills in the functions of the fast profile if asked, or the accurate profile otherwise */
+void Z80_selectProfile(Z80Profile *p, emubool fast)
+{
+    if (fast)
+        Z80Fast_fillProfile(p);
+    else
+        fillProfile(p);
+}
+
+/* this function returns the number of bytes required by a Z80 object of either profile, so
+   memory can be set aside before the profile is picked */
+emuint Z80_getLargestMemoryUsage(void)
+{
+    /* define variables */
+    emuint accurate = Z80_getMemoryUsage();
+    emuint fast = Z80Fast_getMemoryUsage();
+
+    return accurate > fast ? accurate : fast;
+}
+#endif
\ No newline at end of file
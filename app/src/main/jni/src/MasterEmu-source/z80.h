@@ -9,11 +9,47 @@
 /* define opaque pointer type for dealing with Z80 */
 typedef struct Z80 *Z80;
 
+/* this struct holds the public functions of one profile of the Z80 - the default accurate profile and
+   the fast profile are compiled from the same source under different names, and the console calls
+   whichever one Z80_selectProfile picks when it is created */
+typedef struct {
+    Z80 (*create)(Console ms, emubyte *z80State, emubool blockCache, emubyte *wholePointer); /* creates Z80 object */
+    void (*destroy)(Z80 z); /* destroys specified Z80 object */
+    emuint (*run)(Z80 z, emuint cycles); /* executes instructions until at least the specified number of cycles have passed */
+    emuint (*collectPendingCycles)(Z80 z); /* returns cycles from the current run not yet passed on to other devices */
+    void (*memoryWritten)(Z80 z, emuint address); /* tells the Z80 about memory writes it didn't make itself */
+    void (*memoryMapChanged)(Z80 z); /* tells the Z80 that the console's memory map has changed */
+    void (*setInterruptLine)(Z80 z, emubool asserted); /* tells the Z80 the state of the maskable interrupt line */
+    void (*raiseNmi)(Z80 z); /* triggers a non-maskable interrupt on the Z80 */
+    emuint (*getProgramCounter)(Z80 z); /* returns the current value of the program counter */
+    emubyte *(*saveState)(Z80 z); /* returns a pointer to the state of the Z80 */
+    emuint (*getMemoryUsage)(void); /* returns how many bytes a Z80 object requires */
+} Z80Profile;
+
 /* function declarations for public use */
-Z80 createZ80(Console ms, emubyte *z80State, emubyte *wholePointer); /* creates Z80 object */
+void Z80_selectProfile(Z80Profile *p, emubool fast); /* fills in the functions of the fast or accurate profile */
+emuint Z80_getLargestMemoryUsage(void); /* returns how many bytes a Z80 object of either profile requires */
+Z80 createZ80(Console ms, emubyte *z80State, emubool blockCache, emubyte *wholePointer); /* creates Z80 object */
 void destroyZ80(Z80 z); /* destroys specified Z80 object */
 emuint Z80_executeInstruction(Z80 z); /* executes a single instruction of the Z80 */
+emuint Z80_run(Z80 z, emuint cycles); /* executes instructions until at least the specified number of cycles have passed */
+emuint Z80_collectPendingCycles(Z80 z); /* returns cycles from the current run not yet passed on to other devices */
+void Z80_memoryWritten(Z80 z, emuint address); /* tells the Z80 about memory writes it didn't make itself */
+void Z80_memoryMapChanged(Z80 z); /* tells the Z80 that the console's memory map has changed */
+void Z80_setInterruptLine(Z80 z, emubool asserted); /* tells the Z80 the state of the maskable interrupt line */
+void Z80_raiseNmi(Z80 z); /* triggers a non-maskable interrupt on the Z80 */
+emuint Z80_getProgramCounter(Z80 z); /* returns the current value of the program counter */
 emubyte *Z80_saveState(Z80 z); /* returns a pointer to the state of the Z80 */
 emuint Z80_getMemoryUsage(void); /* returns how many bytes a Z80 object requires */
+#if defined(Z80_PROFILER)
+void Z80_resetProfile(Z80 z); /* clears the opcode profiler's counts */
+void Z80_reportProfile(Z80 z); /* writes the opcode profiler's counts to the log, busiest opcodes first */
+#endif
+#if defined(Z80_TRACE)
+#define Z80_NO_TRACE_TRIGGER 0xFFFFFFFF /* trigger address that never dumps the instruction trace */
+void Z80_setTraceEnabled(Z80 z, emubool enabled); /* turns the instruction trace on or off */
+void Z80_setTraceTrigger(Z80 z, emuint address); /* sets the address whose next execution dumps the instruction trace */
+void Z80_dumpTrace(Z80 z); /* writes the instruction trace to the log, oldest instruction first */
+#endif
 
 #endif
\ No newline at end of file
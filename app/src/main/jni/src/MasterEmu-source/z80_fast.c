@@ -0,0 +1,24 @@
+/* MasterEmu fast profile Z80 source code file
+   copyright Phil Potter, 2024 */
+
+/* this builds z80.c a second time as the fast profile, giving its public functions the Z80Fast
+   prefix so that both profiles can be linked into the same library - see Z80_selectProfile */
+#define FAST_PROFILE
+#define createZ80 createZ80Fast
+#define destroyZ80 destroyZ80Fast
+#define Z80_executeInstruction Z80Fast_executeInstruction
+#define Z80_run Z80Fast_run
+#define Z80_collectPendingCycles Z80Fast_collectPendingCycles
+#define Z80_memoryWritten Z80Fast_memoryWritten
+#define Z80_memoryMapChanged Z80Fast_memoryMapChanged
+#define Z80_setInterruptLine Z80Fast_setInterruptLine
+#define Z80_raiseNmi Z80Fast_raiseNmi
+#define Z80_getProgramCounter Z80Fast_getProgramCounter
+#define Z80_saveState Z80Fast_saveState
+#define Z80_getMemoryUsage Z80Fast_getMemoryUsage
+#define Z80_resetProfile Z80Fast_resetProfile
+#define Z80_reportProfile Z80Fast_reportProfile
+#define Z80_setTraceEnabled Z80Fast_setTraceEnabled
+#define Z80_setTraceTrigger Z80Fast_setTraceTrigger
+#define Z80_dumpTrace Z80Fast_dumpTrace
+#include "z80.c"
@@ -0,0 +1,18 @@
+/* MasterEmu zexdoc/zexall harness Android logging stub header file
+   copyright Phil Potter, 2024 */
+
+#ifndef ANDROID_LOG_STUB_INCLUDE
+#define ANDROID_LOG_STUB_INCLUDE
+
+/* these mirror the Android log priorities the Z80 code uses */
+#define ANDROID_LOG_VERBOSE 2
+#define ANDROID_LOG_DEBUG 3
+#define ANDROID_LOG_INFO 4
+#define ANDROID_LOG_WARN 5
+#define ANDROID_LOG_ERROR 6
+
+/* function declarations for public use - zex.c sends both of these to stderr */
+int __android_log_print(int prio, const char *tag, const char *fmt, ...);
+int __android_log_write(int prio, const char *tag, const char *text);
+
+#endif
@@ -0,0 +1,332 @@
+/* MasterEmu zexdoc/zexall harness source code file
+   copyright Phil Potter, 2024 */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <android/log.h>
+#include "z80.h"
+#include "console.h"
+
+/* these define the CP/M machine the exercisers run on - a warm boot vector at 0x0000, the BDOS
+   entry point at 0x0005 and a BDOS stub just below the top of memory, which passes its call
+   number and DE register out through the ports below */
+#define ZEX_MEMORY_SIZE 0x10000
+#define ZEX_PROGRAM_START 0x0100
+#define ZEX_BDOS_STUB 0xFE00
+#define ZEX_BDOS_CALL_PORT 0x00
+#define ZEX_BDOS_E_PORT 0x01
+#define ZEX_BDOS_D_PORT 0x02
+#define ZEX_BOOT_PORT 0xFF
+#define ZEX_LINE_SIZE 256
+#define ZEX_RUN_CYCLES 228 /* the Z80 runs in batches of one Master System scanline, as it does in the console */
+
+/* this struct stands in for the console, giving the Z80 a flat 64KB of RAM */
+struct Console {
+    emubyte memory[ZEX_MEMORY_SIZE]; /* the whole address space */
+    emubyte *pages[CONSOLE_PAGE_COUNT]; /* every page is both readable and writable */
+    emubyte d; /* D register latched by the BDOS stub */
+    emubyte e; /* E register latched by the BDOS stub */
+    emubool booted; /* set once the cold boot has gone through the warm boot vector */
+    emubool finished; /* set when the program warm boots or asks to stop */
+    emubool failed; /* set when the program made a BDOS call we don't support */
+    char line[ZEX_LINE_SIZE]; /* the output line being built up */
+    emuint lineLength; /* how many characters of the line are in use */
+    emuint passed; /* how many lines ended in OK */
+    emuint errors; /* how many lines reported an ERROR */
+};
+
+/* these are prototypes for the functions within this file */
+static emubool loadProgram(Console ms, const char *fileName);
+static void bdosCall(Console ms, emubyte function);
+static void printCharacter(Console ms, emubyte character);
+static void finishLine(Console ms);
+static emubool isCpmPort(emuint address);
+
+/* this function runs a CP/M .COM file to completion and reports how it went */
+int main(int argc, char **argv)
+{
+    /* define variables */
+    Console ms;
+    Z80Profile cpu;
+    Z80 z;
+    emubyte *z80Memory;
+    emubool blockCache = false;
+    emubool fastProfile = false;
+    const char *fileName = NULL;
+    emulong cycles = 0;
+    struct timespec start, end;
+    double seconds;
+    emuint i;
+
+    /* check arguments - -b runs the Z80 with its block cache, and -f uses the fast profile */
+    for (i = 1; i < (emuint)argc; ++i) {
+        if (strcmp(argv[i], "-b") == 0)
+            blockCache = true;
+        else if (strcmp(argv[i], "-f") == 0)
+            fastProfile = true;
+        else if (fileName == NULL && argv[i][0] != '-')
+            fileName = argv[i];
+        else
+            break;
+    }
+    if (fileName == NULL || i != (emuint)argc) {
+        fprintf(stderr, "usage: %s [-b] [-f] <program.com>\n", argv[0]);
+        return 2;
+    }
+    Z80_selectProfile(&cpu, fastProfile);
+
+    /* set up the machine */
+    ms = calloc(1, sizeof(struct Console));
+    z80Memory = malloc(cpu.getMemoryUsage());
+    if (ms == NULL || z80Memory == NULL) {
+        fprintf(stderr, "zex: couldn't allocate memory\n");
+        return 2;
+    }
+    for (i = 0; i < CONSOLE_PAGE_COUNT; ++i)
+        ms->pages[i] = ms->memory + (i << CONSOLE_PAGE_SHIFT);
+    if (!loadProgram(ms, fileName))
+        return 2;
+
+    /* the Z80 starts at the warm boot vector, which jumps to the program the first time - it
+       runs through Z80_run like it does in the console, so that repeating block instructions,
+       HALT and idle loops take the same batched paths they do there */
+    z = cpu.create(ms, NULL, blockCache, z80Memory);
+    if (z == NULL) {
+        fprintf(stderr, "zex: couldn't create Z80\n");
+        return 2;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (!ms->finished)
+        cycles += cpu.run(z, ZEX_RUN_CYCLES);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    cpu.destroy(z);
+    finishLine(ms);
+
+    /* report results */
+    seconds = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    fprintf(stderr, "zex: %u passed, %u failed, %llu cycles in %.2f seconds\n",
+            ms->passed, ms->errors, (unsigned long long)cycles, seconds);
+    if (seconds > 0.0)
+        fprintf(stderr, "zex: %.1f emulated MHz\n", (double)cycles / seconds / 1e6);
+    i = !ms->failed && ms->errors == 0 && ms->passed != 0 ? 0 : 1;
+    free(ms);
+    free(z80Memory);
+
+    return i;
+}
+
+/* this function loads the program and builds the CP/M entry points around it */
+static emubool loadProgram(Console ms, const char *fileName)
+{
+    /* define variables */
+    static const emubyte bdosStub[] = {
+        0x7B, 0xD3, ZEX_BDOS_E_PORT,    /* LD A,E / OUT (E port),A */
+        0x7A, 0xD3, ZEX_BDOS_D_PORT,    /* LD A,D / OUT (D port),A */
+        0x79, 0xD3, ZEX_BDOS_CALL_PORT, /* LD A,C / OUT (call port),A */
+        0xC9                            /* RET */
+    };
+    FILE *file;
+    size_t size;
+
+    /* read the program into the transient program area */
+    file = fopen(fileName, "rb");
+    if (file == NULL) {
+        fprintf(stderr, "zex: couldn't open %s\n", fileName);
+        return false;
+    }
+    size = fread(ms->memory + ZEX_PROGRAM_START, 1, ZEX_BDOS_STUB - ZEX_PROGRAM_START, file);
+    fclose(file);
+    if (size == 0) {
+        fprintf(stderr, "zex: %s is empty\n", fileName);
+        return false;
+    }
+
+    /* 0x0000 signals a boot then jumps to the program, and 0x0005 jumps to the BDOS stub -
+       the exercisers take their stack from the address at 0x0006 */
+    ms->memory[0x0000] = 0xD3; /* OUT (boot port),A */
+    ms->memory[0x0001] = ZEX_BOOT_PORT;
+    ms->memory[0x0002] = 0xC3; /* JP program */
+    ms->memory[0x0003] = ZEX_PROGRAM_START & 0xFF;
+    ms->memory[0x0004] = ZEX_PROGRAM_START >> 8;
+    ms->memory[0x0005] = 0xC3; /* JP BDOS stub */
+    ms->memory[0x0006] = ZEX_BDOS_STUB & 0xFF;
+    ms->memory[0x0007] = ZEX_BDOS_STUB >> 8;
+    memcpy(ms->memory + ZEX_BDOS_STUB, bdosStub, sizeof(bdosStub));
+
+    return true;
+}
+
+/* this function carries out the BDOS call the stub has just passed out */
+static void bdosCall(Console ms, emubyte function)
+{
+    /* define variables */
+    emuint address;
+
+    switch (function) {
+        case 0: /* system reset */
+            ms->finished = true;
+            break;
+        case 2: /* console output */
+            printCharacter(ms, ms->e);
+            break;
+        case 9: /* print string */
+            address = (ms->d << 8) | ms->e;
+            while (ms->memory[address] != '$') {
+                printCharacter(ms, ms->memory[address]);
+                address = (address + 1) & (ZEX_MEMORY_SIZE - 1);
+            }
+            break;
+        default:
+            fprintf(stderr, "zex: unsupported BDOS call %u\n", function);
+            ms->failed = true;
+            ms->finished = true;
+            break;
+    }
+}
+
+/* this function echoes a character, keeping track of the line it belongs to */
+static void printCharacter(Console ms, emubyte character)
+{
+    putchar(character);
+    if (character == '\n') {
+        fflush(stdout);
+        finishLine(ms);
+    } else if (character != '\r' && ms->lineLength < ZEX_LINE_SIZE - 1) {
+        ms->line[ms->lineLength++] = (char)character;
+    }
+}
+
+/* this function counts a finished line as a pass or a failure - the exercisers end each
+   passing line with OK, and put ERROR in the line for each failing one */
+static void finishLine(Console ms)
+{
+    /* define variables */
+    emuint length = ms->lineLength;
+
+    ms->line[length] = '\0';
+    while (length > 0 && ms->line[length - 1] == ' ')
+        --length;
+    if (strstr(ms->line, "ERROR") != NULL)
+        ++ms->errors;
+    else if (length >= 2 && strncmp(ms->line + length - 2, "OK", 2) == 0)
+        ++ms->passed;
+    ms->lineLength = 0;
+}
+
+/* this function returns whether a port belongs to the CP/M entry points - no other port has
+   anything attached */
+static emubool isCpmPort(emuint address)
+{
+    switch (address & 0xFF) {
+        case ZEX_BDOS_CALL_PORT:
+        case ZEX_BDOS_E_PORT:
+        case ZEX_BDOS_D_PORT:
+        case ZEX_BOOT_PORT:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/* this function deals with Z80 IO port writes, which only the CP/M entry points make - once the
+   program has finished, the rest of the current run carries on past the end, so anything it
+   does from then on is ignored */
+void console_ioWrite(Console ms, emuint address, emubyte data)
+{
+    if (ms->finished)
+        return;
+
+    switch (address & 0xFF) {
+        case ZEX_BDOS_CALL_PORT: bdosCall(ms, data); break;
+        case ZEX_BDOS_E_PORT: ms->e = data; break;
+        case ZEX_BDOS_D_PORT: ms->d = data; break;
+        case ZEX_BOOT_PORT:
+            if (ms->booted)
+                ms->finished = true;
+            ms->booted = true;
+            break;
+        default: break;
+    }
+}
+
+/* this function deals with Z80 IO port reads, which float high as nothing is attached */
+emubyte console_ioRead(Console ms, emuint address)
+{
+    (void)ms;
+    (void)address;
+    return 0xFF;
+}
+
+/* this function deals with memory space writes the Z80 can't make directly */
+void console_memWrite(Console ms, emuint address, emubyte data)
+{
+    ms->memory[address & (ZEX_MEMORY_SIZE - 1)] = data;
+}
+
+/* this function deals with memory space reads the Z80 can't make directly */
+emubyte console_memRead(Console ms, emuint address)
+{
+    return ms->memory[address & (ZEX_MEMORY_SIZE - 1)];
+}
+
+/* this function returns the table of pages the Z80 can read directly */
+emubyte **console_getReadPages(Console ms)
+{
+    return ms->pages;
+}
+
+/* this function returns the table of pages the Z80 can write directly */
+emubyte **console_getWritePages(Console ms)
+{
+    return ms->pages;
+}
+
+/* this function returns whether repeating block I/O instructions can run without returning -
+   any port without a CP/M entry point behind it can, as nothing is attached */
+emubool console_isBlockIOPort(Console ms, emuint address)
+{
+    (void)ms;
+    return !isCpmPort(address);
+}
+
+/* this function returns whether an idle loop polling this port can be skipped through - every
+   port can, as reads always float high */
+emubool console_isIdlePollPort(Console ms, emuint address)
+{
+    (void)ms;
+    (void)address;
+    return true;
+}
+
+/* this function would tell the signalling device an interrupt was handled, but nothing raises one */
+void console_interruptHandled(Console ms)
+{
+    (void)ms;
+}
+
+/* this function sends formatted log messages from the Z80 code to stderr */
+int __android_log_print(int prio, const char *tag, const char *fmt, ...)
+{
+    /* define variables */
+    va_list args;
+    int written;
+
+    (void)prio;
+    fprintf(stderr, "%s: ", tag);
+    va_start(args, fmt);
+    written = vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+
+    return written;
+}
+
+/* this function sends log messages from the Z80 code to stderr */
+int __android_log_write(int prio, const char *tag, const char *text)
+{
+    (void)prio;
+    return fprintf(stderr, "%s: %s\n", tag, text);
+}